@@ -1,23 +1,51 @@
+#include "logger.h"
 #include "gate_handler.h"
 #include "slot_handler.h"
+#include "rfid_handler.h"
 #include "network_handler.h"
+#include "telemetry.h"
+#include "heap_soak.h"
+#include "system_state.h"
+#include "power.h"
 
+TimerWheel systemTimers;
+EspClock systemClock;
 
+#ifndef RFID_VALIDATION_RPC
+// Apps Script web app (or tools/validation_service) that answers "yes" for a
+// known card UID. There is no usable default; build with e.g.
+// -DGOOGLE_SCRIPT_DEPLOYMENT_URL=\"https://script.google.com/macros/s/<id>/exec\"
+#ifndef GOOGLE_SCRIPT_DEPLOYMENT_URL
+#error "Set GOOGLE_SCRIPT_DEPLOYMENT_URL to the card validation web app, or build with RFID_VALIDATION_RPC"
+#else
+String GOOGLE_SCRIPT_URL = GOOGLE_SCRIPT_DEPLOYMENT_URL;
+#endif
+#endif
 
 void setup() {
   Serial.begin(115200);
-  Serial.println("Booting Smart Parking System...");
+  systemTimers.begin(millis());
+  setupLogger();
+  LOG_INFO(BOOT);
 
+  setupPower();
   setupNetwork();
   setupGate();
+  setupRfid();
   setupSlots();
+  setupTelemetry();
 
-  Serial.println("System Initialized. Ready.");
+  LOG_INFO(SYSTEM_READY);
 }
 
 void loop() {
-  delay(10);
+  systemTimers.advance(millis());
   networkLoop(); 
   handleGate();  
+  handleRfid();
   handleSlots(); 
+#ifdef HEAP_SOAK_TEST
+  runHeapSoakIteration();
+#endif
+  powerIdle(gatesBusy());
 }
\ No newline at end of file
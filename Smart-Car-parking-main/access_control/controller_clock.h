@@ -0,0 +1,27 @@
+#ifndef CONTROLLER_CLOCK_H
+#define CONTROLLER_CLOCK_H
+
+#include <stdint.h>
+
+// The time sources a controller reads besides its timer wheel, whose now() is
+// its millisecond clock. The firmware passes one EspClock (trace.h) to every
+// module; a host simulator passes its own, which many controllers can share.
+class ControllerClock {
+ public:
+  virtual ~ControllerClock() {}
+
+  // Monotonic microseconds, the timebase of sensor edge timestamps
+  // (esp_timer_get_time() on the ESP32).
+  virtual int64_t monotonicUs() = 0;
+
+  // Trace time (see trace.h): now, and that of an earlier monotonicUs() value.
+  virtual int64_t traceNowUs() = 0;
+  virtual int64_t traceFromMonotonicUs(int64_t monotonicUs) = 0;
+  virtual bool isTraceSynced() = 0;
+
+  // A free-running cycle counter for timing short sections, and its rate.
+  virtual uint32_t cycleCount() = 0;
+  virtual uint32_t cyclesPerUs() = 0;
+};
+
+#endif
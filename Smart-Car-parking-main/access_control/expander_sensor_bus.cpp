@@ -0,0 +1,112 @@
+#include "expander_sensor_bus.h"
+#include "power.h"
+
+// --- MCP23017 Registers (IOCON.BANK = 0, A/B pairs interleaved) ---
+const uint8_t MCP_IODIRA = 0x00;
+const uint8_t MCP_IPOLA = 0x02;
+const uint8_t MCP_GPINTENA = 0x04;
+const uint8_t MCP_INTCONA = 0x08;
+const uint8_t MCP_IOCON = 0x0A;
+const uint8_t MCP_GPIOA = 0x12;
+
+const uint8_t MCP_IOCON_MIRROR = 0x40; // INTA and INTB both report either port
+const uint8_t MCP_IOCON_ODR = 0x04;    // Open-drain INT, so lines can be wired together
+
+// --- Constants ---
+// Re-read every expander now and then, in case a change was lost (e.g. a
+// glitch on a shared INT line).
+const TimeMs EXPANDER_RESYNC_INTERVAL = 1000;
+
+ExpanderSensorBus::ExpanderSensorBus(I2cBus& i2c, const ExpanderConfig* expanders, int count)
+    : i2c(i2c), expanders(expanders), count(count < MAX_EXPANDERS ? count : MAX_EXPANDERS),
+      intPinCount(0), failedLines(0), resyncDue(true), lastResync(0), reads(0), errors(0) {}
+
+void ExpanderSensorBus::begin() {
+  for (int i = 0; i < count; i++) {
+    uint8_t address = expanders[i].address;
+    // Both writes hit IOCONA; the B copy mirrors it.
+    i2c.writeRegister(address, MCP_IOCON, MCP_IOCON_MIRROR | MCP_IOCON_ODR);
+    const uint8_t setup[][2] = {
+      { MCP_IODIRA, 0xFF },   // All inputs
+      { MCP_IPOLA, 0xFF },    // Inverted: an occupied (LOW) sensor reads as 1
+      { MCP_GPINTENA, 0xFF }, // Interrupt on any change...
+      { MCP_INTCONA, 0x00 },  // ...compared with the previous value
+    };
+    for (size_t r = 0; r < sizeof(setup) / sizeof(setup[0]); r++) {
+      i2c.writeRegister(address, setup[r][0], setup[r][1]);
+      i2c.writeRegister(address, setup[r][0] + 1, setup[r][1]); // Port B
+    }
+
+    // Collect the distinct INT lines.
+    expanderLine[i] = -1;
+    int pin = expanders[i].intPin;
+    if (pin < 0) {
+      continue;
+    }
+    for (int line = 0; line < intPinCount; line++) {
+      if (intPins[line] == pin) {
+        expanderLine[i] = line;
+      }
+    }
+    if (expanderLine[i] < 0 && intPinCount < MAX_INT_PINS) {
+      expanderLine[i] = intPinCount;
+      intPins[intPinCount] = pin;
+      pinMode(pin, INPUT_PULLUP); // No effect on GPIO34-39, which need an external pull-up
+      registerWakeLine(pin);
+      intPinCount++;
+    }
+  }
+}
+
+// Reading GPIOA/GPIOB also clears the expander's interrupt.
+bool ExpanderSensorBus::readExpander(int expander, OccupancyBits& occupied) {
+  uint8_t* ports = occupied.bytes() + expanders[expander].firstSlot / 8;
+  reads++;
+  if (!i2c.readRegisters(expanders[expander].address, MCP_GPIOA, ports, 2)) {
+    errors++;
+    return false;
+  }
+  return true;
+}
+
+// Bit per INT line that is low, i.e. has an expander with a change to read.
+uint32_t ExpanderSensorBus::assertedLines() const {
+  uint32_t asserted = 0;
+  for (int line = 0; line < intPinCount; line++) {
+    if (digitalRead(intPins[line]) == LOW) {
+      asserted |= 1UL << line;
+    }
+  }
+  return asserted;
+}
+
+bool ExpanderSensorBus::hasPendingChange() const {
+  return (assertedLines() & ~failedLines) != 0;
+}
+
+void ExpanderSensorBus::markSensed(OccupancyBits& sensed) const {
+  for (int i = 0; i < count; i++) {
+    memset(sensed.bytes() + expanders[i].firstSlot / 8, 0xFF, 2); // Both ports
+  }
+}
+
+void ExpanderSensorBus::sample(OccupancyBits& occupied) {
+  TimeMs now = millis();
+  if (timeElapsed(now, lastResync) >= EXPANDER_RESYNC_INTERVAL) {
+    resyncDue = true;
+    failedLines = 0;
+  }
+  uint32_t asserted = assertedLines() & ~failedLines;
+
+  for (int i = 0; i < count; i++) {
+    int line = expanderLine[i];
+    bool due = resyncDue || line < 0 || (asserted & (1UL << line));
+    if (due && !readExpander(i, occupied) && line >= 0) {
+      failedLines |= 1UL << line; // The line stays low: leave it for the resync rather than retrying every pass
+    }
+  }
+  if (resyncDue) {
+    resyncDue = false;
+    lastResync = now;
+  }
+}
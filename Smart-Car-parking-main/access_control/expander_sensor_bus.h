@@ -0,0 +1,64 @@
+#ifndef EXPANDER_SENSOR_BUS_H
+#define EXPANDER_SENSOR_BUS_H
+
+#include <Arduino.h>
+#include "slot_sensor_bus.h"
+#include "i2c_bus.h"
+#include "timer_wheel.h"
+
+// One MCP23017 on the bus: 16 sensors on slots firstSlot..firstSlot + 15.
+struct ExpanderConfig {
+  uint8_t address;  // 0x20..0x27
+  int intPin;       // ESP32 pin its INTA line is wired to (may be shared); -1 to poll it.
+                    // GPIO34-39 have no internal pull-up: fit a 10k to 3.3 V on the line
+  int firstSlot;    // Must be a multiple of 8
+};
+
+// MCP23017-class 16-bit I2C expanders on one I2C bus. Each expander pulls
+// its open-drain INT line low when any input changes, and only expanders
+// whose line is low are read, each in one two-byte transaction straight into
+// the occupancy bytes. Several expanders can share a line; all of them are
+// read while it is low. Sensors are LOW while occupied; the expander inverts
+// them.
+//
+// A line stays low until its expanders are read, so the bus checks the
+// level instead of catching edges: nothing is lost between passes, and the
+// lines are free to serve as wake lines for light sleep (see power.h).
+class ExpanderSensorBus : public SlotSensorBus {
+ public:
+  static const int MAX_EXPANDERS = 8;  // One per address on a bus
+  static const int MAX_INT_PINS = 8;
+
+  // The config array must outlive the bus.
+  ExpanderSensorBus(I2cBus& i2c, const ExpanderConfig* expanders, int count);
+
+  const char* name() const { return "mcp23017"; }
+  void begin();
+  int sensorCount() const { return count * 16; }
+  void sample(OccupancyBits& occupied);
+  void markSensed(OccupancyBits& sensed) const;
+  bool hasPendingChange() const;
+
+  uint32_t expanderReads() const { return reads; }
+  uint32_t readErrors() const { return errors; }
+
+ private:
+  uint32_t assertedLines() const;
+  bool readExpander(int expander, OccupancyBits& occupied);
+
+  I2cBus& i2c;
+  const ExpanderConfig* expanders;
+  int count;
+
+  int intPins[MAX_INT_PINS];          // Distinct INT lines in use
+  int intPinCount;
+  int expanderLine[MAX_EXPANDERS];    // Index into intPins, or -1 if polled
+  uint32_t failedLines;               // Bit per line whose read failed: left for the resync
+
+  bool resyncDue;
+  TimeMs lastResync;
+  uint32_t reads;
+  uint32_t errors;
+};
+
+#endif
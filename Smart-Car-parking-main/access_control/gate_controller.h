@@ -0,0 +1,69 @@
+#ifndef GATE_CONTROLLER_H
+#define GATE_CONTROLLER_H
+
+#include <string.h>
+#include "gate_lane.h"
+
+// Runs LANES barriers from one loop. The lanes are a fixed array sized at
+// compile time, so nothing is allocated per lane; the configs and hardware
+// must outlive the controller (normally tables at file scope).
+template <size_t LANES>
+class GateController {
+ public:
+  static const int NO_LANE = -1;
+
+  // Lane i is driven through hardware[i], on 'timers'.
+  void begin(const LaneConfig (&configs)[LANES], LaneHardware* const (&hardware)[LANES], TimerWheel& timers) {
+    for (size_t i = 0; i < LANES; i++) {
+      lanes[i].begin(configs[i], *hardware[i], timers);
+    }
+  }
+
+  // Polls every lane's passage sensor. Non-blocking.
+  void update() {
+    for (size_t i = 0; i < LANES; i++) {
+      lanes[i].update();
+    }
+  }
+
+  // Returns false if there is no such lane.
+  bool open(int lane) {
+    if (lane < 0 || lane >= (int)LANES) {
+      return false;
+    }
+    lanes[lane].open();
+    return true;
+  }
+
+  bool isOpen(int lane) const {
+    return lane >= 0 && lane < (int)LANES && lanes[lane].isOpen();
+  }
+
+  bool anyOpen() const {
+    for (size_t i = 0; i < LANES; i++) {
+      if (lanes[i].isOpen()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Looks a lane up by its configured name; NO_LANE if none matches.
+  int findLane(const char* name) const {
+    for (size_t i = 0; i < LANES; i++) {
+      if (strcasecmp(lanes[i].name(), name) == 0) {
+        return (int)i;
+      }
+    }
+    return NO_LANE;
+  }
+
+  GateLane& lane(int index) { return lanes[index]; }
+  const GateLane& lane(int index) const { return lanes[index]; }
+  size_t laneCount() const { return LANES; }
+
+ private:
+  GateLane lanes[LANES];
+};
+
+#endif
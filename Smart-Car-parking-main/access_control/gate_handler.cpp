@@ -1,45 +1,84 @@
 #include <Arduino.h>
-#include <ESP32Servo.h>
 #include "gate_handler.h"
+#include "gate_controller.h"
+#include "servo_lane.h"
+#include "system_state.h"
 
-// --- Pin Definitions ---
-#define SERVO_PIN 12
-
-// --- Constants ---
-const long GATE_OPEN_DURATION = 5000; // Keep gate open for 5 seconds
-const int GATE_CLOSED_ANGLE = 0;
-const int GATE_OPEN_ANGLE = 90;
+// --- Lane Definitions ---
+// Passage sensors are IR beams or loop detectors just past each barrier,
+// active low: open-collector outputs that pull the pin LOW while a vehicle is
+// in them, against the internal pull-up. The board ships without them, so
+// passageSensorPin is -1 and the gate closes on the timer; fit a sensor and
+// set its pin (e.g. 14 for the entry lane) to close as soon as the car is through.
+static const LaneConfig GATE_LANES[GATE_LANE_COUNT] = {
+  { "entry",
+    12,  // servoPin
+    -1,  // passageSensorPin: none fitted (14 when one is)
+    0,   // closedAngle
+    90,  // openAngle
+    { 90,     // maxSpeed: deg/s, so the 90 degree swing takes about 1.5 s
+      180 },  // acceleration: deg/s^2, half a second to full speed
+    { 1500,    // minOpenMs: let the arm finish rising before it may fall again
+      800,     // clearMarginMs: close this long after the vehicle clears the beam
+      5000,    // maxOpenMs: the old fixed duration, now the first vehicle's window
+      30000,   // beamFaultMs: beam blocked longer than this is treated as stuck
+      3000,    // perVehicleMs: extra window for each vehicle queued behind the first
+      1500,    // coalesceMs: an RFID grant and a remote OPEN this close are one car
+      15000 }  // maxWindowMs: cap on the waiting window however long the queue gets
+  },
+#ifdef GATE_EXIT_LANE
+  { "exit",
+    13,  // servoPin
+    -1,  // passageSensorPin: none fitted (4 when one is)
+    0,   // closedAngle
+    90,  // openAngle
+    { 90, 180 },
+    { 1500, 800, 5000, 30000, 3000, 1500, 15000 }
+  },
+#endif
+};
 
 // --- Module-specific (static) Variables ---
-static Servo gateServo;
-static unsigned long gateOpenTimer = 0;
-static bool isGateOpen = false;
+static ServoLane servoLanes[GATE_LANE_COUNT];
+static LaneHardware* const LANE_HARDWARE[GATE_LANE_COUNT] = {
+  &servoLanes[GATE_LANE_ENTRY],
+#ifdef GATE_EXIT_LANE
+  &servoLanes[GATE_LANE_EXIT],
+#endif
+};
+static GateController<GATE_LANE_COUNT> gates;
 
-// Initializes the servo motor.
 void setupGate() {
-  gateServo.attach(SERVO_PIN);
-  gateServo.write(GATE_CLOSED_ANGLE); // Ensure gate is closed on startup
+  gates.begin(GATE_LANES, LANE_HARDWARE, systemTimers);
 }
 
-// Opens the gate and starts the non-blocking timer.
-void openGate() {
-  Serial.println("Gate Handler: Opening gate.");
-  gateServo.write(GATE_OPEN_ANGLE);
-  isGateOpen = true;
-  gateOpenTimer = millis(); // Start the timer!
+bool openGate(int lane) {
+  return gates.open(lane);
 }
 
-// This function is called continuously from the main loop().
-void handleGate() {
-  // If the gate isn't open, there's nothing to do.
-  if (!isGateOpen) {
-    return;
-  }
+int findGateLane(const char* name) {
+  return gates.findLane(name);
+}
 
-  // Check if the timer has expired.
-  if (millis() - gateOpenTimer > GATE_OPEN_DURATION) {
-    Serial.println("Gate Handler: Timer expired. Closing gate.");
-    gateServo.write(GATE_CLOSED_ANGLE);
-    isGateOpen = false;
+const char* getGateLaneName(int lane) {
+  if (lane < 0 || lane >= GATE_LANE_COUNT) {
+    return "";
   }
-}
\ No newline at end of file
+  return GATE_LANES[lane].name;
+}
+
+bool gateIsOpen(int lane) {
+  return gates.isOpen(lane);
+}
+
+bool gatesBusy() {
+  return gates.anyOpen() || ServoMotion::poweredServos() > 0;
+}
+
+void handleGate() {
+  gates.update();
+}
+
+GateStats getGateStats(int lane) {
+  return gates.lane(lane).stats();
+}
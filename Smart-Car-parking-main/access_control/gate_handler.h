@@ -1,14 +1,45 @@
 #ifndef GATE_HANDLER_H
 #define GATE_HANDLER_H
 
-// Initializes the servo motor and sets its starting position.
+#include <Arduino.h>
+#include "gate_lane.h"
+
+// The barriers this controller drives. Commands and RFID grants name one of
+// these; GATE_LANE_COUNT sizes the controller. The board ships with the entry
+// barrier only; build with -DGATE_EXIT_LANE once the exit servo (GPIO13) is
+// fitted.
+enum GateLaneId {
+  GATE_LANE_ENTRY,
+#ifdef GATE_EXIT_LANE
+  GATE_LANE_EXIT,
+#endif
+  GATE_LANE_COUNT
+};
+
+// Initializes every lane's servo and sets it to the closed position.
 void setupGate();
 
-// Opens the gate and starts the auto-close timer.
-void openGate();
+// Opens a lane's gate and starts its auto-close timer. If the gate is already
+// open the entry is queued and the window extended instead of cycling the arm;
+// duplicate requests for the same vehicle are merged. Returns false for an
+// unknown lane.
+bool openGate(int lane = GATE_LANE_ENTRY);
+
+// Maps a lane name from a command ("entry", "exit") to its index, or -1.
+int findGateLane(const char* name);
+const char* getGateLaneName(int lane);
 
-// Checks the timer and closes the gate if needed.
-// This function is non-blocking and safe to call in the main loop.
+// Watches the passage sensors so each gate can close as soon as its vehicles
+// have passed. This function is non-blocking and safe to call in the main loop.
 void handleGate();
 
-#endif
\ No newline at end of file
+// Returns true while the lane's barrier is up.
+bool gateIsOpen(int lane = GATE_LANE_ENTRY);
+
+// True while any barrier is up or any servo is still driven: the loop must
+// keep watching the beams and the servo PWM must keep running.
+bool gatesBusy();
+
+GateStats getGateStats(int lane);
+
+#endif
@@ -0,0 +1,100 @@
+#include "gate_lane.h"
+#include "logger.h"
+#include "heap_tracker.h"
+
+GateLane::GateLane()
+    : config(NULL), hardware(NULL), timers(NULL), policy(GateTiming()), deadlineTimer(onDeadline, this),
+      beamBlocked(false) {}
+
+void GateLane::begin(const LaneConfig& laneConfig, LaneHardware& laneHardware, TimerWheel& timerWheel) {
+  config = &laneConfig;
+  hardware = &laneHardware;
+  timers = &timerWheel;
+  policy = GatePolicy(config->timing);
+  hardware->begin(*config, *timers); // Barrier down on startup
+}
+
+// Starts the barrier moving for whatever the policy decided, then re-arms the deadline.
+void GateLane::apply(GatePolicy::Action action) {
+  switch (action) {
+    case GatePolicy::OPEN_BARRIER:
+      LOG_INFO(GATE_LANE_OPENING, config->name);
+      hardware->moveBarrier(config->openAngle);
+      break;
+    case GatePolicy::CLOSE_PASSED:
+      LOG_INFO(GATE_LANE_CLOSING_PASSED, config->name);
+      hardware->moveBarrier(config->closedAngle);
+      break;
+    case GatePolicy::CLOSE_TIMEOUT:
+      LOG_INFO(GATE_LANE_TIMER_CLOSING, config->name);
+      hardware->moveBarrier(config->closedAngle);
+      break;
+    case GatePolicy::CLOSE_FAULT:
+      LOG_ERROR(GATE_LANE_BEAM_FAULT, config->name, config->timing.beamFaultMs);
+      hardware->moveBarrier(config->closedAngle);
+      break;
+    default:
+      break;
+  }
+
+  if (!policy.isOpen()) {
+    // The sensor is not polled while closed. Start the next cycle from a clear
+    // beam, so a car still in it after a fault close is seen as blocked.
+    beamBlocked = false;
+  }
+
+  if (policy.hasDeadline()) {
+    // A deadline that is already due (e.g. the upper bound passed while a car
+    // was in the beam) must fire on the next tick, not wrap to 49 days.
+    int32_t remaining = (int32_t)(policy.deadline() - timers->now());
+    timers->arm(deadlineTimer, remaining > 0 ? remaining : 0);
+  } else {
+    timers->cancel(deadlineTimer);
+  }
+}
+
+// Called by the timer wheel when the policy's next deadline comes up.
+void GateLane::onDeadline(void* context) {
+  HeapScope heapScope(HEAP_MODULE_GATE);
+  GateLane* lane = static_cast<GateLane*>(context);
+  lane->apply(lane->policy.deadlineReached(lane->timers->now()));
+}
+
+void GateLane::open() {
+  uint8_t queuedBefore = policy.queuedEntries();
+  uint32_t overflowsBefore = policy.overflowCount();
+  GatePolicy::Action action = policy.requestOpen(timers->now());
+  if (action == GatePolicy::NO_ACTION && policy.queuedEntries() > queuedBefore) {
+    LOG_INFO(GATE_LANE_ENTRY_QUEUED, config->name, (unsigned)policy.queuedEntries());
+  } else if (policy.overflowCount() != overflowsBefore) {
+    LOG_WARN(GATE_QUEUE_FULL, config->name, (unsigned)GatePolicy::MAX_QUEUE);
+  }
+  apply(action);
+}
+
+void GateLane::update() {
+  if (config == NULL || config->passageSensorPin < 0 || !policy.isOpen()) {
+    return;
+  }
+  bool blocked = hardware->beamBlocked();
+  if (blocked == beamBlocked) {
+    return;
+  }
+  HeapScope heapScope(HEAP_MODULE_GATE);
+  beamBlocked = blocked;
+  apply(policy.beamChanged(timers->now(), blocked));
+}
+
+GateStats GateLane::stats() const {
+  GateStats stats;
+  stats.cycles = policy.cycleCount();
+  stats.vehicles = policy.vehicleCount();
+  stats.vehiclesLastMinute = policy.vehiclesInLastMinute(timers->now());
+  stats.averageCycleMs = policy.averageCycleMs();
+  stats.entries = policy.entryCount();
+  stats.maxEntriesPerCycle = policy.maxEntriesInCycle();
+  stats.coalesced = policy.coalescedCount();
+  stats.noShows = policy.noShowCount();
+  stats.queueOverflows = policy.overflowCount();
+  return stats;
+}
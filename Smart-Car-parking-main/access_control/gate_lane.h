@@ -0,0 +1,82 @@
+#ifndef GATE_LANE_H
+#define GATE_LANE_H
+
+#include "gate_policy.h"
+#include "motion_profile.h"
+
+// Wiring and timing of one barrier.
+struct LaneConfig {
+  const char* name;      // Used in commands, logs and telemetry, e.g. "entry"
+  int servoPin;
+  int passageSensorPin;  // LOW while a vehicle is in the beam; -1 if the lane has none
+  int closedAngle;
+  int openAngle;
+  MotionLimits motion;   // How fast the arm may swing and accelerate
+  GateTiming timing;
+};
+
+// Lane throughput figures for telemetry.
+struct GateStats {
+  uint32_t cycles;             // Open/close cycles since boot
+  uint32_t vehicles;           // Vehicles seen passing since boot
+  uint32_t vehiclesLastMinute;
+  uint32_t averageCycleMs;     // Average time from opening to closing
+  uint32_t entries;            // Validated entries served since boot
+  uint32_t maxEntriesPerCycle;
+  uint32_t coalesced;          // Duplicate open requests merged into one entry
+  uint32_t noShows;            // Queued entries that never reached the beam
+  uint32_t queueOverflows;     // Open requests dropped because the queue was full
+};
+
+// The barrier and passage sensor of one lane. On the controller that is a
+// servo and a GPIO (ServoLane); the fleet simulator supplies a stand-in.
+class LaneHardware {
+ public:
+  virtual ~LaneHardware() {}
+
+  // Sets up the servo and sensor from the config and puts the barrier down.
+  virtual void begin(const LaneConfig& config, TimerWheel& timers) = 0;
+
+  // Starts the barrier moving; returns at once.
+  virtual void moveBarrier(float angle) = 0;
+
+  // Only called for lanes that have a passage sensor.
+  virtual bool beamBlocked() = 0;
+};
+
+// One barrier: its policy and deadline timer, driving the lane's hardware on
+// the timer wheel it was given. Lanes live in a GateController's fixed array,
+// so they are default-constructed and configured afterwards with begin().
+class GateLane {
+ public:
+  GateLane();
+
+  // The config and hardware must outlive the lane.
+  void begin(const LaneConfig& config, LaneHardware& hardware, TimerWheel& timers);
+
+  // Opens the barrier, or queues one more entry if it is already up.
+  void open();
+
+  // Polls the passage sensor. Non-blocking; call every loop pass.
+  void update();
+
+  bool isOpen() const { return policy.isOpen(); }
+  const char* name() const { return config ? config->name : ""; }
+  GateStats stats() const;
+
+ private:
+  GateLane(const GateLane&);            // Linked into the timer wheel: not copyable
+  GateLane& operator=(const GateLane&);
+
+  static void onDeadline(void* context);
+  void apply(GatePolicy::Action action);
+
+  const LaneConfig* config;
+  LaneHardware* hardware;
+  TimerWheel* timers;
+  GatePolicy policy;
+  Timer deadlineTimer;
+  bool beamBlocked;
+};
+
+#endif
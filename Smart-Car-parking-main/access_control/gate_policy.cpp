@@ -0,0 +1,157 @@
+#include "gate_policy.h"
+
+const TimeMs ONE_MINUTE = 60000;
+
+GatePolicy::GatePolicy(const GateTiming& timing)
+    : timing(timing), currentState(CLOSED), openedAt(0), windowStart(0), allowance(0),
+      lastRequestAt(0), blockedAt(0), clearedAt(0), pending(0), cycleEntries(0),
+      cycles(0), vehicles(0), entries(0), coalesced(0), noShows(0), overflows(0), maxCycleEntries(0),
+      totalCycleMs(0), passageNext(0) {
+  for (int i = 0; i < PASSAGE_HISTORY; i++) {
+    passages[i] = 0;
+  }
+}
+
+void GatePolicy::extendWindow(TimeMs extraMs) {
+  allowance += extraMs;
+  if (allowance > timing.maxWindowMs) {
+    allowance = timing.maxWindowMs;
+  }
+}
+
+GatePolicy::Action GatePolicy::requestOpen(TimeMs now) {
+  if (currentState == CLOSED) {
+    currentState = OPEN_WAITING;
+    openedAt = now;
+    windowStart = now;
+    allowance = timing.maxOpenMs;
+    lastRequestAt = now;
+    pending = 1;
+    cycleEntries = 1;
+    entries++;
+    return OPEN_BARRIER;
+  }
+
+  // An RFID grant and a remote OPEN for the same car land within moments of
+  // each other; count them once.
+  if (timeElapsed(now, lastRequestAt) < timing.coalesceMs) {
+    lastRequestAt = now;
+    coalesced++;
+    return NO_ACTION;
+  }
+  lastRequestAt = now;
+  if (pending >= MAX_QUEUE) {
+    overflows++; // The caller reports it; this class has no logger
+    return NO_ACTION;
+  }
+  pending++;
+  cycleEntries++;
+  entries++;
+
+  if (currentState == CLEARING) {
+    // The arm was about to come down; wait for this vehicle instead.
+    currentState = OPEN_WAITING;
+    windowStart = now;
+    allowance = timing.maxOpenMs;
+  } else {
+    extendWindow(timing.perVehicleMs);
+  }
+  return NO_ACTION;
+}
+
+GatePolicy::Action GatePolicy::beamChanged(TimeMs now, bool blocked) {
+  if (currentState == CLOSED) {
+    return NO_ACTION; // Someone walking past a closed barrier
+  }
+  if (blocked) {
+    currentState = VEHICLE_IN_BEAM;
+    blockedAt = now;
+    return NO_ACTION;
+  }
+  if (currentState != VEHICLE_IN_BEAM) {
+    return NO_ACTION;
+  }
+
+  vehicles++;
+  passages[passageNext] = now;
+  passageNext = (passageNext + 1) % PASSAGE_HISTORY;
+  if (pending > 0) {
+    pending--;
+  }
+
+  if (pending > 0) {
+    // Next queued car is right behind; give it its own short window.
+    currentState = OPEN_WAITING;
+    windowStart = now;
+    allowance = 0;
+    extendWindow(timing.perVehicleMs * pending);
+  } else {
+    currentState = CLEARING;
+    clearedAt = now;
+  }
+  return NO_ACTION;
+}
+
+TimeMs GatePolicy::deadline() const {
+  switch (currentState) {
+    case VEHICLE_IN_BEAM:
+      return blockedAt + timing.beamFaultMs;
+    case CLEARING: {
+      TimeMs passed = clearedAt + timing.clearMarginMs;
+      TimeMs minOpen = openedAt + timing.minOpenMs;
+      return timeReached(passed, minOpen) ? passed : minOpen;
+    }
+    default:
+      return windowEnd();
+  }
+}
+
+GatePolicy::Action GatePolicy::deadlineReached(TimeMs now) {
+  switch (currentState) {
+    case VEHICLE_IN_BEAM:
+      // Never bring the arm down on a car, unless the sensor looks stuck.
+      if (timeReached(now, blockedAt + timing.beamFaultMs)) {
+        return close(now, CLOSE_FAULT);
+      }
+      return NO_ACTION;
+    case CLEARING:
+      if (timeReached(now, deadline())) {
+        return close(now, CLOSE_PASSED);
+      }
+      return NO_ACTION;
+    case OPEN_WAITING:
+      if (timeReached(now, windowEnd())) {
+        return close(now, CLOSE_TIMEOUT);
+      }
+      return NO_ACTION;
+    default:
+      return NO_ACTION;
+  }
+}
+
+GatePolicy::Action GatePolicy::close(TimeMs now, Action reason) {
+  // Without a passage sensor every timeout is the normal way to close, so
+  // only count entries as no-shows once the sensor has proven it works.
+  if (reason == CLOSE_TIMEOUT && vehicles > 0) {
+    noShows += pending;
+  }
+  currentState = CLOSED;
+  pending = 0;
+  cycles++;
+  totalCycleMs += timeElapsed(now, openedAt);
+  if (cycleEntries > maxCycleEntries) {
+    maxCycleEntries = cycleEntries;
+  }
+  return reason;
+}
+
+uint32_t GatePolicy::vehiclesInLastMinute(TimeMs now) const {
+  uint32_t count = 0;
+  int recorded = vehicles < (uint32_t)PASSAGE_HISTORY ? vehicles : PASSAGE_HISTORY;
+  for (int i = 0; i < recorded; i++) {
+    if (timeElapsed(now, passages[i]) < ONE_MINUTE) {
+      count++;
+    }
+  }
+  return count;
+}
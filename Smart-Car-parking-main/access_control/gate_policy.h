@@ -0,0 +1,101 @@
+#ifndef GATE_POLICY_H
+#define GATE_POLICY_H
+
+#include "timer_wheel.h"
+
+// Timing limits for one barrier. All durations are in milliseconds.
+struct GateTiming {
+  TimeMs minOpenMs;      // Never close sooner than this after opening
+  TimeMs clearMarginMs;  // Wait this long after the last vehicle clears the beam
+  TimeMs maxOpenMs;      // Time the first vehicle gets to reach the beam
+  TimeMs beamFaultMs;    // Beam blocked this long means a stuck sensor: close anyway
+  TimeMs perVehicleMs;   // Extra time for each further vehicle in the queue
+  TimeMs coalesceMs;     // Open requests this close together are the same vehicle
+  TimeMs maxWindowMs;    // Upper bound on any one waiting window, however long the queue
+};
+
+// Decides when one barrier opens and closes. It knows nothing about servos or
+// pins: the gate handler feeds it open requests, passage sensor changes and
+// expired deadlines, and carries out the action it returns. Without a passage
+// sensor it never sees a vehicle and simply closes when the window runs out.
+//
+// Open requests that arrive while the barrier is up are queued as further
+// entries instead of cycling the arm: each one extends the window, and with a
+// passage sensor the arm stays up until every queued vehicle has gone through.
+class GatePolicy {
+ public:
+  static const uint8_t MAX_QUEUE = 8; // Entries one open cycle can hold
+
+  enum State {
+    CLOSED,
+    OPEN_WAITING,    // Open, waiting for the next queued vehicle
+    VEHICLE_IN_BEAM,
+    CLEARING         // Last queued vehicle left the beam; margin running
+  };
+
+  enum Action {
+    NO_ACTION,
+    OPEN_BARRIER,
+    CLOSE_PASSED,   // Every queued vehicle went through
+    CLOSE_TIMEOUT,  // A queued vehicle never arrived
+    CLOSE_FAULT     // Beam blocked for beamFaultMs; sensor likely stuck
+  };
+
+  explicit GatePolicy(const GateTiming& timing);
+
+  Action requestOpen(TimeMs now);
+  Action beamChanged(TimeMs now, bool blocked);
+
+  // Call when deadline() has been reached.
+  Action deadlineReached(TimeMs now);
+
+  // Next time deadlineReached() must run; only meaningful while open.
+  bool hasDeadline() const { return currentState != CLOSED; }
+  TimeMs deadline() const;
+
+  State state() const { return currentState; }
+  bool isOpen() const { return currentState != CLOSED; }
+  uint8_t queuedEntries() const { return pending; }
+
+  // --- Statistics ---
+  uint32_t cycleCount() const { return cycles; }
+  uint32_t vehicleCount() const { return vehicles; }
+  uint32_t entryCount() const { return entries; }
+  uint32_t coalescedCount() const { return coalesced; }
+  uint32_t noShowCount() const { return noShows; }
+  uint32_t overflowCount() const { return overflows; } // Requests dropped on a full queue
+  uint8_t maxEntriesInCycle() const { return maxCycleEntries; }
+  uint32_t averageCycleMs() const { return cycles ? (uint32_t)(totalCycleMs / cycles) : 0; }
+  uint32_t vehiclesInLastMinute(TimeMs now) const;
+
+ private:
+  Action close(TimeMs now, Action reason);
+  TimeMs windowEnd() const { return windowStart + allowance; }
+  void extendWindow(TimeMs extraMs);
+
+  static const int PASSAGE_HISTORY = 64; // Enough for one lane's busiest minute
+
+  GateTiming timing;
+  State currentState;
+  TimeMs openedAt;     // Start of this open cycle
+  TimeMs windowStart;  // Start of the wait for the next vehicle
+  TimeMs allowance;    // Length of that wait
+  TimeMs lastRequestAt;
+  TimeMs blockedAt;
+  TimeMs clearedAt;
+  uint8_t pending;     // Validated entries that have not passed yet
+  uint8_t cycleEntries;
+
+  uint32_t cycles;
+  uint32_t vehicles;
+  uint32_t entries;
+  uint32_t coalesced;
+  uint32_t noShows;
+  uint32_t overflows;
+  uint8_t maxCycleEntries;
+  uint64_t totalCycleMs;
+  TimeMs passages[PASSAGE_HISTORY];
+  uint8_t passageNext;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "gpio_sensor_bus.h"
+#include "power.h"
+#include <esp_timer.h>
+#include <soc/gpio_reg.h>
+
+const int GPIO_INPUT_PINS = 40; // GPIO_IN covers 0-31, GPIO_IN1 32-39
+
+GpioSensorBus::GpioSensorBus(const int* pins, const int* slots, int count)
+    : pins(pins), slots(slots), count(count < MAX_SENSORS ? count : MAX_SENSORS),
+      snapshotCapable(false), snapshot(false), changePending(false) {
+  portMUX_TYPE unlocked = portMUX_INITIALIZER_UNLOCKED;
+  edgeMux = unlocked;
+  for (int i = 0; i < MAX_SENSORS; i++) {
+    pendingEdgeUs[i] = 0;
+    sampledEdgeUs[i] = 0;
+  }
+}
+
+// Records the time of the first GPIO edge since the last sample, so a trace
+// can start at the edge rather than at the next poll. Later edges (bounces)
+// leave it alone until sample() has taken it.
+void IRAM_ATTR GpioSensorBus::onEdge(void* arg) {
+  EdgeContext* context = static_cast<EdgeContext*>(arg);
+  GpioSensorBus* bus = context->bus;
+  portENTER_CRITICAL_ISR(&bus->edgeMux);
+  if (bus->pendingEdgeUs[context->sensor] == 0) {
+    bus->pendingEdgeUs[context->sensor] = esp_timer_get_time();
+  }
+  bus->changePending = true;
+  portEXIT_CRITICAL_ISR(&bus->edgeMux);
+  wakeLoopFromISR();
+}
+
+void GpioSensorBus::begin() {
+  for (int i = 0; i < count; i++) {
+    pinMode(pins[i], INPUT);
+    contexts[i].bus = this;
+    contexts[i].sensor = i;
+    attachInterruptArg(pins[i], onEdge, &contexts[i], CHANGE);
+  }
+
+  snapshotCapable = true;
+  for (int i = 0; i < count; i++) {
+    if (pins[i] < 0 || pins[i] >= GPIO_INPUT_PINS) {
+      snapshotCapable = false; // Not a plain GPIO; leave it to digitalRead()
+      break;
+    }
+    masks[i].word = pins[i] >> 5;
+    masks[i].mask = 1UL << (pins[i] & 31);
+  }
+  snapshot = snapshotCapable;
+}
+
+void GpioSensorBus::sample(OccupancyBits& occupied) {
+  // Take the latched edges before reading, so an edge during the read stays
+  // pending (and flagged) for the next sample.
+  portENTER_CRITICAL(&edgeMux);
+  changePending = false;
+  for (int i = 0; i < count; i++) {
+    sampledEdgeUs[i] = pendingEdgeUs[i];
+    pendingEdgeUs[i] = 0;
+  }
+  portEXIT_CRITICAL(&edgeMux);
+  if (!snapshot) {
+    for (int i = 0; i < count; i++) {
+      occupied.set(slots[i], digitalRead(pins[i]) == LOW);
+    }
+    return;
+  }
+
+  // One read per register, so all sensors are sampled at the same instant.
+  uint32_t inputs[2] = { REG_READ(GPIO_IN_REG), REG_READ(GPIO_IN1_REG) };
+  for (int i = 0; i < count; i++) {
+    occupied.set(slots[i], !(inputs[masks[i].word] & masks[i].mask));
+  }
+}
+
+void GpioSensorBus::markSensed(OccupancyBits& sensed) const {
+  for (int i = 0; i < count; i++) {
+    sensed.set(slots[i], true);
+  }
+}
+
+int64_t GpioSensorBus::edgeUs(int slot) const {
+  for (int i = 0; i < count; i++) {
+    if (slots[i] == slot) {
+      return sampledEdgeUs[i]; // Only sample() writes it, on the loop task
+    }
+  }
+  return 0;
+}
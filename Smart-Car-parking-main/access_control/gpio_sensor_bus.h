@@ -0,0 +1,60 @@
+#ifndef GPIO_SENSOR_BUS_H
+#define GPIO_SENSOR_BUS_H
+
+#include <Arduino.h>
+#include "slot_sensor_bus.h"
+
+// One sensor per GPIO pin, LOW while the slot is occupied. Each pin has an
+// edge interrupt that timestamps changes for tracing: the first edge is
+// latched until the next sample() takes it, so a bouncing sensor does not
+// move the trace's start to its last bounce.
+//
+// Sampling reads the two GPIO input registers once and picks each sensor's
+// bit out with a mask table built in begin(), instead of one digitalRead()
+// per pin. digitalRead() remains as a fallback and for comparison.
+class GpioSensorBus : public SlotSensorBus {
+ public:
+  static const int MAX_SENSORS = 16;
+
+  // pins[i] senses slot slots[i]; both arrays must outlive the bus.
+  GpioSensorBus(const int* pins, const int* slots, int count);
+
+  const char* name() const { return "gpio"; }
+  void begin();
+  int sensorCount() const { return count; }
+  void sample(OccupancyBits& occupied);
+  void markSensed(OccupancyBits& sensed) const;
+  int64_t edgeUs(int slot) const;
+  bool hasPendingChange() const { return changePending; }
+
+  // Switches between the register snapshot (default) and digitalRead().
+  void setSnapshotSampling(bool enabled) { snapshot = enabled && snapshotCapable; }
+  bool snapshotSampling() const { return snapshot; }
+
+ private:
+  struct EdgeContext {
+    GpioSensorBus* bus;
+    int sensor;
+  };
+  static void IRAM_ATTR onEdge(void* arg);
+
+  // Where a sensor's bit sits in the input registers.
+  struct PinMask {
+    uint8_t word;   // 0: GPIO_IN (pins 0-31), 1: GPIO_IN1 (pins 32-39)
+    uint32_t mask;
+  };
+
+  const int* pins;
+  const int* slots;
+  int count;
+  EdgeContext contexts[MAX_SENSORS];
+  PinMask masks[MAX_SENSORS];
+  bool snapshotCapable;
+  bool snapshot;
+  volatile int64_t pendingEdgeUs[MAX_SENSORS]; // First edge since the last sample (ISR)
+  int64_t sampledEdgeUs[MAX_SENSORS];          // Edges the last sample took in
+  volatile bool changePending;
+  portMUX_TYPE edgeMux;
+};
+
+#endif
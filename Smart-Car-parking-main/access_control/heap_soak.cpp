@@ -0,0 +1,99 @@
+#ifdef HEAP_SOAK_TEST
+
+#include <Arduino.h>
+#include "heap_soak.h"
+#include "heap_tracker.h"
+#include "network_handler.h"
+#include "slot_handler.h"
+#include "trace.h"
+#include "logger.h"
+
+// --- Soak Settings ---
+const uint32_t SOAK_BATCH = 100;                   // Iterations per loop() pass
+const uint32_t SOAK_WARMUP_ITERATIONS = 10000;     // Let buffers reach steady size
+const uint32_t SOAK_CHECK_INTERVAL = 100000;
+const uint32_t SOAK_TOTAL_ITERATIONS = 2000000;
+const int32_t SOAK_FREE_TOLERANCE = 1024;          // Bytes of drift we accept
+const int32_t SOAK_BLOCK_TOLERANCE = 1024;
+const int32_t SOAK_ALLOCATION_TOLERANCE = 4;       // Live allocations of drift we accept
+const int SOAK_MAX_PAYLOAD = 64;
+
+// This tells the compiler that this function exists, but it's defined
+// in network_handler.cpp. We call it directly to fake incoming traffic.
+void mqttCallback(char* topic, byte* payload, unsigned int length);
+
+// --- Module-specific (static) Variables ---
+static uint32_t iterations = 0;
+static uint32_t soakTraceId = SYNTHETIC_TRACE_ID_BASE; // Never collides with slot events
+static HeapSnapshot baseline;
+static bool finished = false;
+
+static void injectRandomCommand() {
+  static char topic[] = "door_open";
+  byte payload[SOAK_MAX_PAYLOAD];
+  unsigned int length = random(1, SOAK_MAX_PAYLOAD + 1);
+  for (unsigned int i = 0; i < length; i++) {
+    // Lower case and digits only, so we never produce a real "OPEN".
+    payload[i] = (i % 3 == 0) ? '0' + random(10) : 'a' + random(26);
+  }
+  mqttCallback(topic, payload, length);
+}
+
+static void injectRandomSlots() {
+  OccupancyBits states;
+  for (int i = 0; i < getSlotCount(); i++) {
+    states.set(i, random(2) == 1);
+  }
+  SlotTrace trace;
+  trace.id = soakTraceId++;
+  trace.detectUs = traceNowUs();
+  trace.edgeUs = trace.detectUs;
+  publishSlotStatus(states, getSlotCount(), trace);
+}
+
+static void checkHeap() {
+  HeapSnapshot now = getHeapSnapshot();
+  int32_t freeDrift = (int32_t)now.freeBytes - (int32_t)baseline.freeBytes;
+  int32_t blockDrift = (int32_t)now.largestFreeBlock - (int32_t)baseline.largestFreeBlock;
+  int32_t allocationDrift = (int32_t)now.allocatedBlocks - (int32_t)baseline.allocatedBlocks;
+  if (freeDrift < -SOAK_FREE_TOLERANCE || blockDrift < -SOAK_BLOCK_TOLERANCE) {
+    LOG_ERROR(HEAP_SOAK_FAILED, iterations, freeDrift, blockDrift);
+    finished = true;
+    return;
+  }
+  if (allocationDrift > SOAK_ALLOCATION_TOLERANCE) {
+    LOG_ERROR(HEAP_SOAK_BLOCKS, iterations, allocationDrift);
+    finished = true;
+    return;
+  }
+  LOG_INFO(HEAP_SOAK_CHECKPOINT, iterations, now.freeBytes, freeDrift,
+           now.largestFreeBlock, blockDrift);
+}
+
+void runHeapSoakIteration() {
+  if (finished) {
+    return;
+  }
+  for (uint32_t i = 0; i < SOAK_BATCH; i++) {
+    injectRandomCommand();
+    if (iterations % 10 == 0) {
+      injectRandomSlots();
+    }
+    iterations++;
+
+    if (iterations == SOAK_WARMUP_ITERATIONS) {
+      baseline = getHeapSnapshot();
+    } else if (iterations > SOAK_WARMUP_ITERATIONS && iterations % SOAK_CHECK_INTERVAL == 0) {
+      checkHeap();
+    }
+    if (iterations >= SOAK_TOTAL_ITERATIONS && !finished) {
+      LOG_INFO(HEAP_SOAK_PASSED, iterations);
+      finished = true;
+    }
+    if (finished) {
+      return;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HEAP_SOAK_H
+#define HEAP_SOAK_H
+
+// Heap soak mode, compiled in with -DHEAP_SOAK_TEST (never in production).
+// Each call pushes a batch of randomized MQTT commands and slot updates through
+// the real handlers and periodically checks that neither the free heap nor the
+// largest free block has shrunk, and the live allocations have not grown,
+// since the warm-up baseline. Results go to the log as HEAP_SOAK_* records.
+// The controllers the soak drives are also soaked on the host, with every
+// allocation counted: tools/host_checks/heap_soak_check.cpp.
+void runHeapSoakIteration();
+
+#endif
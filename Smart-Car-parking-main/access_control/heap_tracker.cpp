@@ -0,0 +1,222 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#else
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#endif
+#include "heap_tracker.h"
+
+#if defined(ARDUINO) || defined(HEAP_TRACK_HOST)
+
+// --- Module Variables ---
+static HeapModuleStats moduleStats[HEAP_MODULE_COUNT];
+static HeapScope* currentScope = NULL; // Innermost active scope (loop task only)
+
+static const char* const MODULE_NAMES[HEAP_MODULE_COUNT] = {
+  "network", "gate", "slots", "rfid"
+};
+
+// What a scope compares before and after its call.
+struct HeapReading {
+  uint32_t freeBytes;
+  uint32_t allocatedBlocks;
+  uint32_t largestFreeBlock;
+};
+
+#ifdef ARDUINO
+
+// heap_caps_get_info() walks the heap, so scopes belong on entry points
+// (once per command, sample pass or status), not in inner loops.
+static HeapReading readHeap() {
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+  HeapReading reading;
+  reading.freeBytes = info.total_free_bytes;
+  reading.allocatedBlocks = info.allocated_blocks;
+  reading.largestFreeBlock = info.largest_free_block;
+  return reading;
+}
+
+static uint32_t minimumFreeBytes() {
+  return heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+}
+
+#else
+
+// --- Host Allocator ---
+// Link with -Wl,--wrap=malloc,--wrap=free,--wrap=calloc,--wrap=realloc so the
+// allocations of the linked objects come here; operator new and delete are
+// replaced below to come here too. Each block carries its size in a header,
+// so nothing allocated by libc itself (strdup, getline) may be freed through
+// here. The host heap is given a nominal ESP32-sized capacity so free bytes
+// read as on the device; it has no fragmentation model, so its largest free
+// block is all of its free bytes.
+const uint32_t HOST_HEAP_BYTES = 320 * 1024;
+
+union BlockHeader {
+  size_t size;
+  max_align_t alignment;
+};
+
+static uint32_t hostBytes = 0;
+static uint32_t hostBlocks = 0;
+static uint32_t hostPeakBytes = 0;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void __real_free(void* pointer);
+void* __real_realloc(void* pointer, size_t size);
+
+static void* trackBlock(BlockHeader* header, size_t size) {
+  if (header == NULL) {
+    return NULL;
+  }
+  header->size = size;
+  hostBytes += size;
+  hostBlocks++;
+  if (hostBytes > hostPeakBytes) {
+    hostPeakBytes = hostBytes;
+  }
+  return header + 1;
+}
+
+static BlockHeader* untrackBlock(void* pointer) {
+  BlockHeader* header = (BlockHeader*)pointer - 1;
+  hostBytes -= header->size;
+  hostBlocks--;
+  return header;
+}
+
+void* __wrap_malloc(size_t size) {
+  return trackBlock((BlockHeader*)__real_malloc(sizeof(BlockHeader) + size), size);
+}
+
+void __wrap_free(void* pointer) {
+  if (pointer != NULL) {
+    __real_free(untrackBlock(pointer));
+  }
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  if (size != 0 && count > (size_t)-1 / size) {
+    return NULL;
+  }
+  void* pointer = __wrap_malloc(count * size);
+  if (pointer != NULL) {
+    memset(pointer, 0, count * size);
+  }
+  return pointer;
+}
+
+void* __wrap_realloc(void* pointer, size_t size) {
+  if (pointer == NULL) {
+    return __wrap_malloc(size);
+  }
+  BlockHeader* header = untrackBlock(pointer);
+  BlockHeader* moved = (BlockHeader*)__real_realloc(header, sizeof(BlockHeader) + size);
+  if (moved == NULL) {
+    trackBlock(header, header->size); // The old block is still allocated
+    return NULL;
+  }
+  return trackBlock(moved, size);
+}
+}
+
+void* operator new(size_t size) {
+  void* pointer = __wrap_malloc(size);
+  if (pointer == NULL) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return __wrap_malloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return __wrap_malloc(size); }
+void operator delete(void* pointer) noexcept { __wrap_free(pointer); }
+void operator delete[](void* pointer) noexcept { __wrap_free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { __wrap_free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { __wrap_free(pointer); }
+
+static HeapReading readHeap() {
+  HeapReading reading;
+  reading.freeBytes = hostBytes < HOST_HEAP_BYTES ? HOST_HEAP_BYTES - hostBytes : 0;
+  reading.allocatedBlocks = hostBlocks;
+  reading.largestFreeBlock = reading.freeBytes;
+  return reading;
+}
+
+static uint32_t minimumFreeBytes() {
+  return hostPeakBytes < HOST_HEAP_BYTES ? HOST_HEAP_BYTES - hostPeakBytes : 0;
+}
+
+#endif
+
+HeapSnapshot getHeapSnapshot() {
+  HeapReading reading = readHeap();
+  HeapSnapshot snapshot;
+  snapshot.freeBytes = reading.freeBytes;
+  snapshot.minFreeBytes = minimumFreeBytes();
+  snapshot.largestFreeBlock = reading.largestFreeBlock;
+  snapshot.allocatedBlocks = reading.allocatedBlocks;
+  snapshot.fragmentationPct = 0;
+  if (snapshot.freeBytes > 0) {
+    snapshot.fragmentationPct =
+        100 - (uint8_t)((uint64_t)snapshot.largestFreeBlock * 100 / snapshot.freeBytes);
+  }
+  return snapshot;
+}
+
+const HeapModuleStats& getHeapModuleStats(HeapModule module) {
+  return moduleStats[module];
+}
+
+const char* getHeapModuleName(HeapModule module) {
+  return MODULE_NAMES[module];
+}
+
+HeapScope::HeapScope(HeapModule module)
+    : module(module), childDelta(0), childBlocks(0), parent(currentScope) {
+  HeapReading reading = readHeap();
+  freeAtStart = reading.freeBytes;
+  blocksAtStart = reading.allocatedBlocks;
+  largestAtStart = reading.largestFreeBlock;
+  currentScope = this;
+}
+
+HeapScope::~HeapScope() {
+  HeapReading reading = readHeap();
+  // Positive deltas: the heap shrank, or gained allocations, while we were running.
+  int32_t totalDelta = (int32_t)(freeAtStart - reading.freeBytes);
+  int32_t totalBlocks = (int32_t)(reading.allocatedBlocks - blocksAtStart);
+  int32_t ownDelta = totalDelta - childDelta;
+  int32_t ownBlocks = totalBlocks - childBlocks;
+
+  HeapModuleStats& stats = moduleStats[module];
+  stats.calls++;
+  if (ownDelta > 0) {
+    stats.allocs++;
+    stats.bytesAllocated += ownDelta;
+  } else if (ownDelta < 0) {
+    stats.frees++;
+    stats.bytesFreed += -ownDelta;
+  }
+  stats.netBytes += ownDelta;
+  if (stats.netBytes > stats.peakNetBytes) {
+    stats.peakNetBytes = stats.netBytes;
+  }
+  stats.netBlocks += ownBlocks;
+  if (reading.largestFreeBlock < largestAtStart) {
+    stats.blockShrinks++;
+  }
+
+  if (parent != NULL) {
+    parent->childDelta += totalDelta;
+    parent->childBlocks += totalBlocks;
+  }
+  currentScope = parent;
+}
+
+#endif
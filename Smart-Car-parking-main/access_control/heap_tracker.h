@@ -0,0 +1,72 @@
+#ifndef HEAP_TRACKER_H
+#define HEAP_TRACKER_H
+
+#include <stdint.h>
+
+// Modules whose heap usage is tracked separately.
+enum HeapModule {
+  HEAP_MODULE_NETWORK,
+  HEAP_MODULE_GATE,
+  HEAP_MODULE_SLOTS,
+  HEAP_MODULE_RFID,
+  HEAP_MODULE_COUNT
+};
+
+// Heap activity attributed to one module. The ESP32 heap has no per-caller
+// hooks, so these are derived from the heap before and after each tracked
+// call: an "alloc" is a call that left the heap smaller, a "free" one that
+// left it larger. Nested scopes are subtracted from their parent.
+struct HeapModuleStats {
+  uint32_t calls;
+  uint32_t allocs;
+  uint32_t frees;
+  uint32_t bytesAllocated;
+  uint32_t bytesFreed;
+  int32_t netBytes;      // Bytes currently held by the module
+  int32_t peakNetBytes;  // High-water mark of netBytes
+  int32_t netBlocks;     // Allocations currently held by the module
+  uint32_t blockShrinks; // Calls that left the largest free block smaller
+};
+
+// Whole-heap view.
+struct HeapSnapshot {
+  uint32_t freeBytes;
+  uint32_t minFreeBytes;     // Low-water mark since boot
+  uint32_t largestFreeBlock;
+  uint32_t allocatedBlocks;  // Live allocations
+  uint8_t fragmentationPct;  // 100 * (1 - largest block / free)
+};
+
+HeapSnapshot getHeapSnapshot();
+const HeapModuleStats& getHeapModuleStats(HeapModule module);
+const char* getHeapModuleName(HeapModule module);
+
+// Attributes heap changes during its lifetime to one module.
+// Put one at the top of a module's entry points:
+//   HeapScope heapScope(HEAP_MODULE_GATE);
+// Host builds with -DHEAP_TRACK_HOST watch a wrapped host allocator instead
+// (see heap_tracker.cpp for the link flags); single-threaded only.
+#if defined(ARDUINO) || defined(HEAP_TRACK_HOST)
+class HeapScope {
+ public:
+  explicit HeapScope(HeapModule module);
+  ~HeapScope();
+
+ private:
+  HeapModule module;
+  uint32_t freeAtStart;
+  uint32_t blocksAtStart;
+  uint32_t largestAtStart;
+  int32_t childDelta;  // Net bytes already attributed to nested scopes
+  int32_t childBlocks; // Net allocations already attributed to nested scopes
+  HeapScope* parent;
+};
+#else
+// Other host builds of the controllers have no heap to watch.
+class HeapScope {
+ public:
+  explicit HeapScope(HeapModule) {}
+};
+#endif
+
+#endif
@@ -0,0 +1,30 @@
+#include "i2c_bus.h"
+
+WireI2cBus::WireI2cBus(TwoWire& wire, int sdaPin, int sclPin, uint32_t clockHz)
+    : wire(wire), sdaPin(sdaPin), sclPin(sclPin), clockHz(clockHz) {}
+
+void WireI2cBus::begin() {
+  wire.begin(sdaPin, sclPin, clockHz);
+}
+
+bool WireI2cBus::writeRegister(uint8_t address, uint8_t reg, uint8_t value) {
+  wire.beginTransmission(address);
+  wire.write(reg);
+  wire.write(value);
+  return wire.endTransmission() == 0;
+}
+
+bool WireI2cBus::readRegisters(uint8_t address, uint8_t reg, uint8_t* data, size_t length) {
+  wire.beginTransmission(address);
+  wire.write(reg);
+  if (wire.endTransmission(false) != 0) { // Repeated start into the read
+    return false;
+  }
+  if (wire.requestFrom(address, (uint8_t)length) != length) {
+    return false;
+  }
+  for (size_t i = 0; i < length; i++) {
+    data[i] = wire.read();
+  }
+  return true;
+}
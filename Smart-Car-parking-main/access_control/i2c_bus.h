@@ -0,0 +1,36 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// Register-level access to devices on one I2C bus. Sensor backends talk to
+// this rather than to Wire directly, so the same driver code can run against
+// a stand-in bus on a host.
+class I2cBus {
+ public:
+  virtual ~I2cBus() {}
+
+  virtual bool writeRegister(uint8_t address, uint8_t reg, uint8_t value) = 0;
+
+  // Reads 'length' consecutive registers starting at 'reg' in one transaction.
+  virtual bool readRegisters(uint8_t address, uint8_t reg, uint8_t* data, size_t length) = 0;
+};
+
+// An I2cBus on one of the ESP32's I2C controllers.
+class WireI2cBus : public I2cBus {
+ public:
+  WireI2cBus(TwoWire& wire, int sdaPin, int sclPin, uint32_t clockHz);
+
+  void begin();
+  bool writeRegister(uint8_t address, uint8_t reg, uint8_t value);
+  bool readRegisters(uint8_t address, uint8_t reg, uint8_t* data, size_t length);
+
+ private:
+  TwoWire& wire;
+  int sdaPin;
+  int sclPin;
+  uint32_t clockHz;
+};
+
+#endif
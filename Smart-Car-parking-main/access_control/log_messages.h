@@ -0,0 +1,74 @@
+#ifndef LOG_MESSAGES_H
+#define LOG_MESSAGES_H
+
+#include <stdint.h>
+
+// Every log line the firmware can emit. The firmware only ever sends the
+// numeric ID and the raw arguments; tools/decode_log.py parses this file to
+// turn them back into text, so new entries must keep the X(ID, "format") shape
+// on a single line. Append new messages at the end so old captures still
+// decode with a newer table.
+//
+// Supported conversions: %d %i (signed 32-bit), %u %x %X %c (unsigned 32-bit),
+// %f (float) and %s (string, truncated to LOG_MAX_STRING bytes).
+#define LOG_MESSAGES(X) \
+  X(LOG_DROPPED,           "Logger: %u records dropped") \
+  X(BOOT,                  "Booting Smart Parking System...") \
+  X(SYSTEM_READY,          "System Initialized. Ready.") \
+  X(GATE_OPENING,          "Gate Handler: Opening gate.") \
+  X(GATE_TIMER_CLOSING,    "Gate Handler: Timer expired. Closing gate.") \
+  X(NET_WIFI_CONNECTING,   "Connecting to WiFi %s...") \
+  X(NET_WIFI_WAITING,      "WiFi not connected yet, status %d") \
+  X(NET_WIFI_CONNECTED,    "WiFi Connected.") \
+  X(NET_MQTT_RX,           "Message Received! Topic: %s, Payload: %s") \
+  X(NET_OPEN_CMD,          "Network Handler: OPEN command received. Triggering gate.") \
+  X(NET_UNKNOWN_CMD,       "Network Handler: Unknown command received.") \
+  X(NET_MQTT_CONNECTING,   "Attempting MQTT connection as %s...") \
+  X(NET_MQTT_CONNECTED,    "MQTT connected, subscribed to: %s") \
+  X(NET_MQTT_FAILED,       "MQTT connection failed, rc=%d try again in 5 seconds") \
+  X(NET_PUBLISH_OFFLINE,   "Network Handler: MQTT client not connected. Aborting publish.") \
+  X(NET_PUBLISH_SLOTS,     "Network Handler: Publishing %u byte slot status to %s") \
+  X(RFID_SCANNED,          "RFID Handler: Card scanned, UID: %s") \
+  X(RFID_RESPONSE,         "RFID Handler: Response from server: %s") \
+  X(RFID_GRANTED,          "RFID Handler: Access Granted.") \
+  X(RFID_DENIED,           "RFID Handler: Access Denied.") \
+  X(RFID_HTTP_FAILED,      "RFID Handler: HTTP request failed, code %d") \
+  X(SLOTS_INITIAL,         "Initial sensor states have been read.") \
+  X(SLOTS_CHANGED,         "Slot Handler: State change detected, calling network handler to publish.") \
+  X(HEAP_SOAK_CHECKPOINT,  "Heap soak: %u iterations, free %u (%d), largest block %u (%d)") \
+  X(HEAP_SOAK_FAILED,      "Heap soak FAILED after %u iterations: free %d, largest block %d bytes vs baseline") \
+  X(HEAP_SOAK_PASSED,      "Heap soak passed: %u iterations without heap growth") \
+  X(NET_BAD_COMMAND,       "Network Handler: Malformed command JSON: %s") \
+  X(GATE_CLOSING_PASSED,   "Gate Handler: Vehicle has passed. Closing gate.") \
+  X(GATE_BEAM_FAULT,       "Gate Handler: Passage sensor blocked for %u ms, closing anyway. Check the sensor.") \
+  X(GATE_ENTRY_QUEUED,     "Gate Handler: Entry queued behind open barrier, %u waiting.") \
+  X(SLOTS_SAMPLING_BENCH,  "Slot Handler: GPIO sampling via %s: %u ns per pass, %u ns per sensor.") \
+  X(SLOTS_SAMPLING_MISMATCH, "Slot Handler: digitalRead and register snapshot disagree.") \
+  X(POWER_MODE_SELECTED,   "Power: %s mode, loop idles up to %u ms.") \
+  X(POWER_LIGHT_SLEEP_UNAVAILABLE, "Power: light sleep needs CONFIG_PM_ENABLE and tickless idle in the core; staying in modem sleep.") \
+  X(RFID_RPC_NOT_SENT,     "RFID Handler: Validation for %s reader not sent: %s. Access Denied.") \
+  X(RFID_RPC_TIMEOUT,      "RFID Handler: No validation reply for %s reader (request %lu). Access Denied.") \
+  X(RFID_RPC_REPLY,        "RFID Handler: Validation reply for %s reader after %u ms.") \
+  X(RFID_SCAN_REPEAT,      "RFID Handler: %s reader saw %s again, not re-validating.") \
+  X(RFID_PASSBACK,         "RFID Handler: %s reader refused %s: anti-passback. Access Denied.") \
+  X(NET_ENCODING_BENCH,    "Network Handler: %s slot status for %d slots: %u bytes, %u ns to encode.") \
+  X(HEAP_SOAK_BLOCKS,      "Heap soak FAILED after %u iterations: %d live allocations vs baseline") \
+  X(GATE_QUEUE_FULL,       "Gate Handler: %s queue full at %u entries, open request dropped.") \
+  X(GATE_LANE_OPENING,     "Gate Handler: Opening %s gate.") \
+  X(GATE_LANE_TIMER_CLOSING, "Gate Handler: Timer expired. Closing %s gate.") \
+  X(NET_OPEN_LANE_CMD,     "Network Handler: OPEN command received. Triggering %s gate.") \
+  X(GATE_LANE_CLOSING_PASSED, "Gate Handler: Vehicle has passed. Closing %s gate.") \
+  X(GATE_LANE_BEAM_FAULT,  "Gate Handler: %s passage sensor blocked for %u ms, closing anyway. Check the sensor.") \
+  X(GATE_LANE_ENTRY_QUEUED, "Gate Handler: Entry queued behind open %s barrier, %u waiting.") \
+  X(RFID_READER_SCANNED,   "RFID Handler: Card scanned at %s reader, UID: %s") \
+  X(TELEMETRY_NO_MEMORY,   "Telemetry: No memory for a %u-byte document, skipped.") \
+  X(TELEMETRY_OVERFLOW,    "Telemetry: Document outgrew its %u-byte pool, fields dropped.")
+
+#define LOG_MESSAGE_ENUM(id, fmt) LOG_ID_##id,
+enum LogId : uint16_t {
+  LOG_MESSAGES(LOG_MESSAGE_ENUM)
+  LOG_ID_COUNT
+};
+#undef LOG_MESSAGE_ENUM
+
+#endif
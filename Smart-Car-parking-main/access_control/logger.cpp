@@ -0,0 +1,137 @@
+#include <Arduino.h>
+#include <atomic>
+#include "logger.h"
+
+// --- Drain Task Settings ---
+const uint32_t LOG_DRAIN_CHUNK = 128;        // Bytes handed to Serial per write
+const uint32_t LOG_DRAIN_IDLE_MS = 5;        // Sleep when the ring is empty
+const uint32_t LOG_DRAIN_STACK_SIZE = 2048;
+
+// --- Ring Buffer ---
+// Single producer (the Arduino loop task, which also runs the MQTT callback)
+// and single consumer (the drain task), so plain acquire/release indices are
+// enough and no lock is ever taken. Do not log from an ISR.
+static uint8_t ring[LOG_RING_SIZE];
+static std::atomic<uint32_t> ringHead(0); // Written by the producer only
+static std::atomic<uint32_t> ringTail(0); // Written by the consumer only
+
+static std::atomic<uint32_t> droppedTotal(0);
+static uint32_t droppedUnreported = 0; // Producer-side, reported in-band
+
+static bool ringPush(const uint8_t* data, uint32_t size) {
+  uint32_t head = ringHead.load(std::memory_order_relaxed);
+  uint32_t tail = ringTail.load(std::memory_order_acquire);
+  if (LOG_RING_SIZE - (head - tail) < size) {
+    return false;
+  }
+  for (uint32_t i = 0; i < size; i++) {
+    ring[(head + i) & (LOG_RING_SIZE - 1)] = data[i];
+  }
+  ringHead.store(head + size, std::memory_order_release);
+  return true;
+}
+
+// Drains the ring to Serial. Runs below the loop task so a slow UART only
+// ever delays log output, never the gate or the sensors.
+static void logDrainTask(void*) {
+  uint8_t chunk[LOG_DRAIN_CHUNK];
+  for (;;) {
+    uint32_t tail = ringTail.load(std::memory_order_relaxed);
+    uint32_t head = ringHead.load(std::memory_order_acquire);
+    uint32_t available = head - tail;
+    if (available == 0) {
+      vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_IDLE_MS));
+      continue;
+    }
+    uint32_t count = available < LOG_DRAIN_CHUNK ? available : LOG_DRAIN_CHUNK;
+    for (uint32_t i = 0; i < count; i++) {
+      chunk[i] = ring[(tail + i) & (LOG_RING_SIZE - 1)];
+    }
+    ringTail.store(tail + count, std::memory_order_release);
+    Serial.write(chunk, count);
+  }
+}
+
+void setupLogger() {
+  xTaskCreatePinnedToCore(logDrainTask, "logDrain", LOG_DRAIN_STACK_SIZE, NULL,
+                          tskIDLE_PRIORITY, NULL, ARDUINO_RUNNING_CORE);
+}
+
+uint32_t getLogDroppedCount() {
+  return droppedTotal.load(std::memory_order_relaxed);
+}
+
+// --- LogRecord ---
+LogRecord::LogRecord(uint8_t level, LogId id) : length(2), truncated(false) {
+  buffer[0] = LOG_FRAME_SYNC;
+  buffer[1] = 0; // Filled in by seal()
+  buffer[length++] = level;
+  uint16_t rawId = id;
+  put(&rawId, sizeof(rawId));
+  uint32_t timestamp = micros();
+  put(&timestamp, sizeof(timestamp));
+}
+
+void LogRecord::put(const void* data, uint8_t size) {
+  // Keep the last byte free for the checksum.
+  if (truncated || length + size > LOG_MAX_RECORD - 1) {
+    truncated = true;
+    return;
+  }
+  memcpy(buffer + length, data, size);
+  length += size;
+}
+
+void LogRecord::putWord(uint32_t value) {
+  put(&value, sizeof(value));
+}
+
+void LogRecord::add(float value) {
+  put(&value, sizeof(value));
+}
+
+void LogRecord::add(const char* value) {
+  if (value == NULL) {
+    value = "(null)";
+  }
+  size_t size = strnlen(value, LOG_MAX_STRING);
+  int room = (LOG_MAX_RECORD - 1) - length - 1;
+  if (room <= 0) {
+    truncated = true;
+    return;
+  }
+  if ((int)size > room) {
+    size = room;
+  }
+  uint8_t prefix = size;
+  put(&prefix, 1);
+  put(value, prefix);
+}
+
+void LogRecord::seal() {
+  buffer[1] = length - 2;
+  uint8_t checksum = 0;
+  for (uint8_t i = 2; i < length; i++) {
+    checksum ^= buffer[i];
+  }
+  buffer[length++] = checksum;
+}
+
+void LogRecord::commit() {
+  seal();
+
+  // Report earlier losses in-band first, so the decoder shows where the gap is.
+  if (droppedUnreported > 0) {
+    LogRecord report(LOG_LEVEL_WARN, LOG_ID_LOG_DROPPED);
+    report.add(droppedUnreported);
+    report.seal();
+    if (ringPush(report.buffer, report.length)) {
+      droppedUnreported = 0;
+    }
+  }
+
+  if (!ringPush(buffer, length)) {
+    droppedUnreported++;
+    droppedTotal.fetch_add(1, std::memory_order_relaxed);
+  }
+}
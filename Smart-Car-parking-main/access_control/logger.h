@@ -0,0 +1,117 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>
+#include "log_messages.h"
+
+// --- Log Levels ---
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+// Calls above LOG_LEVEL are removed by the preprocessor, arguments included.
+// Bench builds can pass -DLOG_LEVEL=LOG_LEVEL_DEBUG; release builds
+// -DLOG_LEVEL=LOG_LEVEL_WARN (or LOG_LEVEL_NONE).
+// Host builds of the controllers (tools/fleet_sim) have no ring buffer and log nothing.
+#ifndef LOG_LEVEL
+#ifdef ARDUINO
+#define LOG_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_LEVEL LOG_LEVEL_NONE
+#endif
+#endif
+
+// --- Buffer Sizes ---
+const uint32_t LOG_RING_SIZE = 2048; // Must be a power of two
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+const uint8_t LOG_MAX_RECORD = 96;   // Largest single record, framing included
+const uint8_t LOG_MAX_STRING = 40;   // %s arguments are truncated to this
+
+// Wire format of one record, as drained to Serial (little-endian):
+//   0xA5 | len | level | id (2) | micros (4) | args... | checksum
+// 'len' counts the bytes between itself and the checksum, which is the XOR of
+// those same bytes. Integer and float arguments take 4 bytes each, strings a
+// length byte followed by the characters.
+const uint8_t LOG_FRAME_SYNC = 0xA5;
+
+// Starts the low-priority task that drains the ring buffer to Serial.
+// Serial must already be started.
+void setupLogger();
+
+// Number of records thrown away because the ring buffer was full.
+uint32_t getLogDroppedCount();
+
+// Builds one record on the stack; used by the LOG_* macros below.
+class LogRecord {
+ public:
+  LogRecord(uint8_t level, LogId id);
+
+  void add(int value) { putWord((uint32_t)value); }
+  void add(unsigned int value) { putWord(value); }
+  void add(long value) { putWord((uint32_t)value); }
+  void add(unsigned long value) { putWord((uint32_t)value); }
+  void add(bool value) { putWord(value ? 1 : 0); }
+  void add(char value) { putWord((uint8_t)value); }
+  void add(float value);
+  void add(double value) { add((float)value); }
+  void add(const char* value);
+  void add(char* value) { add((const char*)value); }
+
+  // Copies the record into the ring buffer, or counts it as dropped.
+  void commit();
+
+ private:
+  void putWord(uint32_t value);
+  void seal(); // Fills in the length byte and appends the checksum
+  void put(const void* data, uint8_t size);
+
+  uint8_t buffer[LOG_MAX_RECORD];
+  uint8_t length;
+  bool truncated;
+};
+
+inline void logAddArgs(LogRecord&) {}
+
+template <typename T, typename... Rest>
+inline void logAddArgs(LogRecord& record, const T& first, const Rest&... rest) {
+  record.add(first);
+  logAddArgs(record, rest...);
+}
+
+template <typename... Args>
+inline void logWrite(uint8_t level, LogId id, const Args&... args) {
+  LogRecord record(level, id);
+  logAddArgs(record, args...);
+  record.commit();
+}
+
+// --- Logging Macros ---
+// Usage: LOG_INFO(GATE_OPENING); LOG_WARN(NET_MQTT_FAILED, rc);
+// The first argument is a message name from log_messages.h.
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(id, ...) logWrite(LOG_LEVEL_ERROR, LOG_ID_##id, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(id, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(id, ...) logWrite(LOG_LEVEL_WARN, LOG_ID_##id, ##__VA_ARGS__)
+#else
+#define LOG_WARN(id, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(id, ...) logWrite(LOG_LEVEL_INFO, LOG_ID_##id, ##__VA_ARGS__)
+#else
+#define LOG_INFO(id, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(id, ...) logWrite(LOG_LEVEL_DEBUG, LOG_ID_##id, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(id, ...) do {} while (0)
+#endif
+
+#endif
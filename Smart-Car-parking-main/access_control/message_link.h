@@ -0,0 +1,23 @@
+#ifndef MESSAGE_LINK_H
+#define MESSAGE_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The MQTT session as the publishers see it: QoS 0 publishes, whole or
+// streamed. The firmware's is a PubSubClient (network_handler.cpp); the fleet
+// simulator gives each simulated controller its own socket.
+class MessageLink {
+ public:
+  virtual ~MessageLink() {}
+
+  virtual bool connected() = 0;
+  virtual bool publish(const char* topic, const char* payload) = 0;
+
+  // A payload of known length, written in pieces between these two calls.
+  virtual bool beginPublish(const char* topic, size_t length) = 0;
+  virtual void write(const uint8_t* data, size_t length) = 0;
+  virtual bool endPublish() = 0;
+};
+
+#endif
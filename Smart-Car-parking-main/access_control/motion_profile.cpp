@@ -0,0 +1,53 @@
+#include <math.h>
+#include "motion_profile.h"
+
+MotionProfile::MotionProfile()
+    : from(0), to(0), acceleration(1), peakSpeed(0), start(0), accelMs(0), cruiseMs(0), totalMs(0) {}
+
+void MotionProfile::plan(float fromAngle, float toAngle, const MotionLimits& limits, TimeMs startAt) {
+  from = fromAngle;
+  to = toAngle;
+  start = startAt;
+  acceleration = limits.acceleration;
+
+  float distance = fabsf(to - from);
+  float accelDistance = limits.maxSpeed * limits.maxSpeed / (2 * acceleration);
+  float accelSeconds;
+  float cruiseSeconds;
+  if (distance < 2 * accelDistance) {
+    // Triangle: turn around halfway, below maxSpeed.
+    peakSpeed = sqrtf(distance * acceleration);
+    accelSeconds = peakSpeed / acceleration;
+    cruiseSeconds = 0;
+  } else {
+    peakSpeed = limits.maxSpeed;
+    accelSeconds = peakSpeed / acceleration;
+    cruiseSeconds = (distance - 2 * accelDistance) / peakSpeed;
+  }
+  accelMs = (TimeMs)(accelSeconds * 1000 + 0.5f);
+  cruiseMs = (TimeMs)(cruiseSeconds * 1000 + 0.5f);
+  totalMs = 2 * accelMs + cruiseMs;
+}
+
+float MotionProfile::positionAt(TimeMs now) const {
+  if (!timeReached(now, start)) {
+    return from;
+  }
+  TimeMs elapsed = timeElapsed(now, start);
+  if (elapsed >= totalMs) {
+    return to;
+  }
+
+  float t = elapsed / 1000.0f;
+  float accelSeconds = accelMs / 1000.0f;
+  float travelled;
+  if (elapsed < accelMs) {
+    travelled = 0.5f * acceleration * t * t;
+  } else if (elapsed < accelMs + cruiseMs) {
+    travelled = 0.5f * peakSpeed * accelSeconds + peakSpeed * (t - accelSeconds);
+  } else {
+    float remaining = totalMs / 1000.0f - t;
+    travelled = fabsf(to - from) - 0.5f * acceleration * remaining * remaining;
+  }
+  return to > from ? from + travelled : from - travelled;
+}
@@ -0,0 +1,43 @@
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include "timer_wheel.h"
+
+// Speed and acceleration limits of one servo, in degrees per second and
+// degrees per second squared.
+struct MotionLimits {
+  float maxSpeed;
+  float acceleration;
+};
+
+// Trapezoidal velocity profile for one move: accelerate at a constant rate,
+// cruise at maxSpeed, decelerate symmetrically. Short moves never reach
+// maxSpeed and become a triangle. Pure arithmetic, no hardware.
+class MotionProfile {
+ public:
+  MotionProfile();
+
+  // Plans a move from rest at 'from' to rest at 'to', starting at startAt.
+  void plan(float from, float to, const MotionLimits& limits, TimeMs startAt);
+
+  // Angle the servo should be at; clamps to the endpoints outside the move.
+  float positionAt(TimeMs now) const;
+
+  bool finishedAt(TimeMs now) const { return timeReached(now, endTime()); }
+  TimeMs startTime() const { return start; }
+  TimeMs accelerationEnd() const { return start + accelMs; }
+  TimeMs endTime() const { return start + totalMs; }
+  float target() const { return to; }
+
+ private:
+  float from;
+  float to;
+  float acceleration;
+  float peakSpeed;
+  TimeMs start;
+  TimeMs accelMs;
+  TimeMs cruiseMs;
+  TimeMs totalMs;
+};
+
+#endif
@@ -5,69 +5,291 @@
 #include <ArduinoJson.h>
 #include "network_handler.h"
 #include "gate_handler.h"
+#include "rfid_handler.h"
+#include "logger.h"
+#include "heap_tracker.h"
+#include "system_state.h"
+#include "power.h"
+#include "status_publisher.h"
+#include "slot_handler.h"
 
 // --- Configuration ---
 const char* WIFI_SSID = "thegooddoctor62";
 const char* WIFI_PASSWORD = "qzju6234";
+#ifdef MQTT_LOCAL_BROKER
+// Bench builds (-DMQTT_LOCAL_BROKER=\"192.168.1.10\") talk plain MQTT to a
+// broker on the LAN, e.g. for tools/command_load_test.py.
+const char* MQTT_BROKER = MQTT_LOCAL_BROKER;
+const int MQTT_PORT = 1883;
+#else
 const char* MQTT_BROKER = "344221df652946139079042b380d50c9.s1.eu.hivemq.cloud";
 const int MQTT_PORT = 8883;
+#endif
+const uint16_t MQTT_BUFFER_SIZE = 1024;
+const TimeMs MQTT_RECONNECT_INTERVAL = 5000;
 const char* MQTT_USER = "thegooddoctor62";
 const char* MQTT_PASSWORD = "Ashwin@25";
 
 // --- Topics ---
 const char* MQTT_SUBSCRIBE_TOPIC = "door_open";
-const char* MQTT_PUBLISH_TOPIC_SLOTS = "parking/esp32/status";
+const char* MQTT_PUBLISH_TOPIC_TELEMETRY = "parking/esp32/telemetry";
+const char* MQTT_PUBLISH_TOPIC_ACK = "parking/esp32/ack";
+const char* MQTT_PUBLISH_TOPIC_VALIDATE = "parking/esp32/validate";
+const char* MQTT_VALIDATE_REPLY_FORMAT = "parking/esp32/%s/validate/reply"; // Per device, by MAC
 
-// --- Slot Mapping ---
-const int TOTAL_SLOTS = 20;
-const int REAL_SLOT_MAPPING[NUM_REAL_SENSORS] = {2, 5, 6, 9, 13, 17, 19};
+// --- Slot Status ---
+// Every change goes to each of these topics in its encoding (see
+// status_document.h). The dashboard reads JSON, so that is all a default
+// build sends; -DSLOT_STATUS_BINARY adds the CBOR and packed bitsets for
+// fleet backends such as tools/slot_aggregator. For 20 / 512 slots a document
+// is 821 / 20183 bytes as JSON, 65 / 191 as CBOR and 31 / 153 packed.
+// Encoding times have only been measured on a host (x86-64, -O2: JSON
+// 6-7 us / 150-200 us, either bitset under 0.2 us); -DSTATUS_ENCODING_BENCHMARK
+// logs the real ones on a board.
+static const StatusTopic STATUS_TOPICS[] = {
+  { "parking/esp32/status", STATUS_FORMAT_JSON },
+#ifdef SLOT_STATUS_BINARY
+  { "parking/esp32/status/cbor", STATUS_FORMAT_CBOR },
+  { "parking/esp32/status/packed", STATUS_FORMAT_PACKED },
+#endif
+};
+// Bench and fleet builds (-DSLOT_STATUS_DELTAS) list only the slots that
+// changed on the JSON topic; see status_publisher.h.
+#ifdef SLOT_STATUS_DELTAS
+const bool STATUS_DELTAS = true;
+#else
+const bool STATUS_DELTAS = false;
+#endif
+// Full JSON documents are patched in place rather than formatted per publish.
+static FixedStatusTemplate<TOTAL_SLOTS> statusTemplate;
+const StatusConfig STATUS_CONFIG = {
+  STATUS_TOPICS,
+  sizeof(STATUS_TOPICS) / sizeof(STATUS_TOPICS[0]),
+  STATUS_DELTAS,
+  &statusTemplate
+};
 
-// --- Global Clients ---
-WiFiClientSecure wifiClientSecure;
-PubSubClient mqttClient(wifiClientSecure);
-unsigned long lastReconnectAttempt = 0;
+// --- Commands ---
+const unsigned int MAX_COMMAND_LENGTH = 128; // Longer payloads are truncated
+
+// --- Telemetry ---
+const size_t TELEMETRY_CHUNK_SIZE = 128; // serializeJson() output per client write
+
+// --- Clients ---
+#ifdef MQTT_LOCAL_BROKER
+static WiFiClient wifiClient;
+static PubSubClient mqttClient(wifiClient);
+#else
+static WiFiClientSecure wifiClientSecure;
+static PubSubClient mqttClient(wifiClientSecure);
+#endif
+
+// The session as the status publisher sees it.
+class PubSubLink : public MessageLink {
+ public:
+  explicit PubSubLink(PubSubClient& client) : client(client) {}
+
+  bool connected() { return client.connected(); }
+  bool publish(const char* topic, const char* payload) { return client.publish(topic, payload); }
+  bool beginPublish(const char* topic, size_t length) { return client.beginPublish(topic, length, false); }
+  void write(const uint8_t* data, size_t length) { client.write(data, length); }
+  bool endPublish() { return client.endPublish() > 0; }
+
+ private:
+  PubSubClient& client;
+};
+static PubSubLink mqttLink(mqttClient);
+
+// Gathers serializeJson()'s output, which comes a token at a time, into
+// writes of TELEMETRY_CHUNK_SIZE: PubSubClient hands every write straight to
+// the (TLS) client.
+class ChunkedPublish : public Print {
+ public:
+  explicit ChunkedPublish(PubSubClient& client) : client(client), used(0) {}
+
+  size_t write(uint8_t byte) {
+    if (used == sizeof(chunk)) {
+      flush();
+    }
+    chunk[used++] = byte;
+    return 1;
+  }
+
+  void flush() {
+    if (used > 0) {
+      client.write(chunk, used);
+      used = 0;
+    }
+  }
+
+ private:
+  PubSubClient& client;
+  uint8_t chunk[TELEMETRY_CHUNK_SIZE];
+  size_t used;
+};
+
+// Armed after every connection attempt; no callback, it only holds off retries.
+static Timer reconnectCooldown;
+static char validateReplyTopic[64];
+static char deviceId[13]; // MAC in lower-case hex, no separators
+static StatusPublisher statusPublisher;
 
 // --- Forward Declarations ---
 void reconnectMqtt();
+void publishCommandAck(const char* correlationId, const char* command, int lane, bool accepted,
+                       int64_t receivedUs, int64_t actuatedUs);
 void mqttCallback(char* topic, byte* payload, unsigned int length); // <-- FIX: Added forward declaration
 
 // --- Callback Function (Handles incoming messages) ---
+// door_open accepts either the bare word OPEN or a JSON command carrying an
+// optional correlation ID and lane, e.g. {"cmd":"OPEN","id":"c-1042","lane":"exit"}.
+// Commands without a lane go to the entry gate. Every command is answered on
+// the ack topic, echoing the ID.
 void mqttCallback(char* topic, byte* payload, unsigned int length) {
-  String message;
-  for (int i = 0; i < length; i++) {
-    message += (char)payload[i];
+  int64_t receivedUs = traceNowUs();
+  HeapScope heapScope(HEAP_MODULE_NETWORK);
+  char message[MAX_COMMAND_LENGTH + 1];
+  unsigned int messageLength = length < MAX_COMMAND_LENGTH ? length : MAX_COMMAND_LENGTH;
+  memcpy(message, payload, messageLength);
+  message[messageLength] = '\0';
+
+  LOG_DEBUG(NET_MQTT_RX, topic, message);
+
+  if (strcmp(topic, validateReplyTopic) == 0) {
+    handleValidationReply(message);
+    return;
+  }
+  if (strcmp(topic, MQTT_SUBSCRIBE_TOPIC) != 0) {
+    return;
   }
-  
-  Serial.printf("Message Received! Topic: %s, Payload: %s\n", topic, message.c_str());
 
-  if (strcmp(topic, MQTT_SUBSCRIBE_TOPIC) == 0) {
-    if (message.equalsIgnoreCase("OPEN")) {
-      Serial.println("Network Handler: OPEN command received. Triggering gate.");
-      openGate();
-    } else {
-      Serial.println("Network Handler: Unknown command received.");
+  const char* command = message;
+  const char* correlationId = NULL;
+  int lane = GATE_LANE_ENTRY;
+  StaticJsonDocument<256> commandDoc;
+  if (message[0] == '{') {
+    DeserializationError error = deserializeJson(commandDoc, message);
+    if (error) {
+      LOG_WARN(NET_BAD_COMMAND, error.c_str());
+      publishCommandAck(NULL, "", -1, false, receivedUs, 0);
+      return;
+    }
+    command = commandDoc["cmd"] | "";
+    correlationId = commandDoc["id"] | (const char*)NULL;
+    const char* laneName = commandDoc["lane"] | (const char*)NULL;
+    if (laneName != NULL) {
+      lane = findGateLane(laneName);
     }
   }
+
+  if (strcasecmp(command, "OPEN") == 0 && lane >= 0) {
+    LOG_INFO(NET_OPEN_LANE_CMD, getGateLaneName(lane));
+    openGate(lane);
+    publishCommandAck(correlationId, command, lane, true, receivedUs, traceNowUs());
+  } else {
+    LOG_WARN(NET_UNKNOWN_CMD);
+    publishCommandAck(correlationId, command, lane, false, receivedUs, 0);
+  }
+}
+
+#ifdef STATUS_ENCODING_BENCHMARK
+// Compiled in with -DSTATUS_ENCODING_BENCHMARK: encodes a status document in
+// every format at boot, for this site and for a MAX_SLOTS one, then patches
+// the site's template, and logs the size and time of each as
+// NET_ENCODING_BENCH records.
+const int ENCODING_BENCHMARK_PASSES = 200;
+
+static void discardStatusChunk(const uint8_t* data, size_t length, void* context) {
+  (void)data;
+  (void)length;
+  (void)context;
+}
+
+// Times measuring plus writing, which is what a publish costs.
+static void timeStatusEncoding(StatusFormat format, int slotCount) {
+  OccupancyBits occupied;
+  for (int slot = 0; slot < slotCount; slot++) {
+    occupied.set(slot, esp_random() & 1);
+  }
+  StatusDocument document = { deviceId, 1, &occupied, &getSensedSlots(), slotCount, NULL, true, 1 };
+  size_t length = 0;
+  uint32_t startCycles = systemClock.cycleCount();
+  for (int pass = 0; pass < ENCODING_BENCHMARK_PASSES; pass++) {
+    length = measureStatusDocument(document, format);
+    writeStatusDocument(document, format, discardStatusChunk, NULL);
+  }
+  uint32_t cycles = systemClock.cycleCount() - startCycles;
+  uint32_t ns = (uint32_t)((uint64_t)cycles * 1000 / systemClock.cyclesPerUs() / ENCODING_BENCHMARK_PASSES);
+  LOG_INFO(NET_ENCODING_BENCH, statusFormatName(format), slotCount, (unsigned int)length, ns);
 }
 
+// Times a full JSON document patched into the template, one slot changing
+// per pass as it does when a car arrives or leaves.
+static void timeStatusTemplate(int slotCount) {
+  if (!statusTemplate.build(deviceId, slotCount)) {
+    return;
+  }
+  OccupancyBits occupied;
+  occupied.fill();
+  StatusDocument document = { deviceId, 1, &occupied, &getSensedSlots(), slotCount, NULL, true, 1 };
+  uint32_t startCycles = systemClock.cycleCount();
+  for (int pass = 0; pass < ENCODING_BENCHMARK_PASSES; pass++) {
+    int slot = pass % slotCount;
+    occupied.set(slot, !occupied.test(slot));
+    document.seq = pass;
+    statusTemplate.patch(document);
+  }
+  uint32_t cycles = systemClock.cycleCount() - startCycles;
+  uint32_t ns = (uint32_t)((uint64_t)cycles * 1000 / systemClock.cyclesPerUs() / ENCODING_BENCHMARK_PASSES);
+  LOG_INFO(NET_ENCODING_BENCH, "json template", slotCount, (unsigned int)statusTemplate.length(), ns);
+}
+
+static void runEncodingBenchmark() {
+  for (int format = 0; format < STATUS_FORMAT_COUNT; format++) {
+    timeStatusEncoding((StatusFormat)format, getSlotCount());
+    timeStatusEncoding((StatusFormat)format, MAX_SLOTS);
+  }
+  timeStatusTemplate(getSlotCount());
+}
+#endif
+
 // --- Setup Function ---
 void setupNetwork() {
-  Serial.print("Connecting to WiFi...");
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  LOG_INFO(NET_WIFI_CONNECTING, WIFI_SSID);
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD, 0, NULL, false); // Configure only: the listen interval goes out when associating
+  configureRadioPower();
+  WiFi.reconnect();
   while (WiFi.status() != WL_CONNECTED) {
     delay(500);
-    Serial.print(".");
+    LOG_DEBUG(NET_WIFI_WAITING, (int)WiFi.status());
   }
-  Serial.println("\nWiFi Connected.");
+  LOG_INFO(NET_WIFI_CONNECTED);
+  setupTrace();
 
+  String mac = WiFi.macAddress();
+  mac.replace(":", "");
+  mac.toLowerCase();
+  snprintf(deviceId, sizeof(deviceId), "%s", mac.c_str());
+  snprintf(validateReplyTopic, sizeof(validateReplyTopic), MQTT_VALIDATE_REPLY_FORMAT, deviceId);
+  statusPublisher.begin(deviceId, STATUS_CONFIG, getSensedSlots(), mqttLink, systemTimers, systemClock);
+#ifdef STATUS_ENCODING_BENCHMARK
+  runEncodingBenchmark();
+#endif
+
+#ifndef MQTT_LOCAL_BROKER
   wifiClientSecure.setInsecure();
+#endif
   mqttClient.setServer(MQTT_BROKER, MQTT_PORT);
+  mqttClient.setBufferSize(MQTT_BUFFER_SIZE); // Default 256 is too small for our JSON
+  mqttClient.setKeepAlive(getMqttKeepAliveSeconds());
   mqttClient.setCallback(mqttCallback);
 }
 
 // --- Main Loop Function ---
+// Runs every pass, so it carries no HeapScope: the entry points it reaches
+// (mqttCallback, reconnectMqtt) have their own.
 void networkLoop() {
-  if (!mqttClient.connected()) {
+  if (!mqttClient.connected() && !systemTimers.isArmed(reconnectCooldown)) {
     reconnectMqtt();
   }
   mqttClient.loop();
@@ -75,63 +297,78 @@ void networkLoop() {
 
 // --- Reconnect Function (Only one copy now) ---
 void reconnectMqtt() {
-    long now = millis();
-    if (now - lastReconnectAttempt > 5000) {
-        lastReconnectAttempt = now;
-        if (!mqttClient.connected()) {
-            Serial.print("Attempting MQTT connection...");
-            String clientId = "ESP32-Parking-Client-";
-            clientId += String(random(0xffff), HEX);
-            
-            if (mqttClient.connect(clientId.c_str(), MQTT_USER, MQTT_PASSWORD)) {
-                Serial.println("connected!");
-                mqttClient.subscribe(MQTT_SUBSCRIBE_TOPIC);
-                Serial.printf("Subscribed to: %s\n", MQTT_SUBSCRIBE_TOPIC);
-            } else {
-                Serial.printf("failed, rc=%d try again in 5 seconds\n", mqttClient.state());
-            }
-        }
+    HeapScope heapScope(HEAP_MODULE_NETWORK);
+    systemTimers.arm(reconnectCooldown, MQTT_RECONNECT_INTERVAL);
+
+    char clientId[32];
+    snprintf(clientId, sizeof(clientId), "ESP32-Parking-Client-%lx", random(0xffff));
+    LOG_INFO(NET_MQTT_CONNECTING, clientId);
+
+    if (mqttClient.connect(clientId, MQTT_USER, MQTT_PASSWORD)) {
+        mqttClient.subscribe(MQTT_SUBSCRIBE_TOPIC);
+        mqttClient.subscribe(validateReplyTopic);
+        LOG_INFO(NET_MQTT_CONNECTED, MQTT_SUBSCRIBE_TOPIC);
+        statusPublisher.connected();
+    } else {
+        LOG_WARN(NET_MQTT_FAILED, mqttClient.state());
     }
 }
 
 // --- Publish Function ---
-void publishSlotStatus(const bool realSlotStates[NUM_REAL_SENSORS]) {
-  Serial.println("-> Entered publishSlotStatus function.");
+void publishSlotStatus(const OccupancyBits& occupied, int slotCount, const SlotTrace& trace) {
+  statusPublisher.publish(occupied, slotCount, trace);
+}
+
+// --- Command Ack Function ---
+// Tells the sender whether the command was carried out, when it arrived, when
+// the servo was commanded and what state the addressed gate is in now.
+void publishCommandAck(const char* correlationId, const char* command, int lane, bool accepted,
+                       int64_t receivedUs, int64_t actuatedUs) {
+  StaticJsonDocument<256> ackDoc;
+  ackDoc["id"] = correlationId; // null when the command had none
+  ackDoc["cmd"] = command;
+  ackDoc["result"] = accepted ? "ok" : "rejected";
+  ackDoc["synced"] = isTraceClockSynced();
+  ackDoc["receivedUs"] = receivedUs;
+  if (accepted) {
+    ackDoc["actuatedUs"] = actuatedUs;
+  }
+  if (lane >= 0) {
+    ackDoc["lane"] = getGateLaneName(lane);
+    ackDoc["gate"] = gateIsOpen(lane) ? "open" : "closed";
+  }
+  char ackBuffer[256];
+  serializeJson(ackDoc, ackBuffer);
+  mqttClient.publish(MQTT_PUBLISH_TOPIC_ACK, ackBuffer);
+}
+
+// --- Telemetry Publish Function ---
+void publishTelemetry(const JsonDocument& doc) {
   if (!mqttClient.connected()) {
-    Serial.println("   [DEBUG] MQTT client not connected. Aborting publish.");
     return;
   }
-
-  StaticJsonDocument<1024> doc;
-  JsonArray slotsArray = doc.createNestedArray("slots");
-
-  for (int i = 0; i < TOTAL_SLOTS; i++) {
-    int currentSlotNumber = i + 1;
-    JsonObject slotObject = slotsArray.createNestedObject();
-    slotObject["slotNumber"] = currentSlotNumber;
-
-    int sensorIndex = -1;
-    for (int j = 0; j < NUM_REAL_SENSORS; j++) {
-      if (REAL_SLOT_MAPPING[j] == currentSlotNumber) {
-        sensorIndex = j;
-        break;
-      }
-    }
-
-    if (sensorIndex != -1) {
-      slotObject["status"] = realSlotStates[sensorIndex] ? "occupied" : "available";
-    } else {
-      slotObject["status"] = "occupied";
-    }
+  HeapScope heapScope(HEAP_MODULE_NETWORK);
+  // Streamed: the document outgrew MQTT_BUFFER_SIZE, which publish() needs it
+  // to fit in, and its text is never held in memory as a whole.
+  mqttClient.beginPublish(MQTT_PUBLISH_TOPIC_TELEMETRY, measureJson(doc), false);
+  ChunkedPublish out(mqttClient);
+  serializeJson(doc, out);
+  out.flush();
+  mqttClient.endPublish();
+}
+// --- Validation RPC ---
+bool publishValidationRequest(uint32_t id, const char* uid, const char* reader) {
+  if (!mqttClient.connected()) {
+    return false;
   }
+  HeapScope heapScope(HEAP_MODULE_NETWORK);
+  StaticJsonDocument<192> requestDoc;
+  requestDoc["id"] = id;
+  requestDoc["uid"] = uid;
+  requestDoc["reader"] = reader;
+  requestDoc["replyTo"] = (const char*)validateReplyTopic;
 
-  char jsonBuffer[1024];
-  serializeJson(doc, jsonBuffer);
-
-  Serial.println("   [DEBUG] JSON payload created successfully. Contents:");
-  Serial.println(jsonBuffer);
-  Serial.printf("   [DEBUG] Publishing to topic: %s\n", MQTT_PUBLISH_TOPIC_SLOTS);
-  mqttClient.publish(MQTT_PUBLISH_TOPIC_SLOTS, "test");
-  mqttClient.publish(MQTT_PUBLISH_TOPIC_SLOTS, jsonBuffer);
-  Serial.println("<- Exiting publishSlotStatus function.");
-}
\ No newline at end of file
+  char requestBuffer[192];
+  serializeJson(requestDoc, requestBuffer);
+  return mqttClient.publish(MQTT_PUBLISH_TOPIC_VALIDATE, requestBuffer);
+}
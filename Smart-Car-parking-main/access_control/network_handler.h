@@ -1,15 +1,33 @@
 #ifndef NETWORK_HANDLER_H
 #define NETWORK_HANDLER_H
 
-// The number of real sensors we have connected.
-// We define it here so both handlers can see it.
-const int NUM_REAL_SENSORS = 7;
+#include <ArduinoJson.h>
+#include "trace.h"
+#include "occupancy.h"
 
 void setupNetwork();
 void networkLoop();
 
 // This is our new function for publishing the full slot status.
-// It takes an array of boolean states from the slot_handler.
-void publishSlotStatus(const bool realSlotStates[NUM_REAL_SENSORS]);
+// It takes the occupancy of the first slotCount slots from the slot_handler,
+// plus the trace of the change that caused it, which is reported on the trace topic.
+// Documents carry the device ID and a sequence number and go out as JSON, plus
+// CBOR and packed bitsets on topics of their own with -DSLOT_STATUS_BINARY;
+// with -DSLOT_STATUS_DELTAS most JSON documents list only the changed slots.
+// See status_document.h for the formats.
+void publishSlotStatus(const OccupancyBits& occupied, int slotCount, const SlotTrace& trace);
+
+// Publishes a telemetry document built by the telemetry module, serialized
+// straight into the MQTT session rather than into a buffer first.
+void publishTelemetry(const JsonDocument& doc);
+
+// Asks the backend whether a card may enter, over the MQTT session rather
+// than a connection of its own:
+//   request on parking/esp32/validate:
+//     {"id":1234,"uid":"4A3B2C1D","reader":"entry","replyTo":"parking/esp32/<mac>/validate/reply"}
+//   reply on replyTo:
+//     {"id":1234,"allow":true}
+// Replies are passed to handleValidationReply(). Returns false if offline.
+bool publishValidationRequest(uint32_t id, const char* uid, const char* reader);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Largest site one controller can report. Each slot costs one bit.
+const int MAX_SLOTS = 512;
+
+// One bit per slot, set while the slot is occupied. Slot i is bit i % 8 of
+// byte i / 8, so sensor backends that read whole bytes (shift registers,
+// expander ports) can write them straight into bytes().
+class OccupancyBits {
+ public:
+  OccupancyBits() { clear(); }
+
+  void clear() { memset(data, 0, sizeof(data)); }
+  void fill() { memset(data, 0xFF, sizeof(data)); }
+
+  bool test(int slot) const { return (data[slot >> 3] >> (slot & 7)) & 1; }
+
+  void set(int slot, bool occupied) {
+    uint8_t mask = 1 << (slot & 7);
+    if (occupied) {
+      data[slot >> 3] |= mask;
+    } else {
+      data[slot >> 3] &= ~mask;
+    }
+  }
+
+  uint8_t* bytes() { return data; }
+  const uint8_t* bytes() const { return data; }
+
+  bool operator==(const OccupancyBits& other) const { return memcmp(data, other.data, sizeof(data)) == 0; }
+  bool operator!=(const OccupancyBits& other) const { return !(*this == other); }
+
+ private:
+  uint8_t data[MAX_SLOTS / 8];
+};
+
+#endif
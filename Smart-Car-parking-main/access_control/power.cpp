@@ -0,0 +1,177 @@
+#include "power.h"
+#include "logger.h"
+#include "system_state.h"
+#include <WiFi.h>
+#include <esp_wifi.h>
+#include <driver/gpio.h>
+#include <soc/gpio_struct.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Light sleep needs power management and tickless idle compiled into the core.
+#if POWER_MODE == POWER_LIGHT_SLEEP && CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE
+#define POWER_LIGHT_SLEEP_BUILD
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#endif
+
+// --- Constants ---
+#if POWER_MODE == POWER_PERFORMANCE
+const char* const POWER_MODE_NAME = "performance";
+const TimeMs POWER_IDLE_CAP_MS = 10;
+const uint16_t POWER_MQTT_KEEPALIVE_S = 15; // PubSubClient's default
+#elif POWER_MODE == POWER_MODEM_SLEEP
+const char* const POWER_MODE_NAME = "modem-sleep";
+const TimeMs POWER_IDLE_CAP_MS = 50;
+const uint16_t POWER_MQTT_KEEPALIVE_S = 60;
+#else
+const char* const POWER_MODE_NAME = "light-sleep";
+const TimeMs POWER_IDLE_CAP_MS = 100;
+const uint16_t POWER_MQTT_KEEPALIVE_S = 60;
+#endif
+const TimeMs POWER_BUSY_IDLE_MS = 10;       // While a gate is busy, as the loop always ran
+const uint16_t POWER_LISTEN_INTERVAL = 3;   // Beacons the radio sleeps through in modem sleep
+const int MAX_WAKE_LINES = 8;
+
+// --- State ---
+static TaskHandle_t loopTask = NULL;
+static int wakeLines[MAX_WAKE_LINES];
+static int wakeLineCount = 0;
+static PowerStats stats = { POWER_MODE_NAME, 0, 0, 0 };
+
+#ifdef POWER_LIGHT_SLEEP_BUILD
+static bool lightSleep = false;        // esp_pm accepted the configuration
+static esp_pm_lock_handle_t busyLock;  // Held while a gate is busy: no light sleep
+static bool busyLockHeld = false;
+#endif
+
+void setupPower() {
+  loopTask = xTaskGetCurrentTaskHandle();
+#ifdef POWER_LIGHT_SLEEP_BUILD
+  // An 80 MHz floor keeps the APB clock, and with it the servo PWM, unchanged.
+  esp_pm_config_esp32_t config = { 240, 80, true };
+  if (esp_pm_configure(&config) == ESP_OK &&
+      esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "gate", &busyLock) == ESP_OK) {
+    esp_sleep_enable_gpio_wakeup();
+    lightSleep = true;
+  } else {
+    LOG_WARN(POWER_LIGHT_SLEEP_UNAVAILABLE);
+  }
+#elif POWER_MODE == POWER_LIGHT_SLEEP
+  LOG_WARN(POWER_LIGHT_SLEEP_UNAVAILABLE);
+#endif
+  LOG_INFO(POWER_MODE_SELECTED, POWER_MODE_NAME, (unsigned int)POWER_IDLE_CAP_MS);
+}
+
+void configureRadioPower() {
+#if POWER_MODE == POWER_PERFORMANCE
+  WiFi.setSleep(WIFI_PS_NONE); // The core would otherwise wake the radio only per beacon
+#else
+  WiFi.setSleep(WIFI_PS_MAX_MODEM); // Sleep for listen_interval beacons, not just to the next DTIM
+  wifi_config_t config;
+  if (esp_wifi_get_config(WIFI_IF_STA, &config) == ESP_OK) {
+    config.sta.listen_interval = POWER_LISTEN_INTERVAL;
+    esp_wifi_set_config(WIFI_IF_STA, &config);
+  }
+#endif
+}
+
+uint16_t getMqttKeepAliveSeconds() {
+  return POWER_MQTT_KEEPALIVE_S;
+}
+
+void IRAM_ATTR wakeLoopFromISR() {
+  if (loopTask == NULL) {
+    return;
+  }
+  BaseType_t higherPriorityWoken = pdFALSE;
+  vTaskNotifyGiveFromISR(loopTask, &higherPriorityWoken);
+  if (higherPriorityWoken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+// Only armed while the loop idles. The line stays low until it is serviced,
+// so the level interrupt silences itself before waking the loop.
+static void IRAM_ATTR onWakeLine(void* arg) {
+  int pin = (int)(intptr_t)arg;
+  GPIO.pin[pin].int_type = GPIO_INTR_DISABLE;
+  wakeLoopFromISR();
+}
+
+void registerWakeLine(int pin) {
+  for (int i = 0; i < wakeLineCount; i++) {
+    if (wakeLines[i] == pin) {
+      return; // Shared line, already registered
+    }
+  }
+  if (wakeLineCount >= MAX_WAKE_LINES) {
+    return;
+  }
+  wakeLines[wakeLineCount++] = pin;
+  gpio_install_isr_service(0); // Fails harmlessly if attachInterrupt() already installed it
+  gpio_set_intr_type((gpio_num_t)pin, GPIO_INTR_DISABLE);
+  gpio_isr_handler_add((gpio_num_t)pin, onWakeLine, (void*)(intptr_t)pin);
+  gpio_intr_enable((gpio_num_t)pin);
+}
+
+// A line that is already low fires at once, so pending work is never slept through.
+static void armWakeLines() {
+  for (int i = 0; i < wakeLineCount; i++) {
+    gpio_num_t pin = (gpio_num_t)wakeLines[i];
+#ifdef POWER_LIGHT_SLEEP_BUILD
+    if (lightSleep) {
+      gpio_wakeup_enable(pin, GPIO_INTR_LOW_LEVEL); // Sets the interrupt type too
+      continue;
+    }
+#endif
+    gpio_set_intr_type(pin, GPIO_INTR_LOW_LEVEL);
+  }
+}
+
+static void disarmWakeLines() {
+  for (int i = 0; i < wakeLineCount; i++) {
+    gpio_num_t pin = (gpio_num_t)wakeLines[i];
+#ifdef POWER_LIGHT_SLEEP_BUILD
+    if (lightSleep) {
+      gpio_wakeup_disable(pin);
+    }
+#endif
+    gpio_set_intr_type(pin, GPIO_INTR_DISABLE);
+  }
+}
+
+void powerIdle(bool busy) {
+#ifdef POWER_LIGHT_SLEEP_BUILD
+  if (lightSleep && busy != busyLockHeld) {
+    if (busy) {
+      esp_pm_lock_acquire(busyLock);
+    } else {
+      esp_pm_lock_release(busyLock);
+    }
+    busyLockHeld = busy;
+  }
+#endif
+
+  // The wheel's time is that of the last advance(); this loop pass has
+  // already used part of the wait.
+  TimeMs untilNext = systemTimers.timeUntilNext(busy ? POWER_BUSY_IDLE_MS : POWER_IDLE_CAP_MS);
+  TimeMs spent = timeElapsed(millis(), systemTimers.now());
+  if (spent >= untilNext) {
+    return; // A deadline is already due
+  }
+
+  armWakeLines();
+  TimeMs start = millis();
+  // Sensor and wake-line interrupts notify the loop task to end the wait.
+  if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(untilNext - spent)) > 0) {
+    stats.earlyWakes++;
+  }
+  disarmWakeLines();
+  stats.idleMs += timeElapsed(millis(), start);
+  stats.idleCalls++;
+}
+
+PowerStats getPowerStats() {
+  return stats;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+// --- Power Modes ---
+// Pick one at build time, e.g. -DPOWER_MODE=POWER_MODEM_SLEEP. The latency
+// each costs (AP beacon every 102.4 ms, quiet lot sampled every 200 ms):
+//
+//  POWER_PERFORMANCE  Radio always on; the loop runs at least every 10 ms.
+//                     Commands +5 ms mean, 10 ms worst.
+//  POWER_MODEM_SLEEP  Radio wakes for every 3rd DTIM beacon and MQTT pings
+//                     once a minute; the loop idles until its next timer
+//                     deadline, at most 50 ms. Commands wait at the AP for
+//                     the radio: +177 ms mean, 355 ms worst. Sensor
+//                     interrupts still wake the loop at once.
+//  POWER_LIGHT_SLEEP  Modem sleep, and the CPU light-sleeps while the loop
+//                     idles (up to 100 ms). Commands +205 ms mean, 407 ms
+//                     worst. Wake lines (expander INT, RFID IRQ) resume it
+//                     in ~1 ms, but edge interrupts cannot wake light sleep:
+//                     direct GPIO sensors are seen at the next sample, up to
+//                     200 ms. Needs a core built with CONFIG_PM_ENABLE and
+//                     tickless idle; otherwise it runs as modem sleep. Not
+//                     for sites with ultrasonic sensors: the build refuses.
+//
+// tools/power_sim.py models these figures.
+//
+// Publishing is never delayed: the radio wakes for outgoing data. While a
+// gate is busy the loop runs every 10 ms and never light-sleeps.
+#define POWER_PERFORMANCE 0
+#define POWER_MODEM_SLEEP 1
+#define POWER_LIGHT_SLEEP 2
+
+#ifndef POWER_MODE
+#define POWER_MODE POWER_PERFORMANCE
+#endif
+
+struct PowerStats {
+  const char* mode;
+  uint32_t idleCalls;
+  uint32_t idleMs;      // Time the loop spent idle
+  uint32_t earlyWakes;  // Idles cut short by an interrupt
+};
+
+// Call first in setup(), from the loop task.
+void setupPower();
+
+// Radio power save and listen interval. Call after WiFi.begin(..., false)
+// and before connecting: the listen interval is sent when associating.
+void configureRadioPower();
+
+uint16_t getMqttKeepAliveSeconds();
+
+// An active-low line that stays low until it is serviced (an open-drain INT
+// or IRQ output). While the loop idles it wakes the loop, and the CPU from
+// light sleep. The line must not have an interrupt handler of its own.
+void registerWakeLine(int pin);
+
+// Ends the current idle early. Safe to call from an interrupt.
+void IRAM_ATTR wakeLoopFromISR();
+
+// Idles the loop until the next timer deadline, an interrupt, or the mode's
+// cap. 'busy' keeps the loop at 10 ms and the CPU out of light sleep.
+void powerIdle(bool busy);
+
+PowerStats getPowerStats();
+
+#endif
\ No newline at end of file
@@ -1,48 +1,157 @@
 #include <Arduino.h>
 #include <SPI.h>
-#include <MFRC522.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
+#include <ArduinoJson.h>
 
 #include "rfid_handler.h"
 #include "gate_handler.h" // We need to include this to call openGate()
+#include "network_handler.h"
+#include "rpc_table.h"
+#include "scan_filter.h"
 #include "system_state.h"
-// --- Pin Definitions ---
-#define SS_PIN    5 
-#define RST_PIN   21
+#include "logger.h"
+#include "heap_tracker.h"
+#include "power.h"
+
+// --- Reader Definitions ---
+// All readers share the VSPI host (SCK 18, MISO 19, MOSI 23) and one reset
+// line. Their IRQ outputs are open drain, so they share one line too. Nothing
+// else uses VSPI (the shift register chain has HSPI to itself) and every
+// transfer runs on the loop task, so the readers never wait for the bus.
+// The exit reader's SS is 17, the shift register chain's load pin: a site
+// with both moves one of them. Keep SS off the strapping pins.
+static const RfidReaderConfig RFID_READERS[] = {
+  // name     SS  RST IRQ  lane
+  { "entry",  5,  21, 22,  GATE_LANE_ENTRY },
+#ifdef GATE_EXIT_LANE
+  { "exit",   17, 21, 22,  GATE_LANE_EXIT },
+#endif
+};
+const int RFID_READER_COUNT = sizeof(RFID_READERS) / sizeof(RFID_READERS[0]);
+
+// --- Constants ---
+// How often each reader sends a REQA to look for a card. Readers take turns,
+// one per RFID_REQUEST_INTERVAL / RFID_READER_COUNT, so the bus sees an even
+// trickle of requests. A reader raises IRQ when a card answers, so this only
+// bounds how long a card waits to be noticed.
+const TimeMs RFID_REQUEST_INTERVAL = 100;
+const size_t RFID_UID_LENGTH = 21; // 10 bytes in hex, plus the terminator
+const unsigned int RFID_RESET_PULSE_US = 2;  // Hard reset: RST low for at least 100 ns
+const unsigned long RFID_OSCILLATOR_START_MS = 50; // The library's allowance after a hard reset
+// A backend on the LAN answers in tens of ms; past this the card is refused
+// and the driver can simply tap again.
+const TimeMs RFID_RPC_TIMEOUT = 2000;
+// A granted card held on the reader, or tapped twice, is validated once per
+// window; a refused one is validated again at the next tap.
+// Anti-passback remembers each card's last entry or exit for half a day.
+const ScanFilterConfig RFID_SCAN_FILTER = { 3000, 12UL * 60 * 60 * 1000 };
 
 // --- Module-specific (static) Variables ---
-static MFRC522 mfrc522(SS_PIN, RST_PIN);
+static RfidReader readers[RFID_READER_COUNT];
+static int nextReader = 0;   // Whose turn it is to send a request
+static int lastRequest = 0;  // Who sent the latest one: the likeliest to have an answer
 static HTTPClient http;
+static void onRequestTimer(void*);
+static Timer requestTimer(onRequestTimer);
+static ScanFilter scanFilter(RFID_SCAN_FILTER);
 
-// This tells the compiler that this variable exists, but it's defined
-// in another file (our main AccessControl.ino). This is how we share it.
-extern String GOOGLE_SCRIPT_URL;
+// The scan behind each pending validation, so a late grant can record the
+// passage. Indexed by the RpcTable context; both tables have SIZE entries.
+struct PendingScan {
+  CardUid uid;
+  int reader;
+  bool used;
+};
+static PendingScan pendingScans[RpcTable::SIZE];
+static void onValidationTimeout(uint32_t id, int scan);
+static RpcTable pendingValidations(onValidationTimeout); // Context: index into pendingScans
+static RfidRpcStats rpcStats = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+// One reader per tick, round robin.
+static void onRequestTimer(void*) {
+  systemTimers.arm(requestTimer, RFID_REQUEST_INTERVAL / RFID_READER_COUNT);
+  readers[nextReader].requestCard();
+  lastRequest = nextReader;
+  nextReader = (nextReader + 1) % RFID_READER_COUNT;
+}
 
 // Initializes the RFID reader hardware.
 void setupRfid() {
   SPI.begin();
-  mfrc522.PCD_Init();
+  for (int i = 0; i < RFID_READER_COUNT; i++) {
+    pinMode(RFID_READERS[i].ssPin, OUTPUT);
+    digitalWrite(RFID_READERS[i].ssPin, HIGH); // Keep every reader off the bus while the others start
+  }
+  // Reset every reader once through the shared line and leave it driven
+  // high. The readers then start with a soft reset and never touch it: the
+  // MFRC522 library would turn it back into an input.
+  for (int i = 0; i < RFID_READER_COUNT; i++) {
+    pinMode(RFID_READERS[i].rstPin, OUTPUT);
+    digitalWrite(RFID_READERS[i].rstPin, LOW);
+  }
+  delayMicroseconds(RFID_RESET_PULSE_US);
+  for (int i = 0; i < RFID_READER_COUNT; i++) {
+    digitalWrite(RFID_READERS[i].rstPin, HIGH);
+  }
+  delay(RFID_OSCILLATOR_START_MS);
+  for (int i = 0; i < RFID_READER_COUNT; i++) {
+    pinMode(RFID_READERS[i].irqPin, INPUT_PULLUP);
+    readers[i].begin(RFID_READERS[i]);
+    registerWakeLine(RFID_READERS[i].irqPin); // The line stays low until cleared
+  }
+  systemTimers.arm(requestTimer, RFID_REQUEST_INTERVAL / RFID_READER_COUNT);
+  pendingValidations.begin(esp_random()); // Replies meant for a previous boot match nothing
 }
 
-// This function is called continuously from the main loop().
-void handleRfid() {
-  // Look for a new card
-  if (!mfrc522.PICC_IsNewCardPresent() || !mfrc522.PICC_ReadCardSerial()) {
-    return; // No card present, so just exit the function.
-  }
+static PassDirection readerDirection(int reader) {
+  return readers[reader].lane() == GATE_LANE_ENTRY ? PASS_IN : PASS_OUT;
+}
 
-  // --- A card has been detected, process it ---
-  String scannedUID = "";
-  for (byte i = 0; i < mfrc522.uid.size; i++) {
-    scannedUID += String(mfrc522.uid.uidByte[i], HEX);
+static void grantEntry(int reader, const CardUid& uid) {
+  // Validation successful! Tell the gate handler to open the gate.
+  LOG_INFO(RFID_GRANTED);
+  scanFilter.recordPassage(uid, readerDirection(reader), millis());
+  openGate(readers[reader].lane());
+}
+
+#ifdef RFID_VALIDATION_RPC
+// Sends the request and returns; the reply or the timeout finishes the job.
+static void validateCard(int readerIndex, const CardUid& uid, const char* uidText) {
+  int scan = 0;
+  while (scan < RpcTable::SIZE && pendingScans[scan].used) {
+    scan++;
+  }
+  uint32_t id = scan < RpcTable::SIZE ? pendingValidations.add(scan, RFID_RPC_TIMEOUT) : 0;
+  if (id == 0) {
+    scanFilter.forget(uid);
+    rpcStats.rejected++;
+    LOG_WARN(RFID_RPC_NOT_SENT, readers[readerIndex].name(), "too many pending");
+    return;
+  }
+  if (!publishValidationRequest(id, uidText, readers[readerIndex].name())) {
+    int context;
+    TimeMs elapsedMs;
+    pendingValidations.complete(id, context, elapsedMs);
+    scanFilter.forget(uid);
+    rpcStats.rejected++;
+    LOG_WARN(RFID_RPC_NOT_SENT, readers[readerIndex].name(), "offline");
+    return;
   }
-  scannedUID.toUpperCase();
-  Serial.print("RFID Handler: Card scanned, UID: ");
-  Serial.println(scannedUID);
+  pendingScans[scan].uid = uid;
+  pendingScans[scan].reader = readerIndex;
+  pendingScans[scan].used = true;
+  rpcStats.requests++;
+}
+#else
+// This tells the compiler that this variable exists, but it's defined
+// in another file (our main AccessControl.ino). This is how we share it.
+extern String GOOGLE_SCRIPT_URL;
 
+// Asks the validation script about a card and opens the reader's lane.
+static void validateCard(int readerIndex, const CardUid& uid, const char* uidText) {
   // Send the UID to Google Sheets for validation
-  String url = GOOGLE_SCRIPT_URL + "?uid=" + scannedUID;
+  String url = GOOGLE_SCRIPT_URL + "?uid=" + uidText;
   http.begin(url);
   http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
   
@@ -50,21 +159,125 @@ void handleRfid() {
   
   if (httpCode > 0 && (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY)) {
     String payload = http.getString();
-    Serial.print("RFID Handler: Response from server: ");
-    Serial.println(payload);
+    LOG_DEBUG(RFID_RESPONSE, payload.c_str());
 
     if (payload == "yes") {
-      // Validation successful! Tell the gate handler to open the gate.
-            Serial.println("RFID Handler: Access Granted.");
-      userJustValidated = true; // <-- Set the flag for the other module
-      openGate();
+      grantEntry(readerIndex, uid);
     } else {
-      Serial.println("RFID Handler: Access Denied.");
+      scanFilter.forget(uid);
+      LOG_INFO(RFID_DENIED);
     }
   } else {
-    Serial.printf("RFID Handler: HTTP request failed, error: %s\n", http.errorToString(httpCode).c_str());
+    scanFilter.forget(uid); // Let the driver tap again at once
+    LOG_WARN(RFID_HTTP_FAILED, httpCode);
   }
 
   http.end();
-  mfrc522.PICC_HaltA();
-}
\ No newline at end of file
+}
+#endif
+
+static void onValidationTimeout(uint32_t id, int scan) {
+  pendingScans[scan].used = false;
+  scanFilter.forget(pendingScans[scan].uid);
+  rpcStats.timeouts++;
+  LOG_WARN(RFID_RPC_TIMEOUT, readers[pendingScans[scan].reader].name(), (unsigned long)id);
+}
+
+// {"id":1234,"allow":true}
+void handleValidationReply(const char* json) {
+  StaticJsonDocument<128> replyDoc;
+  if (deserializeJson(replyDoc, json)) {
+    LOG_WARN(NET_BAD_COMMAND, json);
+    return;
+  }
+  int scan;
+  TimeMs elapsedMs;
+  if (!pendingValidations.complete(replyDoc["id"] | 0UL, scan, elapsedMs)) {
+    rpcStats.unmatched++;
+    return; // Already timed out, or not ours
+  }
+  pendingScans[scan].used = false;
+  int reader = pendingScans[scan].reader;
+  rpcStats.lastRoundTripMs = elapsedMs;
+  if (elapsedMs > rpcStats.maxRoundTripMs) {
+    rpcStats.maxRoundTripMs = elapsedMs;
+  }
+  LOG_DEBUG(RFID_RPC_REPLY, readers[reader].name(), (unsigned int)elapsedMs);
+  if (replyDoc["allow"] | false) {
+    rpcStats.granted++;
+    grantEntry(reader, pendingScans[scan].uid);
+  } else {
+    rpcStats.denied++;
+    scanFilter.forget(pendingScans[scan].uid);
+    LOG_INFO(RFID_DENIED);
+  }
+}
+
+// This function is called continuously from the main loop().
+void handleRfid() {
+  // Readers that share an IRQ line are asked in turn, starting with the one
+  // that sent the latest request.
+  int answered = -1;
+  for (int n = 0; n < RFID_READER_COUNT && answered < 0; n++) {
+    int i = (lastRequest + RFID_READER_COUNT - n) % RFID_READER_COUNT;
+    if (readers[i].cardAnswered()) { // Touches the bus only while the line is low
+      answered = i;
+    }
+  }
+  if (answered < 0) {
+    return;
+  }
+
+  HeapScope heapScope(HEAP_MODULE_RFID);
+  RfidReader& reader = readers[answered];
+  CardUid uid;
+  bool cardRead = reader.readCard(uid);
+  if (cardRead) {
+    reader.finishCard(); // A halted card ignores REQA until it is presented again
+  }
+  if (!cardRead) {
+    return; // Collision or the card left: the next request tries again.
+  }
+
+  // --- A card has been detected, process it ---
+  char uidText[RFID_UID_LENGTH];
+  formatCardUid(uid, uidText, sizeof(uidText));
+  ScanVerdict verdict = scanFilter.check(uid, readerDirection(answered), millis());
+  if (verdict == SCAN_REPEAT) {
+    LOG_DEBUG(RFID_SCAN_REPEAT, reader.name(), uidText);
+    return; // Being validated, or granted moments ago
+  }
+  LOG_INFO(RFID_READER_SCANNED, reader.name(), uidText);
+  if (verdict == SCAN_PASSBACK) {
+    LOG_WARN(RFID_PASSBACK, reader.name(), uidText);
+    return;
+  }
+  validateCard(answered, uid, uidText);
+}
+
+int getRfidReaderCount() {
+  return RFID_READER_COUNT;
+}
+
+const char* getRfidReaderName(int reader) {
+  if (reader < 0 || reader >= RFID_READER_COUNT) {
+    return "";
+  }
+  return RFID_READERS[reader].name;
+}
+
+RfidReaderStats getRfidReaderStats(int reader) {
+  return readers[reader].stats();
+}
+
+RfidRpcStats getRfidRpcStats() {
+  return rpcStats;
+}
+
+uint32_t getRfidSuppressedRepeats() {
+  return scanFilter.suppressedRepeats();
+}
+
+uint32_t getRfidPassbackRefusals() {
+  return scanFilter.passbackRefusals();
+}
@@ -1,11 +1,47 @@
 #ifndef RFID_HANDLER_H
 #define RFID_HANDLER_H
 
-// Initializes the RFID reader.
+#include <Arduino.h>
+#include "rfid_reader.h"
+#include "timer_wheel.h"
+
+// Validation round trips over MQTT (RFID_VALIDATION_RPC builds).
+struct RfidRpcStats {
+  uint32_t requests;
+  uint32_t granted;
+  uint32_t denied;
+  uint32_t timeouts;     // No reply within RFID_RPC_TIMEOUT: treated as denied
+  uint32_t unmatched;    // Replies for no pending request (late or duplicated)
+  uint32_t rejected;     // Table full or offline: not sent
+  TimeMs lastRoundTripMs;
+  TimeMs maxRoundTripMs;
+};
+
+// Initializes the RFID readers and starts looking for cards.
 void setupRfid();
 
-// Checks for new cards, validates them with Google Sheets, and commands the gate.
-// This function is non-blocking and safe to call in the main loop.
+// Reads and validates a card once a reader's IRQ line reports one, and opens
+// that reader's gate lane. Without a card it only checks the IRQ pins: the
+// SPI bus is not touched. Safe to call in the main loop.
+//
+// Cards are validated by the Google Apps Script over HTTPS, or, in builds
+// with -DRFID_VALIDATION_RPC, by a backend answering on the MQTT session
+// (see publishValidationRequest()): no TLS handshake per tap, and the loop
+// does not wait for the answer.
 void handleRfid();
 
-#endif
\ No newline at end of file
+// Called by the network handler with a reply on the validation topic.
+void handleValidationReply(const char* json);
+
+int getRfidReaderCount();
+const char* getRfidReaderName(int reader);
+RfidReaderStats getRfidReaderStats(int reader);
+
+RfidRpcStats getRfidRpcStats();
+
+// Scans not validated: the same card again within the repeat window, or an
+// entry/exit that anti-passback refused.
+uint32_t getRfidSuppressedRepeats();
+uint32_t getRfidPassbackRefusals();
+
+#endif
@@ -0,0 +1,78 @@
+#include "rfid_reader.h"
+
+// --- MFRC522 Register Values ---
+const byte RFID_IRQ_ACTIVE_LOW = 0x80;      // ComIEnReg.IRqInv
+const byte RFID_RX_IRQ = 0x20;              // ComIEnReg.RxIEn / ComIrqReg.RxIRq: a card answered
+const byte RFID_CLEAR_IRQS = 0x7F;          // ComIrqReg: clear every request bit
+const byte RFID_FLUSH_FIFO = 0x80;          // FIFOLevelReg.FlushBuffer
+const byte RFID_START_SEND_7_BITS = 0x87;   // BitFramingReg: StartSend, REQA is a 7-bit frame
+
+RfidReader::RfidReader() : config(NULL), reader(), counters() {}
+
+void RfidReader::begin(const RfidReaderConfig& readerConfig) {
+  config = &readerConfig;
+  reader.PCD_Init(config->ssPin, MFRC522::UNUSED_PIN); // Soft reset; setupRfid() owns the RST line
+  reader.PCD_WriteRegister(MFRC522::ComIEnReg, RFID_IRQ_ACTIVE_LOW | RFID_RX_IRQ);
+  reader.PCD_WriteRegister(MFRC522::ComIrqReg, RFID_CLEAR_IRQS);
+}
+
+void RfidReader::requestCard() {
+  uint32_t startUs = micros();
+  // Drop whatever a garbled or collided answer left behind, or the REQA
+  // would go out behind it.
+  reader.PCD_WriteRegister(MFRC522::FIFOLevelReg, RFID_FLUSH_FIFO);
+  reader.PCD_WriteRegister(MFRC522::FIFODataReg, MFRC522::PICC_CMD_REQA);
+  reader.PCD_WriteRegister(MFRC522::CommandReg, MFRC522::PCD_Transceive);
+  reader.PCD_WriteRegister(MFRC522::BitFramingReg, RFID_START_SEND_7_BITS);
+  counters.busyUs += micros() - startUs;
+  counters.requests++;
+}
+
+bool RfidReader::cardAnswered() {
+  if (digitalRead(config->irqPin) == HIGH) {
+    return false;
+  }
+  uint32_t startUs = micros();
+  bool answered = reader.PCD_ReadRegister(MFRC522::ComIrqReg) & RFID_RX_IRQ;
+  counters.busyUs += micros() - startUs;
+  if (answered) {
+    counters.irqs++;
+  }
+  return answered;
+}
+
+bool RfidReader::readCard(CardUid& uid) {
+  uint32_t startUs = micros();
+  bool cardRead = reader.PICC_ReadCardSerial();
+  counters.busyUs += micros() - startUs;
+  if (!cardRead) {
+    clearIrq();
+    return false;
+  }
+  counters.cards++;
+
+  uid.size = reader.uid.size < CardUid::MAX_SIZE ? reader.uid.size : CardUid::MAX_SIZE;
+  memcpy(uid.bytes, reader.uid.uidByte, uid.size);
+  return true;
+}
+
+void RfidReader::finishCard() {
+  uint32_t startUs = micros();
+  reader.PICC_HaltA();
+  counters.busyUs += micros() - startUs;
+  clearIrq();
+}
+
+void formatCardUid(const CardUid& uid, char* text, size_t size) {
+  size_t length = 0;
+  text[0] = '\0';
+  for (int i = 0; i < uid.size && length + 3 <= size; i++) {
+    length += snprintf(text + length, size - length, "%X", uid.bytes[i]);
+  }
+}
+
+void RfidReader::clearIrq() {
+  uint32_t startUs = micros();
+  reader.PCD_WriteRegister(MFRC522::ComIrqReg, RFID_CLEAR_IRQS);
+  counters.busyUs += micros() - startUs;
+}
@@ -0,0 +1,69 @@
+#ifndef RFID_READER_H
+#define RFID_READER_H
+
+#include <Arduino.h>
+#include <MFRC522.h>
+#include "scan_filter.h"
+
+// Wiring of one MFRC522 reader and the gate lane it serves.
+struct RfidReaderConfig {
+  const char* name;  // Used in logs and telemetry, e.g. "entry"
+  int ssPin;         // Chip select; every reader has its own
+  int rstPin;        // May be shared: setupRfid() resets every reader through it once
+  int irqPin;        // Open drain, active low; readers may share a line
+  int lane;          // Gate lane a valid card opens
+};
+
+// Per-reader scan figures for telemetry.
+struct RfidReaderStats {
+  uint32_t requests;  // REQA broadcasts sent to look for a card
+  uint32_t irqs;      // Times the reader claimed the IRQ line
+  uint32_t cards;     // UIDs read
+  uint32_t busyUs;    // Time spent talking to this reader over SPI
+};
+
+// One MFRC522 on the readers' SPI bus. It cannot notice a card by itself:
+// requestCard() broadcasts a REQA and returns, and an answering card raises
+// RxIRq, which pulls the IRQ line low until clearIrq(). Readers live in a
+// fixed array, so they are default-constructed and configured with begin().
+// The reset line must already be high when begin() runs.
+class RfidReader {
+ public:
+  RfidReader();
+
+  void begin(const RfidReaderConfig& config);
+
+  // Four register writes; no readback, no waiting.
+  void requestCard();
+
+  // True if this reader's IRQ line is low and the reader claims it, i.e. a
+  // card answered its last request. Reads ComIrqReg only when the line is low.
+  bool cardAnswered();
+
+  // Reads the answering card's UID. Returns false on a collision or if the
+  // card has left.
+  bool readCard(CardUid& uid);
+
+  // Halts the card so it ignores REQA until presented again, and releases
+  // the IRQ line.
+  void finishCard();
+  void clearIrq();
+
+  const char* name() const { return config ? config->name : ""; }
+  int lane() const { return config ? config->lane : -1; }
+  int irqPin() const { return config ? config->irqPin : -1; }
+  const RfidReaderStats& stats() const { return counters; }
+
+ private:
+  RfidReader(const RfidReader&);            // Lives in a fixed array: not copyable
+  RfidReader& operator=(const RfidReader&);
+
+  const RfidReaderConfig* config;
+  MFRC522 reader;
+  RfidReaderStats counters;
+};
+
+// Upper-case hex without zero padding: the format the access sheet holds.
+void formatCardUid(const CardUid& uid, char* text, size_t size);
+
+#endif
@@ -0,0 +1,64 @@
+#include "rpc_table.h"
+#include "system_state.h"
+
+RpcTable::Entry::Entry() : table(NULL), id(0), context(0), sentAt(0), timeout(onEntryTimeout, this) {}
+
+RpcTable::RpcTable(TimeoutHandler onTimeout) : nextId(1), timeoutHandler(onTimeout) {
+  for (int i = 0; i < SIZE; i++) {
+    entries[i].table = this;
+  }
+}
+
+void RpcTable::begin(uint32_t firstId) {
+  nextId = firstId != 0 ? firstId : 1;
+}
+
+uint32_t RpcTable::add(int context, TimeMs timeoutMs) {
+  for (int i = 0; i < SIZE; i++) {
+    Entry& entry = entries[i];
+    if (entry.id != 0) {
+      continue;
+    }
+    entry.id = nextId++;
+    if (nextId == 0) {
+      nextId = 1; // 0 marks a free entry
+    }
+    entry.context = context;
+    entry.sentAt = millis();
+    systemTimers.arm(entry.timeout, timeoutMs);
+    return entry.id;
+  }
+  return 0;
+}
+
+bool RpcTable::complete(uint32_t id, int& context, TimeMs& elapsedMs) {
+  if (id == 0) {
+    return false;
+  }
+  for (int i = 0; i < SIZE; i++) {
+    Entry& entry = entries[i];
+    if (entry.id == id) {
+      systemTimers.cancel(entry.timeout);
+      context = entry.context;
+      elapsedMs = timeElapsed(millis(), entry.sentAt);
+      entry.id = 0;
+      return true;
+    }
+  }
+  return false;
+}
+
+int RpcTable::pendingCount() const {
+  int pending = 0;
+  for (int i = 0; i < SIZE; i++) {
+    pending += entries[i].id != 0;
+  }
+  return pending;
+}
+
+void RpcTable::onEntryTimeout(void* context) {
+  Entry* entry = static_cast<Entry*>(context);
+  uint32_t id = entry->id;
+  entry->id = 0; // Free before the handler runs, so it may send a new request
+  entry->table->timeoutHandler(id, entry->context);
+}
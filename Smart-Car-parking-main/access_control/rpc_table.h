@@ -0,0 +1,52 @@
+#ifndef RPC_TABLE_H
+#define RPC_TABLE_H
+
+#include <Arduino.h>
+#include "timer_wheel.h"
+
+// Requests sent over MQTT and waiting for their reply, in a fixed table so a
+// burst of taps never allocates. Each entry carries an ID for the wire, a
+// caller-defined context (e.g. which reader asked) and a timeout on the
+// system timer wheel; a reply completes its entry, and an entry nobody
+// answers is handed to the timeout handler instead. Replies that match no
+// entry (late, duplicated, or from before a reboot) are simply rejected.
+class RpcTable {
+ public:
+  static const int SIZE = 8;
+  typedef void (*TimeoutHandler)(uint32_t id, int context);
+
+  explicit RpcTable(TimeoutHandler onTimeout);
+
+  // IDs start from 'firstId', which should differ between boots.
+  void begin(uint32_t firstId);
+
+  // Records a new request and returns its ID, or 0 if the table is full.
+  uint32_t add(int context, TimeMs timeoutMs);
+
+  // Removes a pending request, returning its context and age. False if the
+  // ID is not pending.
+  bool complete(uint32_t id, int& context, TimeMs& elapsedMs);
+
+  int pendingCount() const;
+
+ private:
+  struct Entry {
+    Entry();
+    RpcTable* table;
+    uint32_t id;      // 0 while free
+    int context;
+    TimeMs sentAt;
+    Timer timeout;
+  };
+
+  RpcTable(const RpcTable&);            // Entries point back at the table: not copyable
+  RpcTable& operator=(const RpcTable&);
+
+  static void onEntryTimeout(void* entry);
+
+  Entry entries[SIZE];
+  uint32_t nextId;
+  TimeoutHandler timeoutHandler;
+};
+
+#endif
@@ -0,0 +1,18 @@
+#include "sampling_rate.h"
+
+SamplingRate::SamplingRate(const SamplingLimits& limits)
+    : bounds(limits), interval(limits.fastMs), lastActivity(0) {}
+
+void SamplingRate::activity(TimeMs now) {
+  lastActivity = now;
+  interval = bounds.fastMs;
+}
+
+TimeMs SamplingRate::next(TimeMs now) {
+  if (timeElapsed(now, lastActivity) < bounds.holdMs) {
+    interval = bounds.fastMs;
+  } else if (interval < bounds.slowMs) {
+    interval = interval * 2 < bounds.slowMs ? interval * 2 : bounds.slowMs;
+  }
+  return interval;
+}
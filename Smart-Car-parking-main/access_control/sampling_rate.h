@@ -0,0 +1,36 @@
+#ifndef SAMPLING_RATE_H
+#define SAMPLING_RATE_H
+
+#include "timer_wheel.h"
+
+// Bounds for the slot sampling interval, in milliseconds.
+struct SamplingLimits {
+  TimeMs fastMs;   // Interval while the lot is busy
+  TimeMs slowMs;   // Longest interval ever used: the worst-case detection latency
+  TimeMs holdMs;   // Stay fast this long after the last activity
+};
+
+// Picks the next slot sampling interval from recent activity. Any slot change
+// or open gate snaps the interval to fastMs; once the lot has been quiet for
+// holdMs it doubles with every sample until it reaches slowMs. Pure
+// arithmetic, no hardware.
+class SamplingRate {
+ public:
+  explicit SamplingRate(const SamplingLimits& limits);
+
+  // Something happened: a slot changed or a gate is moving.
+  void activity(TimeMs now);
+
+  // Interval until the next sample, given a sample was just taken at 'now'.
+  TimeMs next(TimeMs now);
+
+  TimeMs intervalMs() const { return interval; }
+  const SamplingLimits& limits() const { return bounds; }
+
+ private:
+  SamplingLimits bounds;
+  TimeMs interval;
+  TimeMs lastActivity;
+};
+
+#endif
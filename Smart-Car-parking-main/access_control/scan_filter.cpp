@@ -0,0 +1,94 @@
+#include "scan_filter.h"
+#include <string.h>
+
+bool operator==(const CardUid& a, const CardUid& b) {
+  return a.size == b.size && memcmp(a.bytes, b.bytes, a.size) == 0;
+}
+
+ScanFilter::ScanFilter(const ScanFilterConfig& filterConfig)
+    : config(filterConfig), repeats(0), passbacks(0) {
+  memset(recent, 0, sizeof(recent));
+  memset(passages, 0, sizeof(passages));
+}
+
+int ScanFilter::findRecent(const CardUid& uid) const {
+  for (int i = 0; i < RECENT_CAPACITY; i++) {
+    if (recent[i].used && recent[i].uid == uid) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Restarts the UID's window, taking a free or the oldest entry if it has none.
+void ScanFilter::touchRecent(const CardUid& uid, TimeMs now) {
+  int slot = findRecent(uid);
+  if (slot < 0) {
+    slot = 0;
+    for (int i = 0; i < RECENT_CAPACITY && recent[slot].used; i++) {
+      if (!recent[i].used || timeElapsed(now, recent[i].lastSeen) > timeElapsed(now, recent[slot].lastSeen)) {
+        slot = i;
+      }
+    }
+  }
+  recent[slot].uid = uid;
+  recent[slot].lastSeen = now;
+  recent[slot].used = true;
+}
+
+ScanVerdict ScanFilter::check(const CardUid& uid, PassDirection direction, TimeMs now) {
+  int match = findRecent(uid);
+  if (match >= 0 && timeElapsed(now, recent[match].lastSeen) < config.repeatWindowMs) {
+    repeats++;
+    return SCAN_REPEAT; // The window runs from the validation, not the latest repeat
+  }
+
+  if (config.passbackHoldMs != 0 && direction != PASS_UNKNOWN) {
+    for (int i = 0; i < PASSAGE_CAPACITY; i++) {
+      const Passage& passage = passages[i];
+      if (passage.direction != PASS_UNKNOWN && passage.uid == uid) {
+        if (passage.direction == direction && timeElapsed(now, passage.at) < config.passbackHoldMs) {
+          passbacks++;
+          return SCAN_PASSBACK;
+        }
+        break;
+      }
+    }
+  }
+  // Held while the validation is in flight; the outcome keeps or forgets it.
+  touchRecent(uid, now);
+  return SCAN_VALIDATE;
+}
+
+void ScanFilter::forget(const CardUid& uid) {
+  int match = findRecent(uid);
+  if (match >= 0) {
+    recent[match].used = false;
+  }
+}
+
+void ScanFilter::recordPassage(const CardUid& uid, PassDirection direction, TimeMs now) {
+  touchRecent(uid, now);
+  if (config.passbackHoldMs == 0 || direction == PASS_UNKNOWN) {
+    return;
+  }
+  int slot = 0;
+  for (int i = 0; i < PASSAGE_CAPACITY; i++) {
+    Passage& passage = passages[i];
+    if (passage.direction != PASS_UNKNOWN && passage.uid == uid) {
+      slot = i;
+      break;
+    }
+    if (passage.direction == PASS_UNKNOWN) {
+      if (passages[slot].direction != PASS_UNKNOWN) {
+        slot = i; // First free entry, unless the UID turns up later
+      }
+    } else if (passages[slot].direction != PASS_UNKNOWN &&
+               timeElapsed(now, passage.at) > timeElapsed(now, passages[slot].at)) {
+      slot = i;
+    }
+  }
+  passages[slot].uid = uid;
+  passages[slot].at = now;
+  passages[slot].direction = direction;
+}
@@ -0,0 +1,86 @@
+#ifndef SCAN_FILTER_H
+#define SCAN_FILTER_H
+
+#include <stdint.h>
+#include "timer_wheel.h"
+
+// A card's UID as read from the reader: 4, 7 or 10 bytes.
+struct CardUid {
+  static const int MAX_SIZE = 10;
+  uint8_t size;
+  uint8_t bytes[MAX_SIZE];
+};
+
+bool operator==(const CardUid& a, const CardUid& b);
+
+// Which way a reader lets people through.
+enum PassDirection : uint8_t { PASS_UNKNOWN, PASS_IN, PASS_OUT };
+
+struct ScanFilterConfig {
+  TimeMs repeatWindowMs;  // A UID seen again within this window is not re-validated
+  TimeMs passbackHoldMs;  // How long a recorded entry/exit is remembered; 0 turns anti-passback off
+};
+
+enum ScanVerdict {
+  SCAN_VALIDATE,  // New scan: ask the backend
+  SCAN_REPEAT,    // Same card again within the window (e.g. held on the reader)
+  SCAN_PASSBACK,  // Entering while already in, or leaving while already out
+};
+
+// Decides which card scans are worth validating. Two small fixed tables keyed
+// by binary UID:
+//  - recent scans: a UID seen again within repeatWindowMs of being validated
+//    or granted is suppressed. Repeats do not restart the window, so a card
+//    held on the reader is validated again once the window has passed. Only
+//    a grant keeps the entry; a refusal or failed validation forgets it, so
+//    the next tap is validated at once;
+//  - passages: the direction of each card's last granted passage, so a
+//    paired entry/exit reader can refuse a second entry without an exit (a
+//    card passed back to the car behind) and vice versa.
+// When a table is full the least recently used UID is forgotten; a forgotten
+// card is treated as new, so the filter errs towards letting people through.
+// Pure bookkeeping, no hardware.
+class ScanFilter {
+ public:
+  static const int RECENT_CAPACITY = 16;
+  static const int PASSAGE_CAPACITY = 64;
+
+  explicit ScanFilter(const ScanFilterConfig& config);
+
+  // Classifies a scan at a reader letting people through in 'direction'.
+  ScanVerdict check(const CardUid& uid, PassDirection direction, TimeMs now);
+
+  // Records that the card was granted passage in 'direction' and restarts
+  // its repeat window.
+  void recordPassage(const CardUid& uid, PassDirection direction, TimeMs now);
+
+  // The card was not granted (denied, or its validation failed): its next
+  // scan is validated again.
+  void forget(const CardUid& uid);
+
+  uint32_t suppressedRepeats() const { return repeats; }
+  uint32_t passbackRefusals() const { return passbacks; }
+
+ private:
+  struct Recent {
+    CardUid uid;
+    TimeMs lastSeen;
+    bool used;
+  };
+  struct Passage {
+    CardUid uid;
+    TimeMs at;
+    PassDirection direction;  // PASS_UNKNOWN while the entry is free
+  };
+
+  int findRecent(const CardUid& uid) const;
+  void touchRecent(const CardUid& uid, TimeMs now);
+
+  ScanFilterConfig config;
+  Recent recent[RECENT_CAPACITY];
+  Passage passages[PASSAGE_CAPACITY];
+  uint32_t repeats;
+  uint32_t passbacks;
+};
+
+#endif
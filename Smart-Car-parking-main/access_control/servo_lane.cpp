@@ -0,0 +1,20 @@
+#include "servo_lane.h"
+
+ServoLane::ServoLane() : sensorPin(-1) {}
+
+void ServoLane::begin(const LaneConfig& config, TimerWheel& timers) {
+  barrier.attach(config.servoPin, config.closedAngle, config.motion, timers);
+  sensorPin = config.passageSensorPin;
+  if (sensorPin >= 0) {
+    // Active low; the pull-up makes an unplugged sensor read as a clear beam.
+    pinMode(sensorPin, INPUT_PULLUP);
+  }
+}
+
+void ServoLane::moveBarrier(float angle) {
+  barrier.moveTo(angle);
+}
+
+bool ServoLane::beamBlocked() {
+  return digitalRead(sensorPin) == LOW;
+}
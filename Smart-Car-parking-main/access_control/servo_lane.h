@@ -0,0 +1,25 @@
+#ifndef SERVO_LANE_H
+#define SERVO_LANE_H
+
+#include <Arduino.h>
+#include "gate_lane.h"
+#include "servo_motion.h"
+
+// A lane on the controller board: the barrier is a servo on servoPin, moved
+// along its motion profile, and the passage sensor a GPIO that reads LOW
+// while a vehicle is in the beam. The pin gets the internal pull-up, so it
+// must be one that has one (not GPIO34-39).
+class ServoLane : public LaneHardware {
+ public:
+  ServoLane();
+
+  void begin(const LaneConfig& config, TimerWheel& timers);
+  void moveBarrier(float angle);
+  bool beamBlocked();
+
+ private:
+  ServoMotion barrier;
+  int sensorPin;
+};
+
+#endif
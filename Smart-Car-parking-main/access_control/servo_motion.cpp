@@ -0,0 +1,91 @@
+#include "servo_motion.h"
+
+// --- Constants ---
+const TimeMs SERVO_FRAME_MS = 20;      // One 50 Hz PWM frame; stepping faster gains nothing
+const TimeMs SERVO_SETTLE_MS = 400;    // Keep driving this long after a move, then detach
+const int SERVO_MIN_PULSE_US = 544;    // Pulse widths for 0 and 180 degrees
+const int SERVO_MAX_PULSE_US = 2400;
+
+TimeMs ServoMotion::accelerationBusyUntil = 0;
+uint32_t ServoMotion::staggerCount = 0;
+TimeMs ServoMotion::staggerMaxMs = 0;
+int ServoMotion::poweredCount = 0;
+
+ServoMotion::ServoMotion()
+    : pin(-1), timers(NULL), limits(), stepTimer(onStep, this), current(0), moving(false), powered(false) {}
+
+void ServoMotion::attach(int servoPin, float angle, const MotionLimits& motionLimits, TimerWheel& timerWheel) {
+  pin = servoPin;
+  timers = &timerWheel;
+  limits = motionLimits;
+  current = angle;
+  servo.attach(pin, SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US);
+  powered = true;
+  poweredCount++;
+  writeAngle(current);
+  timers->arm(stepTimer, SERVO_SETTLE_MS);
+}
+
+void ServoMotion::writeAngle(float angle) {
+  // Microseconds rather than write(degrees): whole degrees make slow
+  // stretches of the profile visibly stepped.
+  servo.writeMicroseconds(SERVO_MIN_PULSE_US +
+                          (int)(angle * (SERVO_MAX_PULSE_US - SERVO_MIN_PULSE_US) / 180.0f + 0.5f));
+}
+
+void ServoMotion::moveTo(float angle) {
+  if (!moving && angle == current) {
+    return;
+  }
+  TimeMs now = timers->now();
+
+  // Wait for any servo that is still accelerating.
+  TimeMs startAt = now;
+  if (!timeReached(now, accelerationBusyUntil)) {
+    startAt = accelerationBusyUntil;
+    TimeMs held = timeElapsed(startAt, now);
+    staggerCount++;
+    if (held > staggerMaxMs) {
+      staggerMaxMs = held;
+    }
+  }
+
+  // A reversal mid-move restarts from rest at the current angle: a short
+  // jolt, but the barrier never has to finish a move it no longer wants.
+  profile.plan(current, angle, limits, startAt);
+  if (timeReached(profile.accelerationEnd(), accelerationBusyUntil)) {
+    accelerationBusyUntil = profile.accelerationEnd();
+  }
+  moving = true;
+  timers->arm(stepTimer, timeElapsed(startAt, now));
+}
+
+void ServoMotion::onStep(void* context) {
+  static_cast<ServoMotion*>(context)->step();
+}
+
+void ServoMotion::step() {
+  if (!moving) {
+    // Settled after the last move: drop the PWM.
+    servo.detach();
+    powered = false;
+    poweredCount--;
+    return;
+  }
+
+  TimeMs now = timers->now();
+  if (!powered) {
+    servo.attach(pin, SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US);
+    powered = true;
+    poweredCount++;
+  }
+  current = profile.positionAt(now);
+  writeAngle(current);
+
+  if (profile.finishedAt(now)) {
+    moving = false;
+    timers->arm(stepTimer, SERVO_SETTLE_MS);
+  } else {
+    timers->arm(stepTimer, SERVO_FRAME_MS);
+  }
+}
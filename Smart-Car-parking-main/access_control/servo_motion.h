@@ -0,0 +1,61 @@
+#ifndef SERVO_MOTION_H
+#define SERVO_MOTION_H
+
+#include <Arduino.h>
+#include <ESP32Servo.h>
+#include "motion_profile.h"
+
+// Moves one servo along a MotionProfile, stepped from the timer wheel once
+// per PWM frame, so any number of servos can move at once without blocking
+// the loop. The start of a move is held back while another servo is still
+// accelerating, because the start-up current of two servos together is what
+// browns out the board. Once a move has settled the PWM is detached, which
+// removes the holding current and the jitter at rest.
+class ServoMotion {
+ public:
+  ServoMotion();
+
+  // Attaches the servo and drives it straight to 'angle' (power-up position).
+  // Moves are stepped on 'timers', which must outlive the servo.
+  void attach(int pin, float angle, const MotionLimits& limits, TimerWheel& timers);
+
+  // Starts a move to 'angle', re-planning from the current angle if a move is
+  // already under way. Returns at once; the move runs from the timer wheel.
+  void moveTo(float angle);
+
+  bool isMoving() const { return moving; }
+  float angle() const { return current; }
+
+  // Servos whose PWM is currently attached. Light sleep would stop the PWM.
+  static int poweredServos() { return poweredCount; }
+
+  // Moves whose start was held back behind another servo, and the longest hold.
+  static uint32_t staggeredStarts() { return staggerCount; }
+  static TimeMs longestStaggerMs() { return staggerMaxMs; }
+
+ private:
+  ServoMotion(const ServoMotion&);            // Linked into the timer wheel: not copyable
+  ServoMotion& operator=(const ServoMotion&);
+
+  static void onStep(void* context);
+  void step();
+  void writeAngle(float angle);
+
+  int pin;
+  TimerWheel* timers;
+  Servo servo;
+  MotionLimits limits;
+  MotionProfile profile;
+  Timer stepTimer;
+  float current;
+  bool moving;
+  bool powered;
+
+  // Shared by every servo: until when some servo is still accelerating.
+  static TimeMs accelerationBusyUntil;
+  static uint32_t staggerCount;
+  static TimeMs staggerMaxMs;
+  static int poweredCount;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "shift_register_bus.h"
+
+// --- Constants ---
+// The 74HC165 manages ~20 MHz at 3.3 V; stay well inside that on long chains.
+const uint32_t SHIFT_REGISTER_CLOCK_HZ = 8000000;
+
+ShiftRegisterBus::ShiftRegisterBus(SPIClass& spi, int clockPin, int dataPin, int loadPin,
+                                   int chipCount, int firstSlot)
+    : spi(spi), clockPin(clockPin), dataPin(dataPin), loadPin(loadPin),
+      chipCount(chipCount), firstSlot(firstSlot) {}
+
+void ShiftRegisterBus::begin() {
+  pinMode(loadPin, OUTPUT);
+  digitalWrite(loadPin, HIGH);
+  spi.begin(clockPin, dataPin);
+}
+
+void ShiftRegisterBus::sample(OccupancyBits& occupied) {
+  uint8_t* chain = occupied.bytes() + firstSlot / 8;
+
+  // Latch all inputs at once.
+  digitalWrite(loadPin, LOW);
+  digitalWrite(loadPin, HIGH);
+
+  // Mode 2 samples on the falling edge; the 165 shifts on the rising one, so
+  // the first bit is read before the first shift. The driver moves the whole
+  // chain in FIFO-sized bursts with no per-bit work on our side.
+  spi.beginTransaction(SPISettings(SHIFT_REGISTER_CLOCK_HZ, LSBFIRST, SPI_MODE2));
+  spi.transferBytes(NULL, chain, chipCount);
+  spi.endTransaction();
+
+  // Inputs are active low.
+  for (int i = 0; i < chipCount; i++) {
+    chain[i] = ~chain[i];
+  }
+}
@@ -0,0 +1,37 @@
+#ifndef SHIFT_REGISTER_BUS_H
+#define SHIFT_REGISTER_BUS_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "slot_sensor_bus.h"
+
+// Daisy-chained 74HC165 parallel-in shift registers, 8 sensors each, read as
+// one SPI transfer. SH/LD latches every input at once; the chain is then
+// clocked out LSB first so the chip nearest the ESP32 lands in the first
+// byte, input H in bit 0. Sensors are LOW while occupied, like the GPIO ones.
+//
+// The chain drives MISO all the time (the 165 has no chip select), so it has
+// an SPI host of its own (HSPI) rather than sharing the RFID readers' VSPI.
+// It is the host's only user, so a sample never waits for the bus.
+class ShiftRegisterBus : public SlotSensorBus {
+ public:
+  // firstSlot must be a multiple of 8: the chain is read straight into the
+  // occupancy bytes.
+  ShiftRegisterBus(SPIClass& spi, int clockPin, int dataPin, int loadPin, int chipCount, int firstSlot);
+
+  const char* name() const { return "shift-register"; }
+  void begin();
+  int sensorCount() const { return chipCount * 8; }
+  void sample(OccupancyBits& occupied);
+  void markSensed(OccupancyBits& sensed) const { memset(sensed.bytes() + firstSlot / 8, 0xFF, chipCount); }
+
+ private:
+  SPIClass& spi;
+  int clockPin;
+  int dataPin;
+  int loadPin;
+  int chipCount;
+  int firstSlot;
+};
+
+#endif
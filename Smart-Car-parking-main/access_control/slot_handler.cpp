@@ -1,38 +1,216 @@
 #include "slot_handler.h"
 #include "network_handler.h" // <-- Include this to call the publish function
+#include "logger.h"
+#include "gpio_sensor_bus.h"
+#include "shift_register_bus.h"
+#include "expander_sensor_bus.h"
+#include "ultrasonic_sensor_bus.h"
+#include "gate_handler.h"
+#include "system_state.h"
+#include "power.h"
 
-// --- Configuration ---
-// Note: NUM_REAL_SENSORS is now defined in network_handler.h
-const int SENSOR_PINS[NUM_REAL_SENSORS] = {34, 35, 32, 33, 25, 26, 27};
+// --- Direct GPIO Sensors ---
+const int NUM_GPIO_SENSORS = 7;
+const int SENSOR_PINS[NUM_GPIO_SENSORS] = {34, 35, 32, 33, 25, 26, 27};
+// Zero-based slot each pin senses, i.e. slot numbers 2, 5, 6, 9, 13, 17, 19.
+const int SENSOR_SLOTS[NUM_GPIO_SENSORS] = {1, 4, 5, 8, 12, 16, 18};
+
+// --- Shift Register Chain ---
+// Number of 74HC165s on the chain (8 slots each); 0 if the site has none.
+// The chain covers slots FIRST_SLOT onwards, so raise TOTAL_SLOTS to match.
+#define SHIFT_REGISTER_CHIPS 0
+#define SHIFT_REGISTER_FIRST_SLOT 24
+#define SHIFT_REGISTER_CLOCK_PIN 16
+#define SHIFT_REGISTER_DATA_PIN 39
+#define SHIFT_REGISTER_LOAD_PIN 17
+
+// --- I2C Expanders ---
+// Number of MCP23017s (16 slots each) to use from the table below; 0 if the
+// site has none. INTA lines are open-drain and may share an ESP32 pin; a
+// dedicated pin per expander means a change costs exactly one read. An INT
+// line on GPIO34-39 needs a 10k pull-up to 3.3 V: those pins have none.
+// Here INTA shares GPIO22 with the RFID readers' IRQ, which is open-drain and
+// active low too; each side reads its own chips while the line is low.
+// SDA and SCL keep off the strapping pins (0, 2, 5, 12, 15), UART0 (1, 3) and
+// the input-only 34-39. Every other pin already has a job, so they take 13
+// and 4, the exit lane's servo and passage sensor: a GATE_EXIT_LANE build
+// with expanders is refused below. Such a site rewires one of them.
+#define EXPANDER_COUNT 0
+#define EXPANDER_SDA_PIN 13
+#define EXPANDER_SCL_PIN 4
+#define EXPANDER_CLOCK_HZ 400000
+constexpr ExpanderConfig EXPANDERS[] = {
+  // address, intPin, firstSlot
+  { 0x20, 22, 32 },
+  { 0x21, 22, 48 },
+  { 0x22, 22, 64 },
+  { 0x23, 22, 80 },
+};
+
+// --- Ultrasonic Sensors ---
+// HC-SR04s for slots where IR beams miss low or dark cars. Number of entries
+// to use from the table below; 0 if the site has none. The example keeps
+// clear of the shift register and expander pins; its trigger is the entry
+// lane's passage sensor pin, should one be fitted.
+#define ULTRASONIC_COUNT 0
+const UltrasonicConfig ULTRASONIC_SENSORS[] = {
+  // triggerPin, echoPin, slot, thresholdCm
+  { 14, 36, 0, 120 },
+};
+
+static_assert(TOTAL_SLOTS <= MAX_SLOTS, "TOTAL_SLOTS exceeds MAX_SLOTS");
+
+// --- Sensor Buses ---
+static GpioSensorBus gpioSensors(SENSOR_PINS, SENSOR_SLOTS, NUM_GPIO_SENSORS);
+#if SHIFT_REGISTER_CHIPS > 0
+static_assert(SHIFT_REGISTER_FIRST_SLOT % 8 == 0, "shift register chain must start on a byte");
+static_assert(SHIFT_REGISTER_FIRST_SLOT + 8 * SHIFT_REGISTER_CHIPS <= TOTAL_SLOTS,
+              "shift register chain runs past TOTAL_SLOTS");
+static SPIClass shiftRegisterHost(HSPI);
+static ShiftRegisterBus shiftRegisters(shiftRegisterHost, SHIFT_REGISTER_CLOCK_PIN, SHIFT_REGISTER_DATA_PIN,
+                                       SHIFT_REGISTER_LOAD_PIN, SHIFT_REGISTER_CHIPS,
+                                       SHIFT_REGISTER_FIRST_SLOT);
+#endif
+#if EXPANDER_COUNT > 0
+static_assert(EXPANDER_COUNT <= (int)(sizeof(EXPANDERS) / sizeof(EXPANDERS[0])), "EXPANDERS table too short");
+// True if expanders first..EXPANDER_COUNT - 1 each start on a byte.
+constexpr bool expandersOnBytes(int first) {
+  return first >= EXPANDER_COUNT || (EXPANDERS[first].firstSlot % 8 == 0 && expandersOnBytes(first + 1));
+}
+// True if expanders first..EXPANDER_COUNT - 1 each end within TOTAL_SLOTS.
+constexpr bool expandersFit(int first) {
+  return first >= EXPANDER_COUNT || (EXPANDERS[first].firstSlot + 16 <= TOTAL_SLOTS && expandersFit(first + 1));
+}
+static_assert(expandersOnBytes(0), "expander firstSlot must be a multiple of 8");
+static_assert(expandersFit(0), "expander slots run past TOTAL_SLOTS");
+#if defined(GATE_EXIT_LANE) && (EXPANDER_SDA_PIN == 13 || EXPANDER_SCL_PIN == 4)
+// The exit servo's PWM would be driven onto SDA.
+#error "Expander example pins 13/4 are the exit lane's servo and passage sensor; move SDA/SCL for GATE_EXIT_LANE"
+#endif
+static WireI2cBus expanderI2c(Wire, EXPANDER_SDA_PIN, EXPANDER_SCL_PIN, EXPANDER_CLOCK_HZ);
+static ExpanderSensorBus expanderSensors(expanderI2c, EXPANDERS, EXPANDER_COUNT);
+#endif
+
+#if ULTRASONIC_COUNT > 0
+#if POWER_MODE == POWER_LIGHT_SLEEP
+// A ping is out for up to 38 ms of every 60; its echo edges cannot wake the
+// CPU, and esp_timer would not time them across a light sleep.
+#error "Ultrasonic sensors cannot run with POWER_LIGHT_SLEEP; use POWER_MODEM_SLEEP"
+#endif
+static_assert(ULTRASONIC_COUNT <= (int)(sizeof(ULTRASONIC_SENSORS) / sizeof(ULTRASONIC_SENSORS[0])),
+              "ULTRASONIC_SENSORS table too short");
+static UltrasonicSensorBus ultrasonicSensors(ULTRASONIC_SENSORS, ULTRASONIC_COUNT);
+#endif
+
+static SlotSensorBus* const SENSOR_BUSES[] = {
+  &gpioSensors,
+#if SHIFT_REGISTER_CHIPS > 0
+  &shiftRegisters,
+#endif
+#if EXPANDER_COUNT > 0
+  &expanderSensors,
+#endif
+#if ULTRASONIC_COUNT > 0
+  &ultrasonicSensors,
+#endif
+};
+const int NUM_SENSOR_BUSES = sizeof(SENSOR_BUSES) / sizeof(SENSOR_BUSES[0]);
+static_assert(NUM_SENSOR_BUSES <= SlotMonitor::MAX_BUSES, "too many sensor buses for SlotMonitor");
+
+// --- Sampling Rate ---
+const SamplingLimits SAMPLING_LIMITS = {
+  10,    // fastMs: while cars are moving or a gate is open (one loop pass)
+  200,   // slowMs: quiet lot; also the worst-case latency for polled buses
+  30000  // holdMs: stay fast this long after the last activity
+};
 
 // --- Module Variables ---
-bool realSlotOccupied[NUM_REAL_SENSORS] = {false};
+// Hands changes to the network handler; an open gate keeps sampling fast.
+class HandlerSlotEvents : public SlotEvents {
+ public:
+  void slotsChanged(const OccupancyBits& occupied, int slotCount, const SlotTrace& trace) {
+    publishSlotStatus(occupied, slotCount, trace);
+  }
+
+  bool lotBusy() {
+    for (int lane = 0; lane < GATE_LANE_COUNT; lane++) {
+      if (gateIsOpen(lane)) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+static HandlerSlotEvents slotEvents;
+static SlotMonitor slotMonitor(SENSOR_BUSES, NUM_SENSOR_BUSES, TOTAL_SLOTS, SAMPLING_LIMITS);
+
+#ifdef SLOT_SAMPLING_BENCHMARK
+// Compiled in with -DSLOT_SAMPLING_BENCHMARK: times the direct GPIO sensors
+// both ways at boot and logs the results as SLOTS_SAMPLING_* records.
+const int SAMPLING_BENCHMARK_PASSES = 10000;
+
+// Returns the average time of one pass over every GPIO sensor, in ns.
+static uint32_t timeGpioSampling(bool snapshot, OccupancyBits& result) {
+  gpioSensors.setSnapshotSampling(snapshot);
+  uint32_t startCycles = ESP.getCycleCount();
+  for (int pass = 0; pass < SAMPLING_BENCHMARK_PASSES; pass++) {
+    gpioSensors.sample(result);
+  }
+  uint32_t cycles = ESP.getCycleCount() - startCycles;
+  return (uint32_t)((uint64_t)cycles * 1000 / ESP.getCpuFreqMHz() / SAMPLING_BENCHMARK_PASSES);
+}
 
-// in slot_handler.cpp
+static void runSamplingBenchmark() {
+  OccupancyBits viaDigitalRead;
+  OccupancyBits viaSnapshot;
+  uint32_t digitalReadNs = timeGpioSampling(false, viaDigitalRead);
+  uint32_t snapshotNs = timeGpioSampling(true, viaSnapshot);
+  LOG_INFO(SLOTS_SAMPLING_BENCH, "digitalRead", digitalReadNs, digitalReadNs / NUM_GPIO_SENSORS);
+  LOG_INFO(SLOTS_SAMPLING_BENCH, "register snapshot", snapshotNs, snapshotNs / NUM_GPIO_SENSORS);
+  if (viaDigitalRead != viaSnapshot) {
+    LOG_WARN(SLOTS_SAMPLING_MISMATCH);
+  }
+}
+#endif
 
 void setupSlots() {
-  for (int i = 0; i < NUM_REAL_SENSORS; i++) {
-    pinMode(SENSOR_PINS[i], INPUT);
-    // Read the initial state of the sensor to prevent a false trigger on the first loop
-    realSlotOccupied[i] = (digitalRead(SENSOR_PINS[i]) == LOW);
+#if EXPANDER_COUNT > 0
+  expanderI2c.begin();
+#endif
+  for (int bus = 0; bus < NUM_SENSOR_BUSES; bus++) {
+    SENSOR_BUSES[bus]->begin();
   }
-  Serial.println("Initial sensor states have been read.");
+#ifdef SLOT_SAMPLING_BENCHMARK
+  runSamplingBenchmark();
+#endif
+  slotMonitor.begin(systemTimers, systemClock, slotEvents, esp_random()); // Keep trace IDs from repeating across reboots
 }
 
 void handleSlots() {
-  bool stateHasChanged = false;
+  slotMonitor.poll();
+}
 
-  for (int i = 0; i < NUM_REAL_SENSORS; i++) {
-    bool isOccupied = (digitalRead(SENSOR_PINS[i]) == LOW);
-    if (isOccupied != realSlotOccupied[i]) {
-      realSlotOccupied[i] = isOccupied;
-      stateHasChanged = true;
-    }
-  }
+int getSlotCount() {
+  return slotMonitor.slotCount();
+}
 
-  if (stateHasChanged) {
-    Serial.println("Slot Handler: State change detected, calling network handler to publish.");
-    // Call the function from the network handler, passing our current sensor states
-    publishSlotStatus(realSlotOccupied);
-  }
+const OccupancyBits& getOccupancy() {
+  return slotMonitor.occupancy();
+}
+
+const OccupancyBits& getSensedSlots() {
+  return slotMonitor.sensed();
+}
+
+int getSlotBusCount() {
+  return slotMonitor.busCount();
+}
+
+SlotBusStats getSlotBusStats(int bus) {
+  return slotMonitor.busStats(bus);
+}
+
+SlotSamplingStats getSlotSamplingStats() {
+  return slotMonitor.samplingStats();
 }
\ No newline at end of file
@@ -2,17 +2,39 @@
 #define SLOT_HANDLER_H
 
 #include <Arduino.h>
+#include "slot_monitor.h"
 
-// Initializes the sensor pins.
+// --- Slot Layout ---
+// Slots the site has. Shared so the network handler can size its status
+// template at compile time.
+const int TOTAL_SLOTS = 20;
+
+// Initializes every sensor bus and takes the first reading.
 void setupSlots();
 
-// Checks all sensors for state changes. Call this in the main loop.
+// Samples at once if a sensor bus interrupt reported a change; otherwise the
+// buses are sampled from the timer wheel at an interval that adapts to lot
+// activity. Call this in the main loop.
 void handleSlots();
 
+// Slots the site has, and their latest state. Slots without a sensor are
+// always reported as occupied, so nobody is sent to them.
+int getSlotCount();
+const OccupancyBits& getOccupancy();
+
+// Slots that have a sensor. Valid before setupSlots(), so the network handler
+// can hand it to the status publisher.
+const OccupancyBits& getSensedSlots();
+
 // Returns a count of how many slots are currently free.
 int getFreeSlotCount();
 
 // Returns a formatted string listing the numbers of the free slots.
 String getFreeSlotsString();
 
-#endif
\ No newline at end of file
+// Sampling figures, for telemetry.
+int getSlotBusCount();
+SlotBusStats getSlotBusStats(int bus);
+SlotSamplingStats getSlotSamplingStats();
+
+#endif
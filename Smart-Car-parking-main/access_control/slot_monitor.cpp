@@ -0,0 +1,153 @@
+#include "slot_monitor.h"
+#include "logger.h"
+#include "heap_tracker.h"
+
+// --- Constants ---
+const TimeMs BASELINE_SAMPLE_INTERVAL = 10; // The old fixed loop rate, for the savings figure
+
+SlotMonitor::SlotMonitor(SlotSensorBus* const* busArray, int busCount, int slotCount, const SamplingLimits& limits)
+    : busList(busArray),
+      buses(busCount < MAX_BUSES ? busCount : MAX_BUSES),
+      slots(slotCount),
+      timers(NULL),
+      clock(NULL),
+      events(NULL),
+      samplingRate(limits),
+      sampleTimer(onSampleTimer, this),
+      samplesTaken(0),
+      samplingSince(0),
+      traceCounter(0) {
+  memset(busTiming, 0, sizeof(busTiming));
+  current.fill(); // Slots without a sensor stay occupied
+  for (int bus = 0; bus < buses; bus++) {
+    busList[bus]->markSensed(sensedSlots);
+  }
+}
+
+void SlotMonitor::begin(TimerWheel& timerWheel, ControllerClock& controllerClock, SlotEvents& slotEvents,
+                        uint32_t firstTraceId) {
+  timers = &timerWheel;
+  clock = &controllerClock;
+  events = &slotEvents;
+  traceCounter = firstTraceId % SYNTHETIC_TRACE_ID_BASE;
+  // Read the initial state of the sensors to prevent a false trigger on the first pass
+  sampleBuses(current);
+  samplingSince = timers->now();
+  timers->arm(sampleTimer, samplingRate.next(samplingSince));
+  LOG_INFO(SLOTS_INITIAL);
+}
+
+// Samples every bus into 'sampled', timing each one in CPU cycles.
+void SlotMonitor::sampleBuses(OccupancyBits& sampled) {
+  for (int bus = 0; bus < buses; bus++) {
+    uint32_t startCycles = clock->cycleCount();
+    busList[bus]->sample(sampled);
+    uint32_t cycles = clock->cycleCount() - startCycles;
+    busTiming[bus].samples++;
+    busTiming[bus].totalCycles += cycles;
+    busTiming[bus].lastCycles = cycles;
+  }
+}
+
+// Earliest edge timestamp among the slots that differ between two readings.
+int64_t SlotMonitor::firstEdgeUs(const OccupancyBits& before, const OccupancyBits& after) const {
+  int64_t first = 0;
+  for (int byteIndex = 0; byteIndex < (slots + 7) / 8; byteIndex++) {
+    uint8_t changed = before.bytes()[byteIndex] ^ after.bytes()[byteIndex];
+    for (int bit = 0; changed != 0; bit++, changed >>= 1) {
+      if (!(changed & 1)) {
+        continue;
+      }
+      for (int bus = 0; bus < buses; bus++) {
+        int64_t edge = busList[bus]->edgeUs(byteIndex * 8 + bit);
+        if (edge != 0 && (first == 0 || edge < first)) {
+          first = edge;
+        }
+      }
+    }
+  }
+  return first;
+}
+
+// Samples every bus and reports if anything changed. Returns true on a change.
+bool SlotMonitor::sampleAndReport() {
+  HeapScope heapScope(HEAP_MODULE_SLOTS);
+  int64_t pollUs = clock->monotonicUs();
+  samplesTaken++;
+
+  OccupancyBits sampled = current;
+  sampleBuses(sampled);
+  if (sampled == current) {
+    return false;
+  }
+
+  LOG_DEBUG(SLOTS_CHANGED);
+  int64_t edgeUs = firstEdgeUs(current, sampled);
+  current = sampled;
+
+  SlotTrace trace;
+  traceCounter = (traceCounter + 1) % SYNTHETIC_TRACE_ID_BASE;
+  trace.id = traceCounter;
+  trace.detectUs = clock->traceFromMonotonicUs(pollUs);
+  trace.edgeUs = edgeUs != 0 ? clock->traceFromMonotonicUs(edgeUs) : trace.detectUs;
+  events->slotsChanged(current, slots, trace);
+  return true;
+}
+
+// Runs from the timer wheel on the adaptive schedule, and from poll() when a
+// bus interrupt reports a change early.
+void SlotMonitor::sampleNow() {
+  TimeMs now = timers->now();
+  if (sampleAndReport() || events->lotBusy()) {
+    samplingRate.activity(now);
+  }
+  timers->arm(sampleTimer, samplingRate.next(now));
+}
+
+void SlotMonitor::onSampleTimer(void* context) {
+  static_cast<SlotMonitor*>(context)->sampleNow();
+}
+
+void SlotMonitor::poll() {
+  for (int bus = 0; bus < buses; bus++) {
+    if (busList[bus]->hasPendingChange()) {
+      sampleNow();
+      return;
+    }
+  }
+}
+
+SlotBusStats SlotMonitor::busStats(int bus) const {
+  SlotBusStats stats;
+  const BusTiming& timing = busTiming[bus];
+  uint32_t cyclesPerUs = clock->cyclesPerUs();
+  stats.name = busList[bus]->name();
+  stats.sensors = busList[bus]->sensorCount();
+  stats.samples = timing.samples;
+  stats.lastSampleNs = timing.lastCycles * 1000 / cyclesPerUs;
+  uint64_t sensorSamples = (uint64_t)timing.samples * stats.sensors;
+  stats.nsPerSensor = sensorSamples ? (uint32_t)(timing.totalCycles * 1000 / cyclesPerUs / sensorSamples) : 0;
+  return stats;
+}
+
+SlotSamplingStats SlotMonitor::samplingStats() const {
+  SlotSamplingStats stats;
+  stats.intervalMs = samplingRate.intervalMs();
+  stats.maxLatencyMs = samplingRate.limits().slowMs;
+  stats.samples = samplesTaken;
+
+  // What the old fixed-rate loop would have spent on the passes we skipped.
+  // Every pass samples every bus, so a pass costs the average bus sample
+  // times the number of buses.
+  uint64_t cycles = 0;
+  uint32_t busSamples = 0;
+  for (int bus = 0; bus < buses; bus++) {
+    cycles += busTiming[bus].totalCycles;
+    busSamples += busTiming[bus].samples;
+  }
+  uint32_t baselineSamples = timeElapsed(timers->now(), samplingSince) / BASELINE_SAMPLE_INTERVAL;
+  uint32_t skipped = baselineSamples > samplesTaken ? baselineSamples - samplesTaken : 0;
+  uint64_t cyclesPerPass = busSamples ? cycles * buses / busSamples : 0;
+  stats.cpuSavedUs = skipped * cyclesPerPass / clock->cyclesPerUs();
+  return stats;
+}
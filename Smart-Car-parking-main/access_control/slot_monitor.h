@@ -0,0 +1,101 @@
+#ifndef SLOT_MONITOR_H
+#define SLOT_MONITOR_H
+
+#include "controller_clock.h"
+#include "occupancy.h"
+#include "sampling_rate.h"
+#include "slot_sensor_bus.h"
+#include "trace.h"
+
+// Sampling cost of one sensor bus, for telemetry.
+struct SlotBusStats {
+  const char* name;
+  int sensors;
+  uint32_t samples;
+  uint32_t nsPerSensor;   // Average sampling time per sensor
+  uint32_t lastSampleNs;  // Time the latest sample of the whole bus took
+};
+
+// Adaptive sampling figures, for telemetry.
+struct SlotSamplingStats {
+  uint32_t intervalMs;    // Current sampling interval
+  uint32_t maxLatencyMs;  // Guaranteed detection latency for polled buses
+  uint32_t samples;       // Sampling passes since boot
+  uint64_t cpuSavedUs;    // CPU time saved against sampling every 10 ms
+};
+
+// Where a SlotMonitor reports changes, and how it learns that cars are about.
+class SlotEvents {
+ public:
+  virtual ~SlotEvents() {}
+
+  // The occupancy of the first slotCount slots changed.
+  virtual void slotsChanged(const OccupancyBits& occupied, int slotCount, const SlotTrace& trace) = 0;
+
+  // True while cars are likely to be moving (a gate is open), which keeps
+  // sampling at the fast rate.
+  virtual bool lotBusy() = 0;
+};
+
+// Samples a fixed list of sensor buses into one OccupancyBits, from the timer
+// wheel at an interval that adapts to lot activity, and reports each change
+// with its trace. The buses are started by their owner before begin().
+class SlotMonitor {
+ public:
+  static const int MAX_BUSES = 8;
+
+  // The buses must outlive the monitor. Slots no bus covers stay occupied,
+  // so nobody is sent to them.
+  SlotMonitor(SlotSensorBus* const* buses, int busCount, int slotCount, const SamplingLimits& limits);
+
+  // Takes the first reading, which is not reported, and starts sampling.
+  // Trace IDs count up from firstTraceId, which should differ between boots,
+  // wrapping below SYNTHETIC_TRACE_ID_BASE.
+  void begin(TimerWheel& timers, ControllerClock& clock, SlotEvents& events, uint32_t firstTraceId);
+
+  // Samples at once if a bus interrupt reported a change. Call every loop pass.
+  void poll();
+
+  int slotCount() const { return slots; }
+  const OccupancyBits& occupancy() const { return current; }
+
+  // Slots some bus has a sensor for; fixed once constructed.
+  const OccupancyBits& sensed() const { return sensedSlots; }
+
+  int busCount() const { return buses; }
+  SlotBusStats busStats(int bus) const;
+  SlotSamplingStats samplingStats() const;
+
+ private:
+  SlotMonitor(const SlotMonitor&);            // Linked into the timer wheel: not copyable
+  SlotMonitor& operator=(const SlotMonitor&);
+
+  struct BusTiming {
+    uint32_t samples;
+    uint64_t totalCycles;
+    uint32_t lastCycles;
+  };
+
+  static void onSampleTimer(void* context);
+  void sampleNow();
+  bool sampleAndReport();
+  void sampleBuses(OccupancyBits& sampled);
+  int64_t firstEdgeUs(const OccupancyBits& before, const OccupancyBits& after) const;
+
+  SlotSensorBus* const* busList;
+  int buses;
+  int slots;
+  TimerWheel* timers;
+  ControllerClock* clock;
+  SlotEvents* events;
+  OccupancyBits current;
+  OccupancyBits sensedSlots;
+  SamplingRate samplingRate;
+  Timer sampleTimer;
+  uint32_t samplesTaken;
+  TimeMs samplingSince;
+  uint32_t traceCounter;
+  BusTiming busTiming[MAX_BUSES];
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SLOT_SENSOR_BUS_H
+#define SLOT_SENSOR_BUS_H
+
+#include <stdint.h>
+#include "occupancy.h"
+
+// A group of slot sensors read the same way: direct GPIO pins, a chain of
+// shift registers, and so on. The slot handler owns a fixed list of buses and
+// samples all of them into one OccupancyBits on an adaptive schedule.
+class SlotSensorBus {
+ public:
+  virtual ~SlotSensorBus() {}
+
+  virtual const char* name() const = 0;
+  virtual void begin() = 0;
+
+  // Number of sensors on the bus, i.e. slots it writes per sample.
+  virtual int sensorCount() const = 0;
+
+  // Writes the current state of each of this bus's slots into 'occupied'
+  // and leaves every other slot alone.
+  virtual void sample(OccupancyBits& occupied) = 0;
+
+  // Sets the bit of every slot this bus has a sensor for.
+  virtual void markSensed(OccupancyBits& sensed) const = 0;
+
+  // esp_timer time of the first edge on a slot that the latest sample() took
+  // in, or 0 if there was none or the bus has no edge timestamps (the trace
+  // then starts at the poll that saw the change).
+  virtual int64_t edgeUs(int slot) const { (void)slot; return 0; }
+
+  // True if the bus has seen a change (via its interrupts) that has not been
+  // sampled yet, so the slot handler can sample at once instead of waiting
+  // for the next scheduled pass. Buses without interrupts return false and
+  // are picked up by the schedule.
+  virtual bool hasPendingChange() const { return false; }
+};
+
+#endif
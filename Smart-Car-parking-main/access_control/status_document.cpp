@@ -0,0 +1,299 @@
+#include "status_document.h"
+#include <stdio.h>
+#include <string.h>
+
+// --- JSON ---
+// Writes one entry of the slot array; with a NULL buffer it only measures it.
+static int formatSlotEntry(char* buffer, size_t size, int slot, bool occupied, bool first) {
+  return snprintf(buffer, size, "%s{\"slotNumber\":%d,\"status\":\"%s\"}",
+                  first ? "" : ",", slot + 1, occupied ? "occupied" : "available");
+}
+
+// A full document lists every slot; a delta only those that differ from the baseline.
+static bool listsSlot(const StatusDocument& document, int slot) {
+  return document.baseline == NULL || document.baseline->test(slot) != document.occupied->test(slot);
+}
+
+static int formatHeader(char* buffer, size_t size, const StatusDocument& document) {
+  return snprintf(buffer, size, "{\"device\":\"%s\",\"seq\":%lu,\"%s\":[", document.device,
+                  (unsigned long)document.seq, document.baseline == NULL ? "slots" : "changes");
+}
+
+static int formatFooter(char* buffer, size_t size, const StatusDocument& document) {
+  if (!document.hasTrace) {
+    return snprintf(buffer, size, "]}");
+  }
+  return snprintf(buffer, size, "],\"trace\":{\"id\":%lu}}", (unsigned long)document.traceId);
+}
+
+static size_t measureJson(const StatusDocument& document) {
+  size_t length = formatHeader(NULL, 0, document) + formatFooter(NULL, 0, document);
+  bool first = true;
+  for (int slot = 0; slot < document.slotCount; slot++) {
+    if (listsSlot(document, slot)) {
+      length += formatSlotEntry(NULL, 0, slot, document.occupied->test(slot), first);
+      first = false;
+    }
+  }
+  return length;
+}
+
+static void writeJson(const StatusDocument& document, StatusWriter writer, void* context) {
+  char chunk[STATUS_CHUNK_SIZE];
+  size_t chunkLength = formatHeader(chunk, sizeof(chunk), document);
+  bool first = true;
+  for (int slot = 0; slot < document.slotCount; slot++) {
+    if (!listsSlot(document, slot)) {
+      continue;
+    }
+    char entry[48];
+    int entryLength = formatSlotEntry(entry, sizeof(entry), slot, document.occupied->test(slot), first);
+    first = false;
+    if (chunkLength + entryLength > sizeof(chunk)) {
+      writer((const uint8_t*)chunk, chunkLength, context);
+      chunkLength = 0;
+    }
+    memcpy(chunk + chunkLength, entry, entryLength);
+    chunkLength += entryLength;
+  }
+  char footer[48];
+  int footerLength = formatFooter(footer, sizeof(footer), document);
+  if (chunkLength + footerLength > sizeof(chunk)) {
+    writer((const uint8_t*)chunk, chunkLength, context);
+    chunkLength = 0;
+  }
+  memcpy(chunk + chunkLength, footer, footerLength);
+  writer((const uint8_t*)chunk, chunkLength + footerLength, context);
+}
+
+// --- Binary Encodings ---
+const size_t DEVICE_MAX = 32; // Longer device IDs are cut short
+// Worst case is CBOR: its keys, heads and trace come to 61 bytes.
+const size_t BINARY_MAX = 64 + DEVICE_MAX + 2 * (MAX_SLOTS / 8);
+static_assert(BINARY_MAX <= STATUS_CHUNK_SIZE, "a binary status document must fit one chunk");
+
+const uint8_t CBOR_UINT = 0;
+const uint8_t CBOR_BYTES = 2;
+const uint8_t CBOR_TEXT = 3;
+const uint8_t CBOR_MAP = 5;
+
+static uint8_t* putLittleEndian(uint8_t* out, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    *out++ = (uint8_t)(value >> (8 * i));
+  }
+  return out;
+}
+
+// The first (slotCount + 7) / 8 bytes of a bitset, with the bits past the
+// last slot cleared. A NULL bitset is all ones.
+static uint8_t* putBitset(uint8_t* out, const OccupancyBits* bits, int slotCount) {
+  int length = (slotCount + 7) / 8;
+  if (bits != NULL) {
+    memcpy(out, bits->bytes(), length);
+  } else {
+    memset(out, 0xFF, length);
+  }
+  if (slotCount % 8 != 0) {
+    out[length - 1] &= (1 << (slotCount % 8)) - 1;
+  }
+  return out + length;
+}
+
+static uint8_t* putCborHead(uint8_t* out, uint8_t major, uint32_t value) {
+  if (value < 24) {
+    *out++ = (major << 5) | value;
+  } else if (value <= 0xFF) {
+    *out++ = (major << 5) | 24;
+    *out++ = value;
+  } else if (value <= 0xFFFF) {
+    *out++ = (major << 5) | 25;
+    *out++ = value >> 8;
+    *out++ = value;
+  } else {
+    *out++ = (major << 5) | 26;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      *out++ = value >> shift;
+    }
+  }
+  return out;
+}
+
+static uint8_t* putCborText(uint8_t* out, const char* text, size_t length) {
+  out = putCborHead(out, CBOR_TEXT, length);
+  memcpy(out, text, length);
+  return out + length;
+}
+
+static uint8_t* putCborKey(uint8_t* out, const char* key) {
+  return putCborText(out, key, strlen(key));
+}
+
+static uint8_t* putCborBitset(uint8_t* out, const OccupancyBits* bits, int slotCount) {
+  out = putCborHead(out, CBOR_BYTES, (slotCount + 7) / 8);
+  return putBitset(out, bits, slotCount);
+}
+
+// Encodes a CBOR or packed document into 'out', which holds BINARY_MAX bytes.
+static size_t encodeBinary(const StatusDocument& document, StatusFormat format, uint8_t* out) {
+  uint8_t* start = out;
+  size_t deviceLength = strlen(document.device);
+  if (deviceLength > DEVICE_MAX) {
+    deviceLength = DEVICE_MAX;
+  }
+  if (format == STATUS_FORMAT_PACKED) {
+    *out++ = STATUS_PACKED_VERSION;
+    *out++ = document.hasTrace ? 1 : 0;
+    out = putLittleEndian(out, document.seq, 4);
+    out = putLittleEndian(out, document.hasTrace ? document.traceId : 0, 4);
+    out = putLittleEndian(out, document.slotCount, 2);
+    *out++ = deviceLength;
+    memcpy(out, document.device, deviceLength);
+    out += deviceLength;
+    out = putBitset(out, document.occupied, document.slotCount);
+    out = putBitset(out, document.sensed, document.slotCount);
+    return out - start;
+  }
+
+  out = putCborHead(out, CBOR_MAP, document.hasTrace ? 6 : 5);
+  out = putCborKey(out, "device");
+  out = putCborText(out, document.device, deviceLength);
+  out = putCborKey(out, "seq");
+  out = putCborHead(out, CBOR_UINT, document.seq);
+  out = putCborKey(out, "slots");
+  out = putCborHead(out, CBOR_UINT, document.slotCount);
+  out = putCborKey(out, "occupied");
+  out = putCborBitset(out, document.occupied, document.slotCount);
+  out = putCborKey(out, "sensed");
+  out = putCborBitset(out, document.sensed, document.slotCount);
+  if (document.hasTrace) {
+    out = putCborKey(out, "trace");
+    out = putCborHead(out, CBOR_UINT, document.traceId);
+  }
+  return out - start;
+}
+
+// --- Formats ---
+const char* statusFormatName(StatusFormat format) {
+  switch (format) {
+    case STATUS_FORMAT_CBOR:
+      return "cbor";
+    case STATUS_FORMAT_PACKED:
+      return "packed";
+    default:
+      return "json";
+  }
+}
+
+size_t measureStatusDocument(const StatusDocument& document, StatusFormat format) {
+  if (format == STATUS_FORMAT_JSON) {
+    return measureJson(document);
+  }
+  uint8_t encoded[BINARY_MAX];
+  return encodeBinary(document, format, encoded);
+}
+
+void writeStatusDocument(const StatusDocument& document, StatusFormat format, StatusWriter writer, void* context) {
+  if (format == STATUS_FORMAT_JSON) {
+    writeJson(document, writer, context);
+    return;
+  }
+  uint8_t encoded[BINARY_MAX];
+  size_t length = encodeBinary(document, format, encoded);
+  writer(encoded, length, context);
+}
+
+bool statusDeltaWorthwhile(const OccupancyBits& occupied, const OccupancyBits& published, int slotCount) {
+  int changed = 0;
+  for (int slot = 0; slot < slotCount; slot++) {
+    changed += published.test(slot) != occupied.test(slot);
+  }
+  return changed <= slotCount / STATUS_DELTA_MAX_FRACTION;
+}
+
+// --- Full Document Template ---
+const char STATUS_TOKEN_OCCUPIED[] = "occupied\" ";   // Same width as the one below
+const char STATUS_TOKEN_AVAILABLE[] = "available\"";
+const size_t STATUS_TOKEN_WIDTH = sizeof(STATUS_TOKEN_AVAILABLE) - 1;
+const char TRACE_PREFIX[] = ",\"trace\":{\"id\":";
+const size_t TRACE_WIDTH = sizeof(TRACE_PREFIX) - 1 + STATUS_NUMBER_WIDTH + 1;
+
+// Writes 'value' left-aligned in a field of STATUS_NUMBER_WIDTH, padded with spaces.
+static void putPaddedNumber(char* field, uint32_t value) {
+  char digits[STATUS_NUMBER_WIDTH];
+  int length = 0;
+  do {
+    digits[length++] = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+  for (int i = 0; i < STATUS_NUMBER_WIDTH; i++) {
+    field[i] = i < length ? digits[length - 1 - i] : ' ';
+  }
+}
+
+StatusTemplate::StatusTemplate(char* text, size_t size, uint16_t* offsets, int slotCapacity)
+    : buffer(text),
+      capacity(size),
+      tokenOffsets(offsets),
+      maxSlots(slotCapacity),
+      slots(0),
+      used(0),
+      seqOffset(0),
+      traceOffset(0) {}
+
+bool StatusTemplate::build(const char* device, int slotCount) {
+  slots = 0;
+  if (slotCount < 1 || slotCount > maxSlots || statusTemplateSize(slotCount, strlen(device)) > capacity) {
+    return false;
+  }
+  // The size check above covers every write below.
+  size_t at = snprintf(buffer, capacity, "{\"device\":\"%s\",\"seq\":", device);
+  seqOffset = at;
+  at += STATUS_NUMBER_WIDTH;
+  at += snprintf(buffer + at, capacity - at, ",\"slots\":[");
+  for (int slot = 0; slot < slotCount; slot++) {
+    at += snprintf(buffer + at, capacity - at, "%s{\"slotNumber\":%d,\"status\":\"", slot == 0 ? "" : ",", slot + 1);
+    tokenOffsets[slot] = at;
+    memcpy(buffer + at, STATUS_TOKEN_OCCUPIED, STATUS_TOKEN_WIDTH);
+    at += STATUS_TOKEN_WIDTH;
+    buffer[at++] = '}';
+  }
+  buffer[at++] = ']';
+  traceOffset = at;
+  at += TRACE_WIDTH;
+  buffer[at++] = '}';
+  used = at;
+  putPaddedNumber(buffer + seqOffset, 0);
+  memset(buffer + traceOffset, ' ', TRACE_WIDTH);
+  shown.fill();
+  slots = slotCount;
+  return true;
+}
+
+void StatusTemplate::patch(const StatusDocument& document) {
+  const uint8_t* occupied = document.occupied->bytes();
+  uint8_t* current = shown.bytes();
+  for (int byteIndex = 0; byteIndex < (slots + 7) / 8; byteIndex++) {
+    uint8_t changed = occupied[byteIndex] ^ current[byteIndex];
+    if (changed == 0) {
+      continue;
+    }
+    for (int bit = 0; bit < 8; bit++) {
+      int slot = byteIndex * 8 + bit;
+      if (!(changed & (1 << bit)) || slot >= slots) {
+        continue;
+      }
+      bool isOccupied = (occupied[byteIndex] >> bit) & 1;
+      memcpy(buffer + tokenOffsets[slot], isOccupied ? STATUS_TOKEN_OCCUPIED : STATUS_TOKEN_AVAILABLE,
+             STATUS_TOKEN_WIDTH);
+      shown.set(slot, isOccupied);
+    }
+  }
+  putPaddedNumber(buffer + seqOffset, document.seq);
+  if (document.hasTrace) {
+    memcpy(buffer + traceOffset, TRACE_PREFIX, sizeof(TRACE_PREFIX) - 1);
+    putPaddedNumber(buffer + traceOffset + sizeof(TRACE_PREFIX) - 1, document.traceId);
+    buffer[traceOffset + TRACE_WIDTH - 1] = '}';
+  } else {
+    memset(buffer + traceOffset, ' ', TRACE_WIDTH);
+  }
+}
\ No newline at end of file
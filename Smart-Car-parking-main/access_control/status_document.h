@@ -0,0 +1,152 @@
+#ifndef STATUS_DOCUMENT_H
+#define STATUS_DOCUMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "occupancy.h"
+
+// --- Slot Status Document ---
+// Every status document names the controller and carries a sequence number,
+// so a consumer of many controllers can tell them apart and notice a gap. It
+// goes out in one of three encodings, each on its own topic, so every class
+// of subscriber takes the one it can read:
+//
+// JSON, for the dashboard and everything written before the others:
+//   full   {"device":"a0b1c2d3e4f5","seq":41,"slots":[{"slotNumber":1,"status":"occupied"},...],"trace":{"id":7}}
+//   delta  {"device":"a0b1c2d3e4f5","seq":42,"changes":[{"slotNumber":3,"status":"available"}],"trace":{"id":8}}
+// A delta applies on top of seq - 1 only. Slots without a sensor are listed
+// as occupied. Full documents sent from a StatusTemplate (below) carry extra
+// whitespace so every field keeps a fixed width.
+//
+// CBOR (RFC 8949), a map with text keys:
+//   {"device":tstr, "seq":uint, "slots":uint, "occupied":bstr, "sensed":bstr, ["trace":uint]}
+//
+// Packed, little-endian:
+//   version(1)=1 flags(1) seq(4) traceId(4) slotCount(2) deviceLength(1) device
+//   occupied((slotCount + 7) / 8) sensed((slotCount + 7) / 8)
+// where flags bit 0 is set if traceId is meaningful.
+//
+// In both binary encodings bit i % 8 of byte i / 8 is slot i (0-based), as in
+// OccupancyBits, and the sensed bitset marks the slots that have a sensor.
+// They always carry every slot: at one bit per slot a 512-slot lot fits in
+// under 150 bytes, so deltas are JSON only. Keyframes and the document sent
+// on reconnecting have no trace.
+//
+// Pure formatting with no Arduino dependencies, so the host fleet simulator
+// (tools/fleet_sim) sends byte-for-byte what the controller does.
+struct StatusDocument {
+  const char* device;
+  uint32_t seq;
+  const OccupancyBits* occupied;
+  const OccupancyBits* sensed;
+  int slotCount;
+  const OccupancyBits* baseline;  // Delta against this (JSON only); NULL for a full document
+  bool hasTrace;
+  uint32_t traceId;
+};
+
+enum StatusFormat {
+  STATUS_FORMAT_JSON,
+  STATUS_FORMAT_CBOR,
+  STATUS_FORMAT_PACKED,
+  STATUS_FORMAT_COUNT
+};
+
+const uint8_t STATUS_PACKED_VERSION = 1;
+
+// "json", "cbor" or "packed", for logs and command lines.
+const char* statusFormatName(StatusFormat format);
+
+// Receives the document in pieces of at most STATUS_CHUNK_SIZE bytes.
+typedef void (*StatusWriter)(const uint8_t* data, size_t length, void* context);
+const size_t STATUS_CHUNK_SIZE = 256;
+
+// A delta is sent while at most 1/STATUS_DELTA_MAX_FRACTION of the slots changed.
+const int STATUS_DELTA_MAX_FRACTION = 4;
+
+// Length of the document, which MQTT needs before the first byte goes out.
+size_t measureStatusDocument(const StatusDocument& document, StatusFormat format);
+
+// Formats the document through a small staging buffer rather than in one
+// buffer, which would not fit a JSON document for a site with hundreds of
+// slots. A binary document is always a single piece.
+void writeStatusDocument(const StatusDocument& document, StatusFormat format, StatusWriter writer, void* context);
+
+// True if the change from 'published' is small enough to send as a delta.
+bool statusDeltaWorthwhile(const OccupancyBits& occupied, const OccupancyBits& published, int slotCount);
+
+// --- Full Document Template ---
+// From one full JSON document to the next only the status of the slots that
+// changed, the sequence number and the trace differ. A StatusTemplate lays
+// the document out once with each of those at a fixed width and records
+// where they are, so a publish patches a few bytes and sends the buffer:
+//   {"device":"a0b1c2d3e4f5","seq":41        ,"slots":[{"slotNumber":1,"status":"occupied" },...],"trace":{"id":7         }}
+// Status values are padded after the closing quote, numbers after the last
+// digit, and a document without a trace has spaces where the trace would be.
+// All of it is JSON whitespace, so consumers read the same document.
+const int STATUS_NUMBER_WIDTH = 10;  // Digits in the largest uint32_t
+
+// Total digits in the slot numbers 1..slots.
+constexpr size_t slotNumberDigits(int slots, int first = 1, int digits = 1) {
+  return slots < first ? 0
+                       : (size_t)((slots < first * 10 - 1 ? slots : first * 10 - 1) - first + 1) * digits +
+                             slotNumberDigits(slots, first * 10, digits + 1);
+}
+
+// Bytes in a templated document: header and seq, one entry per slot with
+// commas between them, then the trace and the closing braces.
+constexpr size_t statusTemplateSize(int slots, size_t deviceLength) {
+  return 29 + deviceLength + STATUS_NUMBER_WIDTH + 36 * slots + slotNumberDigits(slots) + (slots > 0 ? slots - 1 : 0) +
+         18 + STATUS_NUMBER_WIDTH;
+}
+
+// The layout and patching; FixedStatusTemplate supplies the storage.
+class StatusTemplate {
+ public:
+  // Lays out a full document for 'slotCount' slots, every one occupied.
+  // Returns false, leaving the template unbuilt, if it does not fit.
+  bool build(const char* device, int slotCount);
+
+  bool built() const { return slots > 0; }
+  int slotCount() const { return slots; }
+
+  // Brings the text up to date with a full document for the slot count it
+  // was built for, rewriting only the status tokens that differ.
+  void patch(const StatusDocument& document);
+
+  const char* text() const { return buffer; }
+  size_t length() const { return used; }
+
+ protected:
+  StatusTemplate(char* buffer, size_t capacity, uint16_t* tokenOffsets, int maxSlots);
+
+ private:
+  StatusTemplate(const StatusTemplate&);
+  StatusTemplate& operator=(const StatusTemplate&);
+
+  char* buffer;
+  size_t capacity;
+  uint16_t* tokenOffsets;  // Where each slot's status token starts
+  int maxSlots;
+  int slots;
+  size_t used;
+  size_t seqOffset;
+  size_t traceOffset;      // Start of ,"trace":{"id":N}
+  OccupancyBits shown;     // The occupancy the text currently says
+};
+
+// A template sized at compile time for a site of SLOTS slots whose device
+// IDs are DEVICE_LENGTH characters (a MAC in hex).
+template <int SLOTS, size_t DEVICE_LENGTH = 12>
+class FixedStatusTemplate : public StatusTemplate {
+ public:
+  FixedStatusTemplate() : StatusTemplate(storage, sizeof(storage), offsets, SLOTS) {}
+
+ private:
+  static_assert(statusTemplateSize(SLOTS, DEVICE_LENGTH) <= 0xFFFF, "token offsets are 16 bits");
+
+  char storage[statusTemplateSize(SLOTS, DEVICE_LENGTH)];
+  uint16_t offsets[SLOTS];
+};
+
+#endif
\ No newline at end of file
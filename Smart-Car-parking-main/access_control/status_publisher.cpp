@@ -0,0 +1,142 @@
+#include "status_publisher.h"
+#include <stdio.h>
+#include <string.h>
+#include "logger.h"
+#include "heap_tracker.h"
+
+// --- Topics ---
+const char* MQTT_PUBLISH_TOPIC_TRACE = "parking/esp32/trace";
+
+StatusPublisher::StatusPublisher()
+    : sensed(NULL),
+      link(NULL),
+      timers(NULL),
+      clock(NULL),
+      latestSlotCount(0),
+      publishedSlotCount(0),
+      statusSeq(0),
+      keyframeTimer(onKeyframeTimer, this) {
+  deviceId[0] = '\0';
+  config.topics = NULL;
+  config.topicCount = 0;
+  config.deltas = false;
+  config.fullTemplate = NULL;
+}
+
+void StatusPublisher::begin(const char* device, const StatusConfig& statusConfig, const OccupancyBits& sensedSlots,
+                            MessageLink& messageLink, TimerWheel& timerWheel, ControllerClock& controllerClock) {
+  snprintf(deviceId, sizeof(deviceId), "%s", device);
+  config = statusConfig;
+  sensed = &sensedSlots;
+  link = &messageLink;
+  timers = &timerWheel;
+  clock = &controllerClock;
+  if (config.deltas) {
+    timers->arm(keyframeTimer, STATUS_KEYFRAME_INTERVAL);
+  }
+}
+
+static void writeToLink(const uint8_t* data, size_t length, void* context) {
+  static_cast<MessageLink*>(context)->write(data, length);
+}
+
+// True if full JSON documents for 'slotCount' slots can come from the
+// template, which is built on first use.
+bool StatusPublisher::templateReady(int slotCount) {
+  StatusTemplate* full = config.fullTemplate;
+  return full != NULL && (full->slotCount() == slotCount || full->build(deviceId, slotCount));
+}
+
+// Sends a full document, or a delta against 'baseline' on the JSON topics,
+// to every topic under one sequence number. The length has to be known up
+// front, so each document is formatted twice, once to measure it and once to
+// send it, unless it comes patched from the template. The trace's
+// 'serialized' stage is the first topic's.
+void StatusPublisher::send(const OccupancyBits& occupied, int slotCount, const OccupancyBits* baseline,
+                           const SlotTrace* trace) {
+  int64_t publishUs = clock->traceNowUs();
+  int64_t serializedUs = 0;
+  StatusDocument document;
+  document.device = deviceId;
+  document.seq = statusSeq + 1;
+  document.occupied = &occupied;
+  document.sensed = sensed;
+  document.slotCount = slotCount;
+  document.hasTrace = trace != NULL;
+  document.traceId = trace != NULL ? trace->id : 0;
+  for (int i = 0; i < config.topicCount; i++) {
+    const StatusTopic& topic = config.topics[i];
+    document.baseline = topic.format == STATUS_FORMAT_JSON ? baseline : NULL;
+    bool templated = topic.format == STATUS_FORMAT_JSON && baseline == NULL && templateReady(slotCount);
+    size_t length;
+    if (templated) {
+      config.fullTemplate->patch(document);
+      length = config.fullTemplate->length();
+    } else {
+      length = measureStatusDocument(document, topic.format);
+    }
+    if (i == 0) {
+      serializedUs = clock->traceNowUs();
+    }
+
+    LOG_DEBUG(NET_PUBLISH_SLOTS, (unsigned int)length, topic.topic);
+    link->beginPublish(topic.topic, length);
+    if (templated) {
+      link->write((const uint8_t*)config.fullTemplate->text(), length);
+    } else {
+      writeStatusDocument(document, topic.format, writeToLink, link);
+    }
+    link->endPublish();
+  }
+  int64_t sentUs = clock->traceNowUs();
+
+  statusSeq++;
+  publishedStatus = occupied;
+  publishedSlotCount = slotCount;
+  if (config.deltas && baseline == NULL) {
+    timers->arm(keyframeTimer, STATUS_KEYFRAME_INTERVAL);
+  }
+  if (trace == NULL) {
+    return;
+  }
+
+  // The stage timestamps go out separately, since 'sent' is only known now.
+  char traceBuffer[256];
+  snprintf(traceBuffer, sizeof(traceBuffer),
+           "{\"kind\":\"slot\",\"id\":%lu,\"synced\":%s,\"edgeUs\":%lld,\"detectUs\":%lld,\"publishUs\":%lld,"
+           "\"serializedUs\":%lld,\"sentUs\":%lld}",
+           (unsigned long)trace->id, clock->isTraceSynced() ? "true" : "false", (long long)trace->edgeUs,
+           (long long)trace->detectUs, (long long)publishUs, (long long)serializedUs, (long long)sentUs);
+  link->publish(MQTT_PUBLISH_TOPIC_TRACE, traceBuffer);
+}
+
+// No full document for a while: send one, whether or not anything changed.
+void StatusPublisher::onKeyframeTimer(void* context) {
+  StatusPublisher* publisher = static_cast<StatusPublisher*>(context);
+  publisher->timers->arm(publisher->keyframeTimer, STATUS_KEYFRAME_INTERVAL);
+  if (publisher->link->connected() && publisher->latestSlotCount > 0) {
+    publisher->send(publisher->latestStatus, publisher->latestSlotCount, NULL, NULL);
+  }
+}
+
+void StatusPublisher::connected() {
+  if (latestSlotCount > 0) {
+    send(latestStatus, latestSlotCount, NULL, NULL); // Whatever changed while we were away
+  }
+}
+
+void StatusPublisher::publish(const OccupancyBits& occupied, int slotCount, const SlotTrace& trace) {
+  HeapScope heapScope(HEAP_MODULE_NETWORK);
+  latestStatus = occupied;
+  latestSlotCount = slotCount;
+  if (!link->connected()) {
+    LOG_WARN(NET_PUBLISH_OFFLINE);
+    return;
+  }
+  const OccupancyBits* baseline = NULL;
+  if (config.deltas && publishedSlotCount == slotCount &&
+      statusDeltaWorthwhile(occupied, publishedStatus, slotCount)) {
+    baseline = &publishedStatus;
+  }
+  send(occupied, slotCount, baseline, &trace);
+}
@@ -0,0 +1,69 @@
+#ifndef STATUS_PUBLISHER_H
+#define STATUS_PUBLISHER_H
+
+#include "controller_clock.h"
+#include "message_link.h"
+#include "occupancy.h"
+#include "status_document.h"
+#include "timer_wheel.h"
+#include "trace.h"
+
+// A topic the status goes out on, and the encoding its subscribers read.
+struct StatusTopic {
+  const char* topic;
+  StatusFormat format;
+};
+
+struct StatusConfig {
+  const StatusTopic* topics;      // Every change goes to each of these, in order
+  int topicCount;
+  bool deltas;                    // JSON topics list only the changed slots between keyframes
+  StatusTemplate* fullTemplate;   // Optional: full JSON documents are patched into it, not formatted
+};
+
+// Keeps a consumer's view of the slots current: every change goes out as a
+// status document (status_document.h) on each configured topic, followed by
+// its trace, and the latest occupancy is kept while offline so it can go out
+// in full on reconnecting. With deltas on, JSON documents list only the slots
+// that changed, in full again whenever too many did and every
+// STATUS_KEYFRAME_INTERVAL so a consumer that missed a delta catches up.
+class StatusPublisher {
+ public:
+  static const TimeMs STATUS_KEYFRAME_INTERVAL = 60000;
+
+  StatusPublisher();
+
+  // 'device' (up to 12 characters) is copied; the rest must outlive the
+  // publisher. 'sensed' marks the slots that have a sensor.
+  void begin(const char* device, const StatusConfig& config, const OccupancyBits& sensed, MessageLink& link,
+             TimerWheel& timers, ControllerClock& clock);
+
+  // A change seen by the slot monitor.
+  void publish(const OccupancyBits& occupied, int slotCount, const SlotTrace& trace);
+
+  // Call once the session is (re)established: sends the latest status in full.
+  void connected();
+
+ private:
+  StatusPublisher(const StatusPublisher&);            // Linked into the timer wheel: not copyable
+  StatusPublisher& operator=(const StatusPublisher&);
+
+  static void onKeyframeTimer(void* context);
+  bool templateReady(int slotCount);
+  void send(const OccupancyBits& occupied, int slotCount, const OccupancyBits* baseline, const SlotTrace* trace);
+
+  char deviceId[13];
+  StatusConfig config;
+  const OccupancyBits* sensed;
+  MessageLink* link;
+  TimerWheel* timers;
+  ControllerClock* clock;
+  OccupancyBits latestStatus;
+  int latestSlotCount;  // 0 until the slot monitor has reported
+  OccupancyBits publishedStatus;
+  int publishedSlotCount;
+  uint32_t statusSeq;
+  Timer keyframeTimer;
+};
+
+#endif
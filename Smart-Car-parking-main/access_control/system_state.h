@@ -1,8 +1,16 @@
 #ifndef SYSTEM_STATE_H
 #define SYSTEM_STATE_H
 
-// A global flag to communicate between modules.
-// 'extern' tells the compiler this variable is defined in another file.
-extern bool userJustValidated;
+#include "timer_wheel.h"
+#include "trace.h"
+
+// The one timer wheel every module arms its timeouts on. Defined in
+// access_control.ino and advanced at the top of loop().
+extern TimerWheel systemTimers;
+
+// The clocks handed to the controllers (gates, slots, status) along with
+// systemTimers. Their classes take both by reference, so a host build can run
+// many controllers side by side; the firmware has one of each.
+extern EspClock systemClock;
 
 #endif
\ No newline at end of file
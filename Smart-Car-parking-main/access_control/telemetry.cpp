@@ -0,0 +1,153 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "telemetry.h"
+#include "network_handler.h"
+#include "heap_tracker.h"
+#include "logger.h"
+#include "system_state.h"
+#include "gate_handler.h"
+#include "servo_motion.h"
+#include "power.h"
+#include "rfid_handler.h"
+#include "slot_handler.h"
+
+// --- Constants ---
+const TimeMs TELEMETRY_INTERVAL = 60000; // Publish once a minute
+
+static void publishTelemetryNow(void*);
+static Timer telemetryTimer(publishTelemetryNow);
+
+// Pool the document needs: ArduinoJson takes one slot per member or element,
+// and every key and string here is a literal or a long-lived name, stored by
+// pointer. Keep in step with the fields below.
+static size_t telemetryCapacity(int lanes, int readers, int buses) {
+  return JSON_OBJECT_SIZE(9)                                                    // Top level
+         + JSON_OBJECT_SIZE(6) + JSON_ARRAY_SIZE(HEAP_MODULE_COUNT)             // heap
+         + HEAP_MODULE_COUNT * JSON_OBJECT_SIZE(10)
+         + JSON_OBJECT_SIZE(lanes) + lanes * JSON_OBJECT_SIZE(10)               // gate
+         + JSON_OBJECT_SIZE(2) + JSON_OBJECT_SIZE(4) + JSON_OBJECT_SIZE(4)      // servo, sampling, power
+         + JSON_OBJECT_SIZE(3 + readers) + JSON_OBJECT_SIZE(8)                  // rfid, rpc
+         + readers * JSON_OBJECT_SIZE(5)
+         + JSON_ARRAY_SIZE(buses) + buses * JSON_OBJECT_SIZE(5);                // sensorBuses
+}
+
+static void addHeapTelemetry(JsonObject heap) {
+  HeapSnapshot snapshot = getHeapSnapshot();
+  heap["free"] = snapshot.freeBytes;
+  heap["minFree"] = snapshot.minFreeBytes;
+  heap["largestBlock"] = snapshot.largestFreeBlock;
+  heap["allocatedBlocks"] = snapshot.allocatedBlocks;
+  heap["fragmentationPct"] = snapshot.fragmentationPct;
+
+  JsonArray modules = heap.createNestedArray("modules");
+  for (int i = 0; i < HEAP_MODULE_COUNT; i++) {
+    const HeapModuleStats& stats = getHeapModuleStats((HeapModule)i);
+    JsonObject module = modules.createNestedObject();
+    module["name"] = getHeapModuleName((HeapModule)i);
+    module["calls"] = stats.calls;
+    module["allocs"] = stats.allocs;
+    module["frees"] = stats.frees;
+    module["bytesAllocated"] = stats.bytesAllocated;
+    module["bytesFreed"] = stats.bytesFreed;
+    module["netBytes"] = stats.netBytes;
+    module["peakNetBytes"] = stats.peakNetBytes;
+    module["netBlocks"] = stats.netBlocks;
+    module["blockShrinks"] = stats.blockShrinks;
+  }
+}
+
+static void addGateTelemetry(JsonObject gate, const GateStats& gateStats) {
+  gate["cycles"] = gateStats.cycles;
+  gate["vehicles"] = gateStats.vehicles;
+  gate["vehiclesPerMinute"] = gateStats.vehiclesLastMinute;
+  gate["averageCycleMs"] = gateStats.averageCycleMs;
+  gate["entries"] = gateStats.entries;
+  gate["entriesPerCycle"] = gateStats.cycles ? (float)gateStats.entries / gateStats.cycles : 0.0f;
+  gate["maxEntriesPerCycle"] = gateStats.maxEntriesPerCycle;
+  gate["coalesced"] = gateStats.coalesced;
+  gate["noShows"] = gateStats.noShows;
+  gate["queueOverflows"] = gateStats.queueOverflows;
+}
+
+static void addRfidTelemetry(JsonObject reader, const RfidReaderStats& readerStats) {
+  reader["requests"] = readerStats.requests;
+  reader["requestsPerSecond"] = millis() > 0 ? readerStats.requests * 1000.0f / millis() : 0.0f;
+  reader["irqs"] = readerStats.irqs;
+  reader["cards"] = readerStats.cards;
+  reader["busyUs"] = readerStats.busyUs;
+}
+
+void setupTelemetry() {
+  systemTimers.arm(telemetryTimer, TELEMETRY_INTERVAL);
+}
+
+// Runs from the timer wheel and re-arms itself.
+static void publishTelemetryNow(void*) {
+  systemTimers.arm(telemetryTimer, TELEMETRY_INTERVAL);
+
+  // On the heap only while it is sent, not on the loop task's stack.
+  size_t capacity = telemetryCapacity(GATE_LANE_COUNT, getRfidReaderCount(), getSlotBusCount());
+  DynamicJsonDocument doc(capacity);
+  if (doc.capacity() == 0) {
+    LOG_WARN(TELEMETRY_NO_MEMORY, (unsigned int)capacity);
+    return;
+  }
+  doc["uptimeMs"] = millis();
+  doc["logDropped"] = getLogDroppedCount();
+  addHeapTelemetry(doc.createNestedObject("heap"));
+
+  JsonObject gates = doc.createNestedObject("gate");
+  for (int lane = 0; lane < GATE_LANE_COUNT; lane++) {
+    addGateTelemetry(gates.createNestedObject(getGateLaneName(lane)), getGateStats(lane));
+  }
+  JsonObject servos = doc.createNestedObject("servo");
+  servos["staggeredStarts"] = ServoMotion::staggeredStarts();
+  servos["longestStaggerMs"] = ServoMotion::longestStaggerMs();
+
+  SlotSamplingStats samplingStats = getSlotSamplingStats();
+  JsonObject sampling = doc.createNestedObject("sampling");
+  sampling["intervalMs"] = samplingStats.intervalMs;
+  sampling["maxLatencyMs"] = samplingStats.maxLatencyMs;
+  sampling["samples"] = samplingStats.samples;
+  sampling["cpuSavedUs"] = samplingStats.cpuSavedUs;
+
+  PowerStats powerStats = getPowerStats();
+  JsonObject power = doc.createNestedObject("power");
+  power["mode"] = powerStats.mode;
+  power["idlePct"] = millis() > 0 ? (uint32_t)((uint64_t)powerStats.idleMs * 100 / millis()) : 0;
+  power["idleCalls"] = powerStats.idleCalls;
+  power["earlyWakes"] = powerStats.earlyWakes;
+
+  JsonObject rfid = doc.createNestedObject("rfid");
+  rfid["suppressedRepeats"] = getRfidSuppressedRepeats();
+  rfid["passbackRefusals"] = getRfidPassbackRefusals();
+  RfidRpcStats rpcStats = getRfidRpcStats();
+  JsonObject rpc = rfid.createNestedObject("rpc");
+  rpc["requests"] = rpcStats.requests;
+  rpc["granted"] = rpcStats.granted;
+  rpc["denied"] = rpcStats.denied;
+  rpc["timeouts"] = rpcStats.timeouts;
+  rpc["unmatched"] = rpcStats.unmatched;
+  rpc["rejected"] = rpcStats.rejected;
+  rpc["lastRoundTripMs"] = rpcStats.lastRoundTripMs;
+  rpc["maxRoundTripMs"] = rpcStats.maxRoundTripMs;
+  for (int reader = 0; reader < getRfidReaderCount(); reader++) {
+    addRfidTelemetry(rfid.createNestedObject(getRfidReaderName(reader)), getRfidReaderStats(reader));
+  }
+
+  JsonArray buses = doc.createNestedArray("sensorBuses");
+  for (int bus = 0; bus < getSlotBusCount(); bus++) {
+    SlotBusStats busStats = getSlotBusStats(bus);
+    JsonObject busObject = buses.createNestedObject();
+    busObject["name"] = busStats.name;
+    busObject["sensors"] = busStats.sensors;
+    busObject["samples"] = busStats.samples;
+    busObject["nsPerSensor"] = busStats.nsPerSensor;
+    busObject["lastSampleNs"] = busStats.lastSampleNs;
+  }
+
+  if (doc.overflowed()) {
+    LOG_WARN(TELEMETRY_OVERFLOW, (unsigned int)doc.capacity()); // Sent anyway: what fitted is still worth having
+  }
+  publishTelemetry(doc);
+}
@@ -0,0 +1,8 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+// Starts publishing a health document (heap, logger, ...) every
+// TELEMETRY_INTERVAL from the system timer wheel.
+void setupTelemetry();
+
+#endif
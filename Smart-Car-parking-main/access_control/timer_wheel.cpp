@@ -0,0 +1,139 @@
+#include "timer_wheel.h"
+
+TimerWheel::TimerWheel() : current(0), armed(0) {
+  for (int level = 0; level < LEVELS; level++) {
+    for (int slot = 0; slot < SLOTS; slot++) {
+      slots[level][slot] = NULL;
+    }
+  }
+}
+
+void TimerWheel::begin(TimeMs now) {
+  current = now;
+}
+
+void TimerWheel::arm(Timer& timer, TimeMs delayMs) {
+  if (isArmed(timer)) {
+    unlink(timer);
+    armed--;
+  }
+  // A zero delay still has to wait for the next tick; the current one is done.
+  timer.expires = current + (delayMs == 0 ? 1 : delayMs);
+  insert(timer);
+  armed++;
+}
+
+void TimerWheel::cancel(Timer& timer) {
+  if (isArmed(timer)) {
+    unlink(timer);
+    armed--;
+  }
+}
+
+void TimerWheel::insert(Timer& timer) {
+  uint32_t delta = timer.expires - current;
+  TimeMs filedAt = timer.expires;
+  if ((int32_t)delta < 0) {
+    // Overdue, which only a re-file can produce: run it this tick.
+    delta = 0;
+    filedAt = current;
+  } else if (delta >= HORIZON) {
+    // Beyond the wheel: park in the furthest slot, re-filed on cascade.
+    delta = HORIZON - 1;
+    filedAt = current + delta;
+  }
+
+  int level = 0;
+  while (level < LEVELS - 1 && delta >= (1UL << ((level + 1) * SLOT_BITS))) {
+    level++;
+  }
+  Timer** head = &slots[level][(filedAt >> (level * SLOT_BITS)) & SLOT_MASK];
+
+  timer.next = *head;
+  if (timer.next != NULL) {
+    timer.next->pprev = &timer.next;
+  }
+  timer.pprev = head;
+  *head = &timer;
+}
+
+void TimerWheel::unlink(Timer& timer) {
+  *timer.pprev = timer.next;
+  if (timer.next != NULL) {
+    timer.next->pprev = timer.pprev;
+  }
+  timer.next = NULL;
+  timer.pprev = NULL;
+}
+
+// Moves the timers of the level's current slot one level down.
+void TimerWheel::cascade(int level) {
+  Timer** head = &slots[level][(current >> (level * SLOT_BITS)) & SLOT_MASK];
+  Timer* timer = *head;
+  *head = NULL;
+  while (timer != NULL) {
+    Timer* next = timer->next;
+    timer->next = NULL;
+    timer->pprev = NULL;
+    insert(*timer);
+    timer = next;
+  }
+}
+
+TimeMs TimerWheel::timeUntilNext(TimeMs limit) const {
+  if (armed == 0) {
+    return limit;
+  }
+  TimeMs best = limit;
+  for (int level = 0; level < LEVELS; level++) {
+    int shift = level * SLOT_BITS;
+    uint32_t base = current >> shift;
+    // Slots ahead of the current one at this level, nearest first. A level
+    // 0 slot is an expiry; a higher one is a cascade at the start of its span.
+    for (uint32_t offset = 1; offset <= SLOTS; offset++) {
+      TimeMs at = (base + offset) << shift;
+      TimeMs delta = at - current;
+      if (delta >= best) {
+        break;
+      }
+      if (slots[level][(base + offset) & SLOT_MASK] != NULL) {
+        best = delta;
+        break;
+      }
+    }
+  }
+  return best;
+}
+
+void TimerWheel::advance(TimeMs now) {
+  if (armed == 0) {
+    current = now; // Nothing to expire; skip the idle ticks
+    return;
+  }
+  while (current != now) {
+    current++;
+
+    // Level 0 just wrapped: pull the next batch down from above.
+    for (int level = 1; level < LEVELS; level++) {
+      if (((current >> ((level - 1) * SLOT_BITS)) & SLOT_MASK) != 0) {
+        break;
+      }
+      cascade(level);
+    }
+
+    Timer** head = &slots[0][current & SLOT_MASK];
+    while (*head != NULL) {
+      Timer* timer = *head;
+      unlink(*timer);
+      armed--;
+      if (timer->callback != NULL) {
+        timer->callback(timer->context);
+      }
+    }
+
+    if (armed == 0) {
+      current = now;
+      return;
+    }
+  }
+}
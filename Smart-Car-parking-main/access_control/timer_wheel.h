@@ -0,0 +1,87 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Rollover-safe Time ---
+// millis() wraps every ~49.7 days. Compare times only through these helpers,
+// which stay correct across the wrap for intervals shorter than ~24.8 days.
+typedef uint32_t TimeMs;
+
+inline bool timeReached(TimeMs now, TimeMs deadline) {
+  return (int32_t)(now - deadline) >= 0;
+}
+
+inline TimeMs timeElapsed(TimeMs now, TimeMs since) {
+  return now - since;
+}
+
+typedef void (*TimerCallback)(void* context);
+
+// One timeout. Timers are owned by the module that uses them (usually a
+// file-level static) and linked into the wheel while armed, so arming never
+// allocates. A timer with no callback still expires, which makes it usable as
+// a simple cooldown via isArmed().
+class Timer {
+ public:
+  explicit Timer(TimerCallback callback = NULL, void* context = NULL)
+      : callback(callback), context(context), next(NULL), pprev(NULL), expires(0) {}
+
+ private:
+  friend class TimerWheel;
+  TimerCallback callback;
+  void* context;
+  Timer* next;
+  Timer** pprev; // Points at whatever points at us; NULL while disarmed
+  TimeMs expires;
+};
+
+// Hierarchical timer wheel with 1 ms ticks: four levels of 64 slots cover
+// 2^24 ms (~4.6 h) with O(1) arm and cancel; longer timers are parked in the
+// last level and re-filed as they come closer. Callbacks run from advance(),
+// i.e. on the loop task, and may arm or cancel any timer, including their own.
+class TimerWheel {
+ public:
+  TimerWheel();
+
+  // Sets the wheel's notion of "now". Call once before arming anything.
+  void begin(TimeMs now);
+
+  // (Re)arms a timer to fire delayMs from the wheel's current time.
+  void arm(Timer& timer, TimeMs delayMs);
+
+  // Disarms a timer; harmless if it is not armed.
+  void cancel(Timer& timer);
+
+  bool isArmed(const Timer& timer) const { return timer.pprev != NULL; }
+
+  // Runs every callback that is due by 'now'. Call once per loop pass.
+  void advance(TimeMs now);
+
+  uint32_t armedCount() const { return armed; }
+  TimeMs now() const { return current; }
+
+  // Milliseconds from the wheel's current time until advance() next has
+  // something to do (run a timer or re-file one from a higher level), capped
+  // at 'limit'. Never later than the real next expiry, so it is safe to sleep
+  // this long.
+  TimeMs timeUntilNext(TimeMs limit) const;
+
+ private:
+  static const int LEVELS = 4;
+  static const int SLOT_BITS = 6;
+  static const int SLOTS = 1 << SLOT_BITS;
+  static const uint32_t SLOT_MASK = SLOTS - 1;
+  static const uint32_t HORIZON = 1UL << (LEVELS * SLOT_BITS);
+
+  void insert(Timer& timer);
+  void unlink(Timer& timer);
+  void cascade(int level);
+
+  Timer* slots[LEVELS][SLOTS];
+  TimeMs current; // Last tick processed
+  uint32_t armed;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+#include "trace.h"
+#include "logger.h"
+
+// --- Configuration ---
+const char* NTP_SERVER = "pool.ntp.org";
+const time_t TRACE_SYNCED_AFTER = 1600000000; // Any earlier clock is unsynced
+
+void setupTrace() {
+  configTime(0, 0, NTP_SERVER); // UTC; the collector compares raw epoch times
+}
+
+bool isTraceClockSynced() {
+  return time(NULL) > TRACE_SYNCED_AFTER;
+}
+
+int64_t traceNowUs() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (int64_t)now.tv_sec * 1000000LL + now.tv_usec;
+}
+
+int64_t traceFromMonotonicUs(int64_t monotonicUs) {
+  // Both clocks advance together, so the offset between them is constant
+  // until SNTP slews the wall clock; sampling it now is accurate to a few us.
+  return monotonicUs + (traceNowUs() - esp_timer_get_time());
+}
+
+int64_t EspClock::monotonicUs() {
+  return esp_timer_get_time();
+}
+
+int64_t EspClock::traceNowUs() {
+  return ::traceNowUs();
+}
+
+int64_t EspClock::traceFromMonotonicUs(int64_t monotonicUs) {
+  return ::traceFromMonotonicUs(monotonicUs);
+}
+
+bool EspClock::isTraceSynced() {
+  return isTraceClockSynced();
+}
+
+uint32_t EspClock::cycleCount() {
+  return ESP.getCycleCount();
+}
+
+uint32_t EspClock::cyclesPerUs() {
+  return ESP.getCpuFreqMHz();
+}
@@ -0,0 +1,47 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "controller_clock.h"
+
+// --- Latency Tracing ---
+// Slot events and door commands carry a trace ID and wall-clock timestamps
+// (microseconds since the Unix epoch, synchronised over SNTP) so a collector
+// on the other side of the broker can split end-to-end latency into stages.
+// See tools/latency_collector.py.
+
+// Timestamps of one slot state change, filled in as it moves through the firmware.
+struct SlotTrace {
+  uint32_t id;      // Below SYNTHETIC_TRACE_ID_BASE for real slot events
+  int64_t edgeUs;   // Sensor GPIO edge (ISR), or detectUs if no edge was seen
+  int64_t detectUs; // Sample that noticed the change
+};
+
+// Trace IDs from here up are reserved for injected traffic (the heap soak),
+// so a collector can tell it from real slot events.
+const uint32_t SYNTHETIC_TRACE_ID_BASE = 0x80000000UL;
+
+// Starts SNTP. Call once WiFi is connected.
+void setupTrace();
+
+// True once SNTP has set the clock; until then timestamps are time since boot.
+bool isTraceClockSynced();
+
+// Current trace time in microseconds.
+int64_t traceNowUs();
+
+// Converts an esp_timer_get_time() value (e.g. taken in an ISR) to trace time.
+int64_t traceFromMonotonicUs(int64_t monotonicUs);
+
+// The ESP32's clocks, as the controllers see them.
+class EspClock : public ControllerClock {
+ public:
+  int64_t monotonicUs();
+  int64_t traceNowUs();
+  int64_t traceFromMonotonicUs(int64_t monotonicUs);
+  bool isTraceSynced();
+  uint32_t cycleCount();
+  uint32_t cyclesPerUs();
+};
+
+#endif
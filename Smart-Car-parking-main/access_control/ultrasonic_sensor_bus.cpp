@@ -0,0 +1,162 @@
+#include "ultrasonic_sensor_bus.h"
+#include "system_state.h"
+#include "power.h"
+#include <esp_timer.h>
+
+// --- Constants ---
+// A ping and its echoes die out within ~40 ms (the HC-SR04 gives up at ~38 ms).
+const TimeMs ULTRASONIC_GROUP_INTERVAL_MS = 60;
+const unsigned int ULTRASONIC_TRIGGER_US = 10;
+const int64_t ULTRASONIC_US_PER_CM = 58;        // Round trip at ~343 m/s
+const uint16_t ULTRASONIC_HYSTERESIS_CM = 15;   // Must move this far past the threshold to clear
+
+UltrasonicSensorBus::UltrasonicSensorBus(const UltrasonicConfig* sensors, int count)
+    : configs(sensors), count(count < MAX_SENSORS ? count : MAX_SENSORS), groupCount(0),
+      currentGroup(0), groupTimer(onGroupTimer, this), echoesDone(0), measurements(0), timeouts(0) {
+  portMUX_TYPE unlocked = portMUX_INITIALIZER_UNLOCKED;
+  echoMux = unlocked;
+}
+
+// The first edge after a trigger is the echo going high, the second its end.
+void IRAM_ATTR UltrasonicSensorBus::onEcho(void* arg) {
+  Sensor* sensor = static_cast<Sensor*>(arg);
+  int64_t now = esp_timer_get_time();
+  bool done = false;
+  portENTER_CRITICAL_ISR(&sensor->bus->echoMux);
+  if (sensor->state == ECHO_WAIT_RISE) {
+    sensor->riseUs = now;
+    sensor->state = ECHO_WAIT_FALL;
+  } else if (sensor->state == ECHO_WAIT_FALL) {
+    sensor->fallUs = now;
+    sensor->state = ECHO_DONE;
+    sensor->bus->echoesDone++;
+    done = true;
+  }
+  portEXIT_CRITICAL_ISR(&sensor->bus->echoMux);
+  if (done) {
+    wakeLoopFromISR();
+  }
+}
+
+void UltrasonicSensorBus::begin() {
+  for (int i = 0; i < count; i++) {
+    Sensor& sensor = sensors[i];
+    sensor.bus = this;
+    sensor.index = i;
+    sensor.state = ECHO_IDLE;
+    sensor.riseUs = 0;
+    sensor.fallUs = 0;
+    sensor.occupied = true; // Unknown until measured: don't send anyone there
+    sensor.candidate = true;
+    sensor.changedUs = 0;
+    pinMode(configs[i].echoPin, INPUT);
+    attachInterruptArg(configs[i].echoPin, onEcho, &sensor, CHANGE);
+
+    bool known = false;
+    for (int group = 0; group < groupCount; group++) {
+      known = known || triggerPins[group] == configs[i].triggerPin;
+    }
+    if (!known && groupCount < MAX_GROUPS) {
+      triggerPins[groupCount++] = configs[i].triggerPin;
+      pinMode(configs[i].triggerPin, OUTPUT);
+      digitalWrite(configs[i].triggerPin, LOW);
+    }
+  }
+  if (groupCount > 0) {
+    systemTimers.arm(groupTimer, ULTRASONIC_GROUP_INTERVAL_MS);
+  }
+}
+
+void UltrasonicSensorBus::onGroupTimer(void* context) {
+  static_cast<UltrasonicSensorBus*>(context)->startNextGroup();
+}
+
+// Closes the previous group's measurement window and pings the next group.
+void UltrasonicSensorBus::startNextGroup() {
+  systemTimers.arm(groupTimer, ULTRASONIC_GROUP_INTERVAL_MS);
+
+  int triggerPin = triggerPins[currentGroup];
+  portENTER_CRITICAL(&echoMux);
+  for (int i = 0; i < count; i++) {
+    if (configs[i].triggerPin != triggerPin) {
+      continue;
+    }
+    if (sensors[i].state == ECHO_WAIT_RISE || sensors[i].state == ECHO_WAIT_FALL) {
+      timeouts++; // No complete echo: keep the slot's last state
+    }
+    if (sensors[i].state != ECHO_DONE) {
+      sensors[i].state = ECHO_IDLE;
+    }
+  }
+  portEXIT_CRITICAL(&echoMux);
+
+  currentGroup = (currentGroup + 1) % groupCount;
+  triggerPin = triggerPins[currentGroup];
+  portENTER_CRITICAL(&echoMux);
+  for (int i = 0; i < count; i++) {
+    if (configs[i].triggerPin == triggerPin && sensors[i].state != ECHO_DONE) {
+      sensors[i].state = ECHO_WAIT_RISE;
+    }
+  }
+  portEXIT_CRITICAL(&echoMux);
+
+  // The only busy wait: the 10 us trigger pulse, once per group.
+  digitalWrite(triggerPin, HIGH);
+  delayMicroseconds(ULTRASONIC_TRIGGER_US);
+  digitalWrite(triggerPin, LOW);
+}
+
+void UltrasonicSensorBus::evaluate(Sensor& sensor) {
+  portENTER_CRITICAL(&echoMux);
+  int64_t riseUs = sensor.riseUs;
+  int64_t fallUs = sensor.fallUs;
+  sensor.state = ECHO_IDLE;
+  echoesDone--;
+  portEXIT_CRITICAL(&echoMux);
+  measurements++;
+
+  const UltrasonicConfig& config = configs[sensor.index];
+  int64_t distanceCm = (fallUs - riseUs) / ULTRASONIC_US_PER_CM;
+  bool verdict = sensor.occupied;
+  if (distanceCm < config.thresholdCm) {
+    verdict = true;
+  } else if (distanceCm > config.thresholdCm + ULTRASONIC_HYSTERESIS_CM) {
+    verdict = false;
+  }
+
+  if (verdict != sensor.occupied && verdict == sensor.candidate) {
+    sensor.occupied = verdict;
+    sensor.changedUs = fallUs;
+  }
+  sensor.candidate = verdict;
+}
+
+void UltrasonicSensorBus::sample(OccupancyBits& occupied) {
+  for (int i = 0; i < count; i++) {
+    if (sensors[i].state == ECHO_DONE) {
+      evaluate(sensors[i]);
+    }
+    occupied.set(configs[i].slot, sensors[i].occupied);
+  }
+}
+
+void UltrasonicSensorBus::markSensed(OccupancyBits& sensed) const {
+  for (int i = 0; i < count; i++) {
+    sensed.set(configs[i].slot, true);
+  }
+}
+
+int64_t UltrasonicSensorBus::edgeUs(int slot) const {
+  for (int i = 0; i < count; i++) {
+    if (configs[i].slot == slot) {
+      return sensors[i].changedUs;
+    }
+  }
+  return 0;
+}
+
+TimeMs UltrasonicSensorBus::worstCaseLatencyMs() const {
+  // Up to a round until the slot's group pings, a second round to confirm,
+  // plus one group window for the echo itself.
+  return (2 * groupCount + 1) * ULTRASONIC_GROUP_INTERVAL_MS;
+}
@@ -0,0 +1,79 @@
+#ifndef ULTRASONIC_SENSOR_BUS_H
+#define ULTRASONIC_SENSOR_BUS_H
+
+#include <Arduino.h>
+#include "slot_sensor_bus.h"
+#include "timer_wheel.h"
+
+// One HC-SR04-class ultrasonic sensor looking down at a slot.
+struct UltrasonicConfig {
+  int triggerPin;   // Sensors sharing a trigger pin are measured together
+  int echoPin;      // Through a 5 V -> 3.3 V divider
+  int slot;
+  uint16_t thresholdCm; // Closer than this means a car
+};
+
+// Ultrasonic slot sensors measured without blocking. A timer fires one
+// trigger group at a time; each echo pin has a CHANGE interrupt that
+// timestamps the rising and falling edge, so every sensor in the group is
+// timed at once and the loop never waits in pulseIn(). Groups take turns so
+// neighbouring sensors do not hear each other's pings.
+//
+// A slot changes state only after two readings in a row agree, with a
+// hysteresis band above the threshold, so a single stray echo cannot flip it.
+// Worst-case detection latency is (2 x groups + 1) x ULTRASONIC_GROUP_INTERVAL_MS
+// while readings are clean; each stray echo can add a round.
+class UltrasonicSensorBus : public SlotSensorBus {
+ public:
+  static const int MAX_SENSORS = 32;
+  static const int MAX_GROUPS = 8;
+
+  // The config array must outlive the bus.
+  UltrasonicSensorBus(const UltrasonicConfig* sensors, int count);
+
+  const char* name() const { return "ultrasonic"; }
+  void begin();
+  int sensorCount() const { return count; }
+  void sample(OccupancyBits& occupied);
+  void markSensed(OccupancyBits& sensed) const;
+  int64_t edgeUs(int slot) const;
+  bool hasPendingChange() const { return echoesDone != 0; }
+
+  uint32_t measurementCount() const { return measurements; }
+  uint32_t timeoutCount() const { return timeouts; }
+  TimeMs worstCaseLatencyMs() const;
+
+ private:
+  enum EchoState : uint8_t { ECHO_IDLE, ECHO_WAIT_RISE, ECHO_WAIT_FALL, ECHO_DONE };
+
+  struct Sensor {
+    UltrasonicSensorBus* bus;
+    int index;
+    volatile EchoState state;
+    volatile int64_t riseUs;
+    volatile int64_t fallUs;
+    bool occupied;
+    bool candidate;     // Last reading's verdict, waiting for confirmation
+    int64_t changedUs;  // Echo time of the reading that last flipped the slot
+  };
+
+  static void IRAM_ATTR onEcho(void* arg);
+  static void onGroupTimer(void* context);
+  void startNextGroup();
+  void evaluate(Sensor& sensor);
+
+  const UltrasonicConfig* configs;
+  int count;
+  Sensor sensors[MAX_SENSORS];
+  int triggerPins[MAX_GROUPS];
+  int groupCount;
+  int currentGroup;
+  Timer groupTimer;
+  portMUX_TYPE echoMux;
+  volatile uint32_t echoesDone; // Completed echoes not yet evaluated
+
+  uint32_t measurements;
+  uint32_t timeouts;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+door_open Command Load Test
+Fires correlated OPEN commands at the ESP32 through an MQTT broker and
+reports latency percentiles from the acks on parking/esp32/ack:
+
+  round trip   command published -> ack received (this machine's clock only)
+  actuation    command received on the ESP32 -> servo commanded (ESP32 clock only)
+  inbound      command published -> received on the ESP32 (needs both clocks NTP-synced)
+
+Run it against a local broker (e.g. mosquitto on the bench, with the
+controller built with -DMQTT_LOCAL_BROKER=\\"<broker-ip>\\") to keep the
+cloud broker out of the numbers, or against HiveMQ with --tls.
+
+Usage:
+  python3 command_load_test.py --count 2000 --rate 20
+  python3 command_load_test.py --broker <host> --port 8883 --tls --user U --password P
+"""
+
+import argparse
+import json
+import ssl
+import threading
+import time
+import uuid
+
+import paho.mqtt.client as mqtt
+
+COMMAND_TOPIC = "door_open"
+ACK_TOPIC = "parking/esp32/ack"
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def print_stats(name, values_us):
+    if not values_us:
+        print(f"  {name:12} (no samples)")
+        return
+    print(f"  {name:12} n={len(values_us):<6} "
+          f"p50={percentile(values_us, 0.50) / 1000:8.2f}ms "
+          f"p90={percentile(values_us, 0.90) / 1000:8.2f}ms "
+          f"p99={percentile(values_us, 0.99) / 1000:8.2f}ms "
+          f"p99.9={percentile(values_us, 0.999) / 1000:8.2f}ms "
+          f"max={max(values_us) / 1000:8.2f}ms")
+
+
+class LoadTest:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.sent = {}  # correlation id -> publish time (us)
+        self.round_trip = []
+        self.actuation = []
+        self.inbound = []
+        self.rejected = 0
+        self.connected = threading.Event()
+
+    def on_connect(self, client, userdata, flags, rc):
+        client.subscribe(ACK_TOPIC)
+        self.connected.set()
+
+    def on_message(self, client, userdata, msg):
+        now_us = time.time_ns() // 1000
+        try:
+            ack = json.loads(msg.payload)
+        except ValueError:
+            return
+        with self.lock:
+            sent_us = self.sent.pop(ack.get("id"), None)
+            if sent_us is None:
+                return  # Someone else's command
+            if ack.get("result") != "ok":
+                self.rejected += 1
+                return
+            self.round_trip.append(now_us - sent_us)
+            self.actuation.append(ack["actuatedUs"] - ack["receivedUs"])
+            if ack.get("synced"):
+                self.inbound.append(ack["receivedUs"] - sent_us)
+
+    def fire(self, client, count, rate, lane):
+        run_id = uuid.uuid4().hex[:6]
+        interval = 1.0 / rate
+        next_send = time.monotonic()
+        for i in range(count):
+            correlation_id = f"{run_id}-{i}"
+            command = json.dumps({"cmd": "OPEN", "id": correlation_id, "lane": lane})
+            with self.lock:
+                self.sent[correlation_id] = time.time_ns() // 1000
+            client.publish(COMMAND_TOPIC, command)
+            next_send += interval
+            delay = next_send - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="door_open command latency load test")
+    parser.add_argument("--broker", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--tls", action="store_true")
+    parser.add_argument("--user")
+    parser.add_argument("--password")
+    parser.add_argument("--count", type=int, default=1000, help="commands to send")
+    parser.add_argument("--rate", type=float, default=10, help="commands per second")
+    parser.add_argument("--lane", default="entry", help="gate lane to open (entry, exit)")
+    parser.add_argument("--drain", type=float, default=5, help="seconds to wait for late acks")
+    args = parser.parse_args()
+
+    test = LoadTest()
+    client = mqtt.Client(client_id=f"command-load-{int(time.time())}")
+    if args.user:
+        client.username_pw_set(args.user, args.password)
+    if args.tls:
+        client.tls_set(cert_reqs=ssl.CERT_NONE)
+        client.tls_insecure_set(True)
+    client.on_connect = test.on_connect
+    client.on_message = test.on_message
+    client.connect(args.broker, args.port, keepalive=60)
+    client.loop_start()
+    if not test.connected.wait(10):
+        raise SystemExit(f"Could not connect to {args.broker}:{args.port}")
+
+    print(f"Sending {args.count} OPEN commands for the {args.lane} gate "
+          f"at {args.rate}/s via {args.broker}:{args.port}")
+    started = time.monotonic()
+    test.fire(client, args.count, args.rate, args.lane)
+    time.sleep(args.drain)
+    elapsed = time.monotonic() - started
+    client.loop_stop()
+
+    print("\n" + "=" * 70)
+    print(f" {args.count} commands in {elapsed:.1f}s, "
+          f"{len(test.round_trip)} acked, {test.rejected} rejected, {len(test.sent)} lost")
+    print("=" * 70)
+    print_stats("round trip", test.round_trip)
+    print_stats("actuation", test.actuation)
+    print_stats("inbound", test.inbound)
+
+
+if __name__ == "__main__":
+    main()
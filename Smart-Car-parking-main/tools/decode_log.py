@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""
+Binary Log Decoder for the ESP32 Access Controller
+Turns the binary records written by access_control/logger.cpp back into text,
+using the message table in access_control/log_messages.h.
+
+Usage:
+  python3 decode_log.py /dev/ttyUSB0            # live, from the serial port
+  python3 decode_log.py capture.bin             # from a raw capture file
+  python3 decode_log.py --table other/log_messages.h capture.bin
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+FRAME_SYNC = 0xA5
+BAUD_RATE = 115200
+LEVEL_NAMES = {1: "ERROR", 2: "WARN", 3: "INFO", 4: "DEBUG"}
+
+DEFAULT_TABLE = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                             "..", "access_control", "log_messages.h")
+
+ENTRY_PATTERN = re.compile(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+CONVERSION_PATTERN = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z)?([diuxXcfs%])')
+
+
+def load_table(path):
+    """Return the list of (name, format) pairs in enum order"""
+    with open(path, encoding="utf-8") as f:
+        source = f.read()
+    # Skip the prose above the table, which quotes the entry shape too
+    source = source[source.find("#define LOG_MESSAGES(X)"):]
+    table = []
+    for name, fmt in ENTRY_PATTERN.findall(source):
+        table.append((name, bytes(fmt, "utf-8").decode("unicode_escape")))
+    if not table:
+        sys.exit(f"No log messages found in {path}")
+    return table
+
+
+def decode_args(fmt, data):
+    """Unpack the arguments of one record following the format string"""
+    args = []
+    offset = 0
+    for conversion in CONVERSION_PATTERN.findall(fmt):
+        if conversion == "%":
+            continue
+        if conversion == "s":
+            if offset >= len(data):
+                return args, True
+            size = data[offset]
+            args.append(data[offset + 1:offset + 1 + size].decode("utf-8", "replace"))
+            offset += 1 + size
+            continue
+        if offset + 4 > len(data):
+            return args, True
+        word = data[offset:offset + 4]
+        offset += 4
+        if conversion in "di":
+            args.append(struct.unpack("<i", word)[0])
+        elif conversion == "f":
+            args.append(struct.unpack("<f", word)[0])
+        elif conversion == "c":
+            args.append(chr(struct.unpack("<I", word)[0] & 0xFF))
+        else:
+            args.append(struct.unpack("<I", word)[0])
+    return args, False
+
+
+def format_record(table, payload):
+    """Render one checked record payload as a log line"""
+    level, msg_id, timestamp = struct.unpack("<BHI", payload[:7])
+    level_name = LEVEL_NAMES.get(level, str(level))
+    if msg_id >= len(table):
+        return f"[{timestamp / 1e6:12.6f}] {level_name:5} <unknown message {msg_id}>"
+    name, fmt = table[msg_id]
+    args, truncated = decode_args(fmt, payload[7:])
+    # Pad missing arguments so a truncated record still renders
+    conversions = [c for c in CONVERSION_PATTERN.findall(fmt) if c != "%"]
+    printable = fmt
+    if truncated:
+        printable = CONVERSION_PATTERN.sub(
+            lambda m: m.group(0) if m.group(1) == "%" else "%s", fmt)
+        args = [str(a) for a in args] + ["?"] * (len(conversions) - len(args))
+    try:
+        text = printable % tuple(args)
+    except (TypeError, ValueError):
+        text = f"{fmt} {args}"
+    suffix = " <truncated>" if truncated else ""
+    return f"[{timestamp / 1e6:12.6f}] {level_name:5} {text}{suffix}"
+
+
+def decode_stream(table, read, out, follow=False):
+    """Resynchronise on the sync byte and decode records until EOF"""
+    buffer = bytearray()
+    bad_frames = 0
+    while True:
+        chunk = read()
+        if not chunk:
+            if follow:
+                continue
+            break
+        buffer.extend(chunk)
+        while True:
+            start = buffer.find(bytes([FRAME_SYNC]))
+            if start < 0:
+                buffer.clear()
+                break
+            del buffer[:start]
+            if len(buffer) < 2:
+                break
+            length = buffer[1]
+            if len(buffer) < length + 3:
+                break
+            payload = bytes(buffer[2:2 + length])
+            checksum = 0
+            for b in payload:
+                checksum ^= b
+            if length < 7 or checksum != buffer[2 + length]:
+                # Not a real frame start; skip this byte and look again
+                bad_frames += 1
+                del buffer[:1]
+                continue
+            del buffer[:length + 3]
+            print(format_record(table, payload), file=out, flush=True)
+    if bad_frames:
+        print(f"({bad_frames} corrupt frames skipped)", file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode ESP32 binary logs")
+    parser.add_argument("source", help="serial port (e.g. /dev/ttyUSB0) or capture file")
+    parser.add_argument("--table", default=DEFAULT_TABLE, help="path to log_messages.h")
+    parser.add_argument("--baud", type=int, default=BAUD_RATE)
+    args = parser.parse_args()
+
+    table = load_table(args.table)
+
+    if args.source.startswith("/dev/") or args.source.upper().startswith("COM"):
+        try:
+            import serial
+        except ImportError:
+            sys.exit("pyserial not installed. Install: pip3 install pyserial")
+        port = serial.Serial(args.source, args.baud, timeout=1)
+        print(f"Decoding {args.source} at {args.baud} baud (Ctrl+C to stop)")
+        try:
+            decode_stream(table, lambda: port.read(256), sys.stdout, follow=True)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            port.close()
+    else:
+        with open(args.source, "rb") as f:
+            decode_stream(table, lambda: f.read(4096), sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
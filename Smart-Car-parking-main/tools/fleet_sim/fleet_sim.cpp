@@ -0,0 +1,1106 @@
+// Fleet Simulator
+// Runs thousands of access controllers against an MQTT broker to size it and
+// whatever consumes the fleet's topics (e.g. slot_aggregator). Each node is
+// the firmware's own controllers, built for the host from access_control/:
+// a GateController with two lanes, a SlotMonitor on the adaptive sampling
+// schedule and a StatusPublisher, all on the worker thread's timer wheel.
+// Around them the node stands in for the ESP32:
+//
+//   - its MQTT client connects as "ESP32-Parking-Client-<random 16 bits>"
+//     and, when that fails or drops, retries on the 5 s cooldown of
+//     reconnectMqtt(). The random client IDs collide in a large fleet, and
+//     the broker then drops the older session; that churn is real and shows
+//     in the report.
+//   - it subscribes to door_open and its validate reply topic. door_open is
+//     parsed as mqttCallback() does (that code needs ArduinoJson, so it is
+//     mirrored here), opens the lane and is acked in the firmware's format.
+//     Like the firmware, every node receives every command.
+//   - its slot sensors are a SlotSensorBus set by a traffic model: cars
+//     arrive at --arrivals per lot per hour and stay --stay minutes on
+//     average, and each arrival and departure also opens the entry or exit
+//     lane. Lanes have no passage sensor, so barriers close on their timer.
+//
+// Status goes out on the firmware's JSON topic, as a default build sends it;
+// --formats takes a comma-separated set of json, cbor and packed, e.g. all
+// three as -DSLOT_STATUS_BINARY builds send. --deltas runs the status
+// publisher as -DSLOT_STATUS_DELTAS builds do.
+//
+// One more connection, the observer, plays the dashboard: it sends
+// --commands door_open commands a second and subscribes to the trace and ack
+// topics, which gives status and command latencies measured at the far side
+// of the broker on the same clock.
+//
+// Build (Linux):
+//   g++ -std=c++17 -O2 -Wall -Wextra -pthread -I../../access_control -o fleet_sim fleet_sim.cpp ../../access_control/gate_lane.cpp ../../access_control/gate_policy.cpp ../../access_control/slot_monitor.cpp ../../access_control/sampling_rate.cpp ../../access_control/status_publisher.cpp ../../access_control/status_document.cpp ../../access_control/timer_wheel.cpp
+// Usage:
+//   ./fleet_sim [--broker 127.0.0.1:1883] [--nodes 1000] [--threads 4] [--duration 60]
+//               [--slots 20] [--arrivals 30] [--stay 90] [--commands 1] [--drops 0]
+//               [--outage 3] [--ramp 10] [--keepalive 15] [--formats json] [--deltas]
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "controller_clock.h"
+#include "gate_controller.h"
+#include "message_link.h"
+#include "slot_monitor.h"
+#include "status_publisher.h"
+#include "timer_wheel.h"
+
+namespace {
+
+// --- Firmware Settings ---
+// Mirrors of the constants in access_control; keep them in step.
+const char* TOPIC_DOOR_OPEN = "door_open";                       // network_handler.cpp
+const StatusTopic STATUS_TOPICS[] = {                            // network_handler.cpp
+  { "parking/esp32/status", STATUS_FORMAT_JSON },
+  { "parking/esp32/status/cbor", STATUS_FORMAT_CBOR },           // With -DSLOT_STATUS_BINARY
+  { "parking/esp32/status/packed", STATUS_FORMAT_PACKED },       // With -DSLOT_STATUS_BINARY
+};
+const char* TOPIC_TRACE = "parking/esp32/trace";
+const char* TOPIC_ACK = "parking/esp32/ack";                     // network_handler.cpp
+const char* VALIDATE_REPLY_FORMAT = "parking/esp32/%s/validate/reply";
+const TimeMs MQTT_RECONNECT_INTERVAL = 5000;
+const SamplingLimits SAMPLING_LIMITS = { 10, 200, 30000 };       // slot_handler.cpp
+const int LANE_COUNT = 2;
+const size_t DEVICE_ID_LENGTH = 12;                              // MAC in hex
+const LaneConfig LANES[LANE_COUNT] = {                           // gate_handler.cpp with -DGATE_EXIT_LANE
+  { "entry", -1, -1, 0, 90, { 90, 180 }, { 1500, 800, 5000, 30000, 3000, 1500, 15000 } },
+  { "exit", -1, -1, 0, 90, { 90, 180 }, { 1500, 800, 5000, 30000, 3000, 1500, 15000 } },
+};
+
+const uint8_t MQTT_CONNECT = 0x10;
+const uint8_t MQTT_CONNACK = 0x20;
+const uint8_t MQTT_PUBLISH = 0x30;
+const uint8_t MQTT_SUBSCRIBE = 0x82;
+const uint8_t MQTT_PINGREQ = 0xC0;
+
+struct Options {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1883;
+  int nodes = 1000;
+  int threads = 0;  // 0: one per core
+  int duration = 60;
+  int slots = 20;
+  double arrivals = 30;  // Per lot per hour
+  double stay = 90;      // Minutes
+  double commands = 1;   // door_open per second, fleet-wide
+  double drops = 0;      // WiFi drops per node per hour
+  double outage = 3;     // Seconds a dropped link stays down
+  double ramp = 10;      // Seconds over which nodes first connect
+  uint16_t keepAlive = 15;
+  std::vector<StatusTopic> statusTopics{STATUS_TOPICS[0]};  // JSON only, as a default build
+  bool deltas = false;
+};
+
+Options options;
+std::atomic<bool> stopping(false);
+sockaddr_storage brokerAddress;
+socklen_t brokerAddressLength;
+
+int64_t wallUs() {
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return int64_t(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+int64_t steadyNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t steadyUs() {
+  return steadyNs() / 1000;
+}
+
+int64_t steadyMs() {
+  return steadyNs() / 1000000;
+}
+
+// --- MQTT Framing ---
+
+void appendHeader(std::string& out, uint8_t type, size_t remaining) {
+  out.push_back(static_cast<char>(type));
+  do {
+    uint8_t digit = remaining % 128;
+    remaining /= 128;
+    out.push_back(static_cast<char>(remaining > 0 ? digit | 0x80 : digit));
+  } while (remaining > 0);
+}
+
+void appendString(std::string& out, std::string_view text) {
+  out.push_back(static_cast<char>(text.size() >> 8));
+  out.push_back(static_cast<char>(text.size() & 0xFF));
+  out.append(text);
+}
+
+void appendPublish(std::string& out, std::string_view topic, std::string_view payload) {
+  appendHeader(out, MQTT_PUBLISH, 2 + topic.size() + payload.size());
+  appendString(out, topic);
+  out.append(payload);
+}
+
+void appendConnect(std::string& out, std::string_view clientId, uint16_t keepAlive) {
+  appendHeader(out, MQTT_CONNECT, 10 + 2 + clientId.size());
+  appendString(out, "MQTT");
+  out.push_back(4);     // 3.1.1
+  out.push_back(0x02);  // Clean session, as PubSubClient
+  out.push_back(static_cast<char>(keepAlive >> 8));
+  out.push_back(static_cast<char>(keepAlive & 0xFF));
+  appendString(out, clientId);
+}
+
+void appendSubscribe(std::string& out, uint16_t packetId, std::string_view topic) {
+  appendHeader(out, MQTT_SUBSCRIBE, 2 + 2 + topic.size() + 1);
+  out.push_back(static_cast<char>(packetId >> 8));
+  out.push_back(static_cast<char>(packetId & 0xFF));
+  appendString(out, topic);
+  out.push_back(0);
+}
+
+// Calls onPacket(type, body) for each complete packet and trims the buffer.
+// Returns false on a malformed header.
+template <typename Handler>
+bool takePackets(std::string& in, Handler onPacket) {
+  size_t start = 0;
+  for (;;) {
+    size_t remaining = 0;
+    size_t headerLength = 1;
+    int shift = 0;
+    bool complete = false;
+    while (start + headerLength < in.size()) {
+      if (headerLength > 4) {
+        return false;
+      }
+      uint8_t digit = static_cast<uint8_t>(in[start + headerLength++]);
+      remaining |= static_cast<size_t>(digit & 0x7F) << shift;
+      shift += 7;
+      if ((digit & 0x80) == 0) {
+        complete = true;
+        break;
+      }
+    }
+    if (!complete || in.size() < start + headerLength + remaining) {
+      break;
+    }
+    if (!onPacket(static_cast<uint8_t>(in[start]), std::string_view(in.data() + start + headerLength, remaining))) {
+      return false;
+    }
+    start += headerLength + remaining;
+  }
+  in.erase(0, start);
+  return true;
+}
+
+// Topic and payload of a QoS 0 PUBLISH body.
+bool splitPublish(std::string_view body, std::string_view& topic, std::string_view& payload) {
+  if (body.size() < 2) {
+    return false;
+  }
+  size_t topicLength = (static_cast<uint8_t>(body[0]) << 8) | static_cast<uint8_t>(body[1]);
+  if (2 + topicLength > body.size()) {
+    return false;
+  }
+  topic = body.substr(2, topicLength);
+  payload = body.substr(2 + topicLength);
+  return true;
+}
+
+// A string field of a flat JSON object, or an empty view.
+std::string_view jsonString(std::string_view json, std::string_view key) {
+  std::string quoted = "\"" + std::string(key) + "\":\"";
+  size_t at = json.find(quoted);
+  if (at == std::string_view::npos) {
+    return std::string_view();
+  }
+  std::string_view value = json.substr(at + quoted.size());
+  return value.substr(0, value.find('"'));
+}
+
+int64_t jsonNumber(std::string_view json, std::string_view key) {
+  std::string quoted = "\"" + std::string(key) + "\":";
+  size_t at = json.find(quoted);
+  return at == std::string_view::npos ? -1 : strtoll(json.data() + at + quoted.size(), nullptr, 10);
+}
+
+// --- Statistics ---
+
+// Written by one thread, read by the reporter.
+struct Counters {
+  std::atomic<uint64_t> publishes{0};
+  std::atomic<uint64_t> bytesOut{0};
+  std::atomic<uint64_t> received{0};
+  std::atomic<uint64_t> statusDocs{0};
+  std::atomic<uint64_t> connects{0};
+  std::atomic<uint64_t> failedConnects{0};
+  std::atomic<uint64_t> brokerDrops{0};  // Session ended by the broker, e.g. a client ID clash
+  std::atomic<uint64_t> linkDrops{0};    // Simulated WiFi loss
+  std::atomic<uint64_t> acks{0};
+  std::atomic<uint64_t> arrivals{0};
+  std::atomic<uint64_t> departures{0};
+  std::atomic<uint64_t> turnedAway{0};   // Lot full
+  std::atomic<int> online{0};
+
+  void bump(std::atomic<uint64_t>& counter, uint64_t by = 1) { counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed); }
+};
+
+struct Totals {
+  uint64_t publishes = 0, bytesOut = 0, received = 0, statusDocs = 0, connects = 0, failedConnects = 0;
+  uint64_t brokerDrops = 0, linkDrops = 0, acks = 0, arrivals = 0, departures = 0, turnedAway = 0;
+  int online = 0;
+
+  void add(const Counters& c) {
+    publishes += c.publishes.load(std::memory_order_relaxed);
+    bytesOut += c.bytesOut.load(std::memory_order_relaxed);
+    received += c.received.load(std::memory_order_relaxed);
+    statusDocs += c.statusDocs.load(std::memory_order_relaxed);
+    connects += c.connects.load(std::memory_order_relaxed);
+    failedConnects += c.failedConnects.load(std::memory_order_relaxed);
+    brokerDrops += c.brokerDrops.load(std::memory_order_relaxed);
+    linkDrops += c.linkDrops.load(std::memory_order_relaxed);
+    acks += c.acks.load(std::memory_order_relaxed);
+    arrivals += c.arrivals.load(std::memory_order_relaxed);
+    departures += c.departures.load(std::memory_order_relaxed);
+    turnedAway += c.turnedAway.load(std::memory_order_relaxed);
+    online += c.online.load(std::memory_order_relaxed);
+  }
+};
+
+struct Latencies {
+  std::vector<int64_t> samples;
+
+  void add(int64_t us) { samples.push_back(us < 0 ? 0 : us); }
+
+  std::string report(const char* name) {
+    char line[160];
+    if (samples.empty()) {
+      snprintf(line, sizeof(line), "  %-22s (no samples)", name);
+      return line;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double p) { return samples[std::min(samples.size() - 1, size_t(p * samples.size()))] / 1000.0; };
+    snprintf(line, sizeof(line), "  %-22s n=%-8zu p50 %8.2f ms  p99 %8.2f ms  max %8.2f ms", name, samples.size(),
+             at(0.50), at(0.99), samples.back() / 1000.0);
+    return line;
+  }
+};
+
+// --- Simulated Controller ---
+
+// The clocks of every controller on a worker: steady time is the monotonic
+// clock, wall time the (always synced) trace time, and nanoseconds stand in
+// for CPU cycles.
+class SimClock : public ControllerClock {
+ public:
+  int64_t monotonicUs() { return steadyUs(); }
+  int64_t traceNowUs() { return wallUs(); }
+  int64_t traceFromMonotonicUs(int64_t monotonicUs) { return monotonicUs + (wallUs() - steadyUs()); }
+  bool isTraceSynced() { return true; }
+  uint32_t cycleCount() { return static_cast<uint32_t>(steadyNs()); }
+  uint32_t cyclesPerUs() { return 1000; }
+};
+
+// A lane with neither servo nor passage sensor.
+class SimLane : public LaneHardware {
+ public:
+  void begin(const LaneConfig&, TimerWheel&) {}
+  void moveBarrier(float) {}
+  bool beamBlocked() { return false; }
+};
+
+// Storage for a status template sized from --slots at run time; the
+// firmware's is a FixedStatusTemplate sized at compile time.
+struct TemplateStorage {
+  explicit TemplateStorage(int slots) : characters(statusTemplateSize(slots, DEVICE_ID_LENGTH)), offsets(slots) {}
+
+  std::vector<char> characters;
+  std::vector<uint16_t> offsets;
+};
+
+class SimStatusTemplate : private TemplateStorage, public StatusTemplate {
+ public:
+  explicit SimStatusTemplate(int slots)
+      : TemplateStorage(slots), StatusTemplate(characters.data(), characters.size(), offsets.data(), slots) {}
+};
+
+// The lot's slot sensors, set by the traffic model.
+class SimSensorBus : public SlotSensorBus {
+ public:
+  explicit SimSensorBus(int slots) : edges(slots, 0) {}
+
+  const char* name() const { return "sim"; }
+  void begin() {}
+  int sensorCount() const { return static_cast<int>(edges.size()); }
+
+  void sample(OccupancyBits& occupied) {
+    for (size_t slot = 0; slot < edges.size(); slot++) {
+      occupied.set(slot, sensed.test(slot));
+    }
+  }
+
+  void markSensed(OccupancyBits& sensed) const {
+    for (int slot = 0; slot < sensorCount(); slot++) {
+      sensed.set(slot, true);
+    }
+  }
+
+  int64_t edgeUs(int slot) const { return slot < sensorCount() ? edges[slot] : 0; }
+
+  bool test(int slot) const { return sensed.test(slot); }
+  void set(int slot, bool occupied) {
+    sensed.set(slot, occupied);
+    edges[slot] = steadyUs();
+  }
+
+ private:
+  OccupancyBits sensed;
+  std::vector<int64_t> edges;
+};
+
+class Worker;
+
+// One access controller. The node is its controllers' MQTT session and the
+// sink for their slot changes.
+struct Node : MessageLink, SlotEvents {
+  enum State { OFFLINE, LINK_DOWN, CONNECTING, HANDSHAKE, ONLINE };
+
+  Node(Worker& worker, int index);
+  Node(const Node&) = delete;
+  Node& operator=(const Node&) = delete;
+
+  // MessageLink, over the node's socket.
+  bool connected() { return state == ONLINE; }
+  bool publish(const char* topic, const char* payload);
+  bool beginPublish(const char* topic, size_t length);
+  void write(const uint8_t* data, size_t length) { out.append(reinterpret_cast<const char*>(data), length); }
+  bool endPublish();
+
+  // SlotEvents, as slot_handler.cpp wires them.
+  void slotsChanged(const OccupancyBits& occupied, int slotCount, const SlotTrace& trace) {
+    status.publish(occupied, slotCount, trace);
+  }
+  bool lotBusy() { return gates.anyOpen(); }
+
+  Worker& worker;
+  char device[13];
+  char replyTopic[64];
+  State state = OFFLINE;
+  int fd = -1;
+  bool waitingForOut = false;
+  bool flushQueued = false;
+  std::string in;
+  std::string out;
+  TimeMs lastAttempt = 0;
+  bool attempted = false;
+  int parked = 0;
+
+  // The firmware's controllers and what they drive.
+  SimSensorBus sensors;
+  SlotSensorBus* const buses[1];
+  SlotMonitor slots;
+  SimLane laneHardware[LANE_COUNT];
+  LaneHardware* const lanes[LANE_COUNT];
+  GateController<LANE_COUNT> gates;
+  SimStatusTemplate statusTemplate;
+  StatusPublisher status;
+
+  Timer trafficTimer;
+  Timer connectTimer;
+  Timer pingTimer;
+  Timer dropTimer;
+};
+
+class Worker {
+ public:
+  Worker(int firstNode, int count, uint32_t seed);
+  void run();
+
+  TimerWheel wheel;
+  SimClock clock;
+  std::mt19937 random;
+  int epollFd;
+  Counters counters;
+  std::vector<std::unique_ptr<Node>> nodes;
+  std::vector<Node*> toFlush;
+
+  double uniform() { return std::uniform_real_distribution<double>(0.0, 1.0)(random); }
+  TimeMs exponentialMs(double perMs) { return perMs <= 0 ? 0 : TimeMs(std::min(-std::log(1.0 - uniform()) / perMs, 3.6e6)) + 1; }
+
+ private:
+  void flushQueued();
+
+  int64_t epochMs;
+};
+
+void startConnect(Node& node);
+void closeLink(Node& node, bool linkDown);
+
+void watch(Node& node, bool wantOut) {
+  epoll_event event{};
+  event.events = EPOLLIN | (wantOut ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+  event.data.ptr = &node;
+  epoll_ctl(node.worker.epollFd, EPOLL_CTL_MOD, node.fd, &event);
+  node.waitingForOut = wantOut;
+}
+
+// Sends what the socket takes now; the rest waits for EPOLLOUT.
+void flush(Node& node) {
+  while (!node.out.empty()) {
+    ssize_t sent = send(node.fd, node.out.data(), node.out.size(), MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      node.worker.counters.bump(node.worker.counters.brokerDrops);
+      closeLink(node, false);
+      return;
+    }
+    node.worker.counters.bump(node.worker.counters.bytesOut, sent);
+    node.out.erase(0, sent);
+  }
+  if (node.out.empty() == node.waitingForOut) {
+    watch(node, !node.out.empty());
+  }
+}
+
+// Output goes out once the current batch of events and timers is handled, so
+// a status change costs one send() for all its publishes.
+void queueFlush(Node& node) {
+  if (!node.flushQueued) {
+    node.flushQueued = true;
+    node.worker.toFlush.push_back(&node);
+  }
+}
+
+bool Node::publish(const char* topic, const char* payload) {
+  if (fd < 0) {
+    return false;
+  }
+  appendPublish(out, topic, payload);
+  worker.counters.bump(worker.counters.publishes);
+  queueFlush(*this);
+  return true;
+}
+
+bool Node::beginPublish(const char* topic, size_t length) {
+  if (fd < 0) {
+    return false;
+  }
+  appendHeader(out, MQTT_PUBLISH, 2 + strlen(topic) + length);
+  appendString(out, topic);
+  worker.counters.bump(worker.counters.publishes);
+  if (strcmp(topic, options.statusTopics[0].topic) == 0) {  // One per change, whatever the formats
+    worker.counters.bump(worker.counters.statusDocs);
+  }
+  return true;
+}
+
+bool Node::endPublish() {
+  queueFlush(*this);
+  return fd >= 0;
+}
+
+// networkLoop(): retry at once unless an attempt was made in the last 5 s.
+void scheduleReconnect(Node& node, TimeMs notBefore) {
+  TimeMs now = node.worker.wheel.now();
+  TimeMs at = node.attempted ? node.lastAttempt + MQTT_RECONNECT_INTERVAL : now;
+  if (!timeReached(at, notBefore)) {
+    at = notBefore;
+  }
+  node.worker.wheel.arm(node.connectTimer, timeReached(now, at) ? 0 : at - now);
+}
+
+void closeLink(Node& node, bool linkDown) {
+  if (node.fd >= 0) {
+    close(node.fd);  // Also leaves the epoll set
+    node.fd = -1;
+  }
+  if (node.state == Node::ONLINE) {
+    node.worker.counters.online.fetch_sub(1, std::memory_order_relaxed);
+  }
+  node.state = linkDown ? Node::LINK_DOWN : Node::OFFLINE;
+  node.in.clear();
+  node.out.clear();
+  node.waitingForOut = false;
+  node.worker.wheel.cancel(node.pingTimer);
+  TimeMs now = node.worker.wheel.now();
+  scheduleReconnect(node, linkDown ? now + TimeMs(options.outage * 1000) : now);
+}
+
+// reconnectMqtt()
+void startConnect(Node& node) {
+  node.lastAttempt = node.worker.wheel.now();
+  node.attempted = true;
+  node.fd = socket(brokerAddress.ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int one = 1;
+  setsockopt(node.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  if (connect(node.fd, reinterpret_cast<sockaddr*>(&brokerAddress), brokerAddressLength) != 0 &&
+      errno != EINPROGRESS) {
+    node.worker.counters.bump(node.worker.counters.failedConnects);
+    close(node.fd);
+    node.fd = -1;
+    scheduleReconnect(node, node.worker.wheel.now());
+    return;
+  }
+  node.state = Node::CONNECTING;
+  epoll_event event{};
+  event.events = EPOLLOUT;
+  event.data.ptr = &node;
+  epoll_ctl(node.worker.epollFd, EPOLL_CTL_ADD, node.fd, &event);
+  node.waitingForOut = true;
+}
+
+void onConnected(Node& node) {
+  node.state = Node::HANDSHAKE;
+  char clientId[32];
+  snprintf(clientId, sizeof(clientId), "ESP32-Parking-Client-%lx",
+           (unsigned long)(node.worker.random() % 0xffff));  // random(0xffff)
+  appendConnect(node.out, clientId, options.keepAlive);
+  queueFlush(node);
+}
+
+void onConnack(Node& node) {
+  node.state = Node::ONLINE;
+  node.worker.counters.online.fetch_add(1, std::memory_order_relaxed);
+  node.worker.counters.bump(node.worker.counters.connects);
+  appendSubscribe(node.out, 1, TOPIC_DOOR_OPEN);
+  appendSubscribe(node.out, 2, node.replyTopic);
+  node.worker.wheel.arm(node.pingTimer, options.keepAlive * 1000);
+  node.status.connected();
+  queueFlush(node);
+}
+
+// --- Commands ---
+
+// mqttCallback() for door_open: bare OPEN, or {"cmd":"OPEN","id":"c-1","lane":"exit"}.
+void onDoorOpen(Node& node, std::string_view message) {
+  int64_t receivedUs = wallUs();
+  std::string_view command = message;
+  std::string_view id;
+  int lane = 0;
+  if (!message.empty() && message[0] == '{') {
+    command = jsonString(message, "cmd");
+    id = jsonString(message, "id");
+    std::string_view laneName = jsonString(message, "lane");
+    if (!laneName.empty()) {
+      lane = node.gates.findLane(std::string(laneName).c_str());
+    }
+  }
+  bool accepted = command.size() == 4 && strncasecmp(command.data(), "OPEN", 4) == 0 && lane >= 0;
+  int64_t actuatedUs = 0;
+  if (accepted) {
+    node.gates.open(lane);
+    actuatedUs = wallUs();
+  }
+  std::string ack = "{\"id\":";
+  ack += id.empty() ? "null" : "\"" + std::string(id) + "\"";
+  char rest[192];
+  snprintf(rest, sizeof(rest), ",\"cmd\":\"%.*s\",\"result\":\"%s\",\"synced\":true,\"receivedUs\":%lld",
+           int(std::min<size_t>(command.size(), 32)), command.data(), accepted ? "ok" : "rejected",
+           (long long)receivedUs);
+  ack += rest;
+  if (accepted) {
+    snprintf(rest, sizeof(rest), ",\"actuatedUs\":%lld", (long long)actuatedUs);
+    ack += rest;
+  }
+  if (lane >= 0) {
+    snprintf(rest, sizeof(rest), ",\"lane\":\"%s\",\"gate\":\"%s\"", node.gates.lane(lane).name(),
+             node.gates.isOpen(lane) ? "open" : "closed");
+    ack += rest;
+  }
+  ack += "}";
+  node.publish(TOPIC_ACK, ack.c_str());
+  node.worker.counters.bump(node.worker.counters.acks);
+}
+
+// --- Traffic ---
+
+// Arrivals are Poisson at --arrivals per hour; each parked car leaves at a
+// rate of 1/--stay, so departures speed up as the lot fills. The slot
+// monitor notices on its next sample.
+void onTraffic(void* context) {
+  Node& node = *static_cast<Node*>(context);
+  Worker& worker = node.worker;
+  double arrivalRate = options.arrivals / 3.6e6;
+  double departureRate = node.parked / (options.stay * 60000.0);
+  if (worker.uniform() * (arrivalRate + departureRate) < arrivalRate) {
+    worker.counters.bump(worker.counters.arrivals);
+    node.gates.open(0);  // RFID grant at the entry
+    if (node.parked == options.slots) {
+      worker.counters.bump(worker.counters.turnedAway);
+    } else {
+      int slot;
+      do {
+        slot = worker.random() % options.slots;
+      } while (node.sensors.test(slot));
+      node.sensors.set(slot, true);
+      node.parked++;
+    }
+  } else if (node.parked > 0) {
+    worker.counters.bump(worker.counters.departures);
+    int slot;
+    do {
+      slot = worker.random() % options.slots;
+    } while (!node.sensors.test(slot));
+    node.sensors.set(slot, false);
+    node.parked--;
+    node.gates.open(1);
+  }
+  departureRate = node.parked / (options.stay * 60000.0);
+  worker.wheel.arm(node.trafficTimer, worker.exponentialMs(arrivalRate + departureRate));
+}
+
+void onConnectTimer(void* context) {
+  Node& node = *static_cast<Node*>(context);
+  if (node.state == Node::OFFLINE || node.state == Node::LINK_DOWN) {
+    startConnect(node);
+  }
+}
+
+void onPing(void* context) {
+  Node& node = *static_cast<Node*>(context);
+  if (node.state == Node::ONLINE) {
+    appendHeader(node.out, MQTT_PINGREQ, 0);
+    node.worker.wheel.arm(node.pingTimer, options.keepAlive * 1000);
+    queueFlush(node);
+  }
+}
+
+void onDrop(void* context) {
+  Node& node = *static_cast<Node*>(context);
+  if (node.state != Node::OFFLINE && node.state != Node::LINK_DOWN) {
+    node.worker.counters.bump(node.worker.counters.linkDrops);
+    closeLink(node, true);
+  }
+  node.worker.wheel.arm(node.dropTimer, node.worker.exponentialMs(options.drops / 3.6e6));
+}
+
+Node::Node(Worker& owner, int index)
+    : worker(owner),
+      sensors(options.slots),
+      buses{ &sensors },
+      slots(buses, 1, options.slots, SAMPLING_LIMITS),
+      lanes{ &laneHardware[0], &laneHardware[1] },
+      statusTemplate(options.slots),
+      trafficTimer(onTraffic, this),
+      connectTimer(onConnectTimer, this),
+      pingTimer(onPing, this),
+      dropTimer(onDrop, this) {
+  snprintf(device, sizeof(device), "f1ee7%07x", index & 0xFFFFFFF);
+  snprintf(replyTopic, sizeof(replyTopic), VALIDATE_REPLY_FORMAT, device);
+  for (int slot = 0; slot < options.slots; slot++) {
+    bool occupied = owner.uniform() < 0.5;
+    sensors.set(slot, occupied);
+    parked += occupied;
+  }
+  // setupNetwork(), setupGate(), setupSlots()
+  StatusConfig config = { options.statusTopics.data(), int(options.statusTopics.size()), options.deltas,
+                          &statusTemplate };
+  status.begin(device, config, slots.sensed(), *this, owner.wheel, owner.clock);
+  gates.begin(LANES, lanes, owner.wheel);
+  slots.begin(owner.wheel, owner.clock, *this, owner.random());
+}
+
+// --- Event Loop ---
+
+Worker::Worker(int firstNode, int count, uint32_t seed) : random(seed), epollFd(epoll_create1(0)) {
+  epochMs = steadyMs();
+  wheel.begin(0);
+  for (int i = 0; i < count; i++) {
+    nodes.emplace_back(new Node(*this, firstNode + i));
+    Node& node = *nodes.back();
+    wheel.arm(node.connectTimer, TimeMs(uniform() * options.ramp * 1000));
+    double rate = options.arrivals / 3.6e6 + node.parked / (options.stay * 60000.0);
+    wheel.arm(node.trafficTimer, exponentialMs(rate));
+    if (options.drops > 0) {
+      wheel.arm(node.dropTimer, exponentialMs(options.drops / 3.6e6));
+    }
+  }
+}
+
+void handlePackets(Node& node) {
+  bool ok = takePackets(node.in, [&](uint8_t flags, std::string_view body) {
+    uint8_t type = flags & 0xF0;
+    if (type == MQTT_CONNACK) {
+      if (body.size() < 2 || body[1] != 0) {
+        return false;
+      }
+      onConnack(node);
+    } else if (type == MQTT_PUBLISH) {
+      node.worker.counters.bump(node.worker.counters.received);
+      std::string_view topic;
+      std::string_view payload;
+      if (splitPublish(body, topic, payload) && topic == TOPIC_DOOR_OPEN) {
+        onDoorOpen(node, payload);
+      }
+    }
+    return true;
+  });
+  if (!ok) {
+    node.worker.counters.bump(node.worker.counters.failedConnects);
+    closeLink(node, false);
+  }
+}
+
+void Worker::flushQueued() {
+  for (Node* node : toFlush) {
+    node->flushQueued = false;
+    if (node->fd >= 0 && node->state != Node::CONNECTING) {
+      flush(*node);
+    }
+  }
+  toFlush.clear();
+}
+
+void Worker::run() {
+  epoll_event events[512];
+  std::vector<char> buffer(64 * 1024);
+  while (!stopping.load(std::memory_order_relaxed)) {
+    wheel.advance(TimeMs(steadyMs() - epochMs));
+    flushQueued();
+    TimeMs wait = wheel.timeUntilNext(100);
+    int ready = epoll_wait(epollFd, events, 512, int(wait));
+    wheel.advance(TimeMs(steadyMs() - epochMs));
+    for (int e = 0; e < ready; e++) {
+      Node& node = *static_cast<Node*>(events[e].data.ptr);
+      if (node.fd < 0) {
+        continue;
+      }
+      if (node.state == Node::CONNECTING) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(node.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0 || (events[e].events & (EPOLLERR | EPOLLHUP))) {
+          counters.bump(counters.failedConnects);
+          closeLink(node, false);
+          continue;
+        }
+        watch(node, false);
+        onConnected(node);
+        continue;
+      }
+      if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        ssize_t received;
+        while ((received = recv(node.fd, buffer.data(), buffer.size(), 0)) > 0) {
+          node.in.append(buffer.data(), received);
+        }
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+          counters.bump(node.state == Node::ONLINE ? counters.brokerDrops : counters.failedConnects);
+          closeLink(node, false);
+          continue;
+        }
+        handlePackets(node);
+      } else if (events[e].events & EPOLLOUT) {
+        flush(node);
+      }
+    }
+    flushQueued();
+  }
+}
+
+// --- Observer ---
+
+// One connection on the far side of the broker: sends door_open commands and
+// times what comes back.
+class Observer {
+ public:
+  void run();
+
+  Latencies statusTransit;  // Node sent the status -> trace delivered here
+  Latencies edgeToHere;     // Sensor edge -> trace delivered here
+  Latencies commandAck;     // door_open sent -> each ack delivered here
+  uint64_t commandsSent = 0;
+  uint64_t acksReceived = 0;
+  uint64_t tracesReceived = 0;
+
+ private:
+  bool send(int fd, std::string& out);
+  std::unordered_map<std::string, int64_t> sentAt;  // Command ID -> wall time
+};
+
+bool Observer::send(int fd, std::string& out) {
+  while (!out.empty()) {
+    ssize_t sent = ::send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+    if (sent < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    out.erase(0, sent);
+  }
+  return true;
+}
+
+void Observer::run() {
+  int fd = socket(brokerAddress.ss_family, SOCK_STREAM, 0);
+  if (connect(fd, reinterpret_cast<sockaddr*>(&brokerAddress), brokerAddressLength) != 0) {
+    perror("observer connect");
+    return;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  std::string out;
+  std::string in;
+  appendConnect(out, "fleet-sim-observer", 60);
+  appendSubscribe(out, 1, TOPIC_TRACE);
+  appendSubscribe(out, 2, TOPIC_ACK);
+  double intervalMs = options.commands > 0 ? 1000.0 / options.commands : 0;
+  int64_t nextCommandMs = steadyMs() + int64_t(options.ramp * 1000) + 1000;  // Once the fleet is up
+  int64_t nextPingMs = steadyMs() + 30000;
+  std::vector<char> buffer(256 * 1024);
+  int epollFd = epoll_create1(0);
+  epoll_event event{};
+  event.events = EPOLLIN;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+
+  while (!stopping.load(std::memory_order_relaxed)) {
+    int64_t now = steadyMs();
+    if (intervalMs > 0 && now >= nextCommandMs) {
+      char id[24];
+      snprintf(id, sizeof(id), "sim-%llu", (unsigned long long)++commandsSent);
+      char command[96];
+      snprintf(command, sizeof(command), "{\"cmd\":\"OPEN\",\"id\":\"%s\",\"lane\":\"%s\"}", id,
+               LANES[commandsSent % LANE_COUNT].name);
+      sentAt[id] = wallUs();
+      appendPublish(out, TOPIC_DOOR_OPEN, command);
+      nextCommandMs += int64_t(intervalMs);
+    }
+    if (now >= nextPingMs) {
+      appendHeader(out, MQTT_PINGREQ, 0);
+      nextPingMs = now + 30000;
+    }
+    if (!send(fd, out)) {
+      fprintf(stderr, "observer: broker closed the connection\n");
+      return;
+    }
+    int64_t untilCommand = intervalMs > 0 ? std::max<int64_t>(0, nextCommandMs - now) : 100;
+    if (epoll_wait(epollFd, &event, 1, int(std::min<int64_t>(untilCommand, 100))) <= 0) {
+      continue;
+    }
+    ssize_t received;
+    while ((received = recv(fd, buffer.data(), buffer.size(), 0)) > 0) {
+      in.append(buffer.data(), received);
+    }
+    if (received == 0) {
+      fprintf(stderr, "observer: broker closed the connection\n");
+      return;
+    }
+    int64_t arrivedUs = wallUs();
+    takePackets(in, [&](uint8_t flags, std::string_view body) {
+      std::string_view topic;
+      std::string_view payload;
+      if ((flags & 0xF0) != MQTT_PUBLISH || !splitPublish(body, topic, payload)) {
+        return true;
+      }
+      if (topic == TOPIC_TRACE) {
+        tracesReceived++;
+        statusTransit.add(arrivedUs - jsonNumber(payload, "sentUs"));
+        int64_t edgeUs = jsonNumber(payload, "edgeUs");
+        if (edgeUs > 0) {  // 0: the boot-time sample, which follows no edge
+          edgeToHere.add(arrivedUs - edgeUs);
+        }
+      } else if (topic == TOPIC_ACK) {
+        acksReceived++;
+        auto found = sentAt.find(std::string(jsonString(payload, "id")));
+        if (found != sentAt.end()) {
+          commandAck.add(arrivedUs - found->second);
+        }
+      }
+      return true;
+    });
+  }
+}
+
+// --- Main ---
+
+// True if the comma-separated 'list' names 'item'.
+bool hasListItem(std::string_view list, std::string_view item) {
+  while (!list.empty()) {
+    size_t comma = list.find(',');
+    if (list.substr(0, comma) == item) {
+      return true;
+    }
+    list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+  }
+  return false;
+}
+
+Options parseOptions(int argc, char** argv) {
+  Options parsed;
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if (flag == "--deltas") {
+      parsed.deltas = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "%s needs a value\n", flag.c_str());
+      exit(2);
+    }
+    const char* value = argv[++i];
+    if (flag == "--broker") {
+      std::string broker = value;
+      size_t colon = broker.find(':');
+      parsed.host = broker.substr(0, colon);
+      if (colon != std::string::npos) {
+        parsed.port = static_cast<uint16_t>(atoi(broker.c_str() + colon + 1));
+      }
+    } else if (flag == "--nodes") {
+      parsed.nodes = atoi(value);
+    } else if (flag == "--threads") {
+      parsed.threads = atoi(value);
+    } else if (flag == "--duration") {
+      parsed.duration = atoi(value);
+    } else if (flag == "--slots") {
+      parsed.slots = atoi(value);
+    } else if (flag == "--arrivals") {
+      parsed.arrivals = atof(value);
+    } else if (flag == "--stay") {
+      parsed.stay = atof(value);
+    } else if (flag == "--commands") {
+      parsed.commands = atof(value);
+    } else if (flag == "--drops") {
+      parsed.drops = atof(value);
+    } else if (flag == "--outage") {
+      parsed.outage = atof(value);
+    } else if (flag == "--ramp") {
+      parsed.ramp = atof(value);
+    } else if (flag == "--keepalive") {
+      parsed.keepAlive = static_cast<uint16_t>(atoi(value));
+    } else if (flag == "--formats") {
+      parsed.statusTopics.clear();
+      for (const StatusTopic& topic : STATUS_TOPICS) {
+        if (hasListItem(value, statusFormatName(topic.format))) {
+          parsed.statusTopics.push_back(topic);
+        }
+      }
+    } else {
+      fprintf(stderr, "unknown option %s\n", flag.c_str());
+      exit(2);
+    }
+  }
+  if (parsed.nodes < 1 || parsed.slots < 1 || parsed.slots > MAX_SLOTS || parsed.stay <= 0 ||
+      parsed.statusTopics.empty()) {
+    fprintf(stderr, "need --nodes >= 1, 1 <= --slots <= %d, --stay > 0 and one of json, cbor, packed\n", MAX_SLOTS);
+    exit(2);
+  }
+  if (parsed.threads <= 0) {
+    parsed.threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  parsed.threads = std::min(parsed.threads, parsed.nodes);
+  return parsed;
+}
+
+Totals sumCounters(const std::vector<std::unique_ptr<Worker>>& workers) {
+  Totals totals;
+  for (const auto& worker : workers) {
+    totals.add(worker->counters);
+  }
+  return totals;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  options = parseOptions(argc, argv);
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+  if (getaddrinfo(options.host.c_str(), std::to_string(options.port).c_str(), &hints, &result) != 0) {
+    fprintf(stderr, "cannot resolve %s\n", options.host.c_str());
+    return 1;
+  }
+  memcpy(&brokerAddress, result->ai_addr, result->ai_addrlen);
+  brokerAddressLength = result->ai_addrlen;
+  freeaddrinfo(result);
+
+  std::string formats;
+  for (const StatusTopic& topic : options.statusTopics) {
+    formats += formats.empty() ? "" : ",";
+    formats += statusFormatName(topic.format);
+  }
+  printf("%d nodes x %d slots on %d threads against %s:%u for %d s (%s status as %s)\n", options.nodes,
+         options.slots, options.threads, options.host.c_str(), options.port, options.duration,
+         options.deltas ? "delta" : "full", formats.c_str());
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  int first = 0;
+  for (int t = 0; t < options.threads; t++) {
+    int count = options.nodes / options.threads + (t < options.nodes % options.threads ? 1 : 0);
+    workers.emplace_back(new Worker(first, count, 1000 + t));
+    first += count;
+  }
+  std::vector<std::thread> threads;
+  for (auto& worker : workers) {
+    threads.emplace_back([&worker] { worker->run(); });
+  }
+  Observer observer;
+  std::thread observerThread([&observer] { observer.run(); });
+
+  Totals previous;
+  int64_t startMs = steadyMs();
+  for (int second = 1; second <= options.duration; second++) {
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+        std::chrono::milliseconds(startMs + second * 1000)));
+    Totals now = sumCounters(workers);
+    printf("%4ds online %6d  pub %7llu/s (status %6llu/s) %7.2f MB/s  rx %7llu/s  connects %5llu  "
+           "drops broker %4llu link %4llu  failed %4llu\n",
+           second, now.online, (unsigned long long)(now.publishes - previous.publishes),
+           (unsigned long long)(now.statusDocs - previous.statusDocs), (now.bytesOut - previous.bytesOut) / 1e6,
+           (unsigned long long)(now.received - previous.received),
+           (unsigned long long)(now.connects - previous.connects),
+           (unsigned long long)(now.brokerDrops - previous.brokerDrops),
+           (unsigned long long)(now.linkDrops - previous.linkDrops),
+           (unsigned long long)(now.failedConnects - previous.failedConnects));
+    previous = now;
+  }
+  stopping = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  observerThread.join();
+
+  Totals totals = sumCounters(workers);
+  double seconds = (steadyMs() - startMs) / 1000.0;
+  printf("\n%.0f s: %llu publishes (%.0f/s, %llu status documents), %.1f MB out, %llu messages in\n", seconds,
+         (unsigned long long)totals.publishes, totals.publishes / seconds, (unsigned long long)totals.statusDocs,
+         totals.bytesOut / 1e6, (unsigned long long)totals.received);
+  printf("connections: %llu established, %llu failed, %llu dropped by the broker, %llu link drops; %d of %d "
+         "online at the end\n",
+         (unsigned long long)totals.connects, (unsigned long long)totals.failedConnects,
+         (unsigned long long)totals.brokerDrops, (unsigned long long)totals.linkDrops, totals.online,
+         options.nodes);
+  printf("traffic: %llu arrivals (%llu turned away), %llu departures\n", (unsigned long long)totals.arrivals,
+         (unsigned long long)totals.turnedAway, (unsigned long long)totals.departures);
+  printf("commands: %llu sent, %llu acks received (%.1f per command; every node answers door_open)\n",
+         (unsigned long long)observer.commandsSent, (unsigned long long)observer.acksReceived,
+         observer.commandsSent ? double(observer.acksReceived) / observer.commandsSent : 0.0);
+  printf("latency at the observer:\n%s\n%s\n%s\n", observer.statusTransit.report("status sent -> here").c_str(),
+         observer.edgeToHere.report("sensor edge -> here").c_str(),
+         observer.commandAck.report("door_open -> ack").c_str());
+  return 0;
+}
@@ -0,0 +1,213 @@
+// Expander Bus Check
+// Runs access_control/expander_sensor_bus.cpp on the host against a model of
+// four MCP23017s: their registers, inverted inputs, and open-drain INT lines
+// that go low on any input change and stay low until the ports are read.
+// Two expanders share one INT pin, one has a pin of its own and one is
+// polled. The bus must:
+//
+//   - configure every expander (mirrored open-drain INT, all inputs,
+//     inverted, interrupt on change) and register each distinct line once;
+//   - read every expander on the first pass, then only expanders whose line
+//     is low (both on a shared line) plus the polled one;
+//   - leave a line whose read failed for the resync instead of retrying it
+//     every pass, and pick the change up on the resync 1 s later.
+//
+// Built and run by run_checks.sh (expander_bus).
+
+#include <cstdio>
+
+#include "expander_sensor_bus.h"
+#include "host_check.h"
+
+namespace {
+
+const int NUM_PINS = 40;
+const int SHARED_LINE = 36;
+const int OWN_LINE = 4;
+
+// --- Host Arduino core ---
+unsigned long nowMs = 0;
+uint8_t pinModes[NUM_PINS];
+int wakeLines[NUM_PINS];
+int wakeLineCount = 0;
+
+class FakeMcp23017 {
+ public:
+  static const int NUM_REGISTERS = 0x16;
+
+  explicit FakeMcp23017(uint8_t address) : address(address) {
+    memset(registers, 0, sizeof(registers));
+  }
+
+  // 'occupied' sensors pull their input LOW.
+  void setSensor(int input, bool occupied) {
+    uint16_t before = levels;
+    if (occupied) {
+      levels &= ~(1u << input);
+    } else {
+      levels |= 1u << input;
+    }
+    uint16_t enabled = registers[0x04] | (registers[0x05] << 8);
+    if ((before ^ levels) & enabled) {
+      interrupt = true;
+    }
+  }
+
+  uint8_t port(int p) const {
+    uint8_t raw = levels >> (8 * p);
+    return raw ^ registers[0x02 + p]; // IPOLA/IPOLB
+  }
+
+  const uint8_t address;
+  uint8_t registers[NUM_REGISTERS];
+  uint16_t levels = 0xFFFF; // All slots free
+  bool interrupt = false;   // INTA pulled low
+  bool failing = false;     // NACK every read
+};
+
+FakeMcp23017 chips[] = { FakeMcp23017(0x20), FakeMcp23017(0x21), FakeMcp23017(0x22), FakeMcp23017(0x23) };
+const int NUM_CHIPS = sizeof(chips) / sizeof(chips[0]);
+
+const ExpanderConfig EXPANDERS[NUM_CHIPS] = {
+  { 0x20, SHARED_LINE, 0 },
+  { 0x21, OWN_LINE, 16 },
+  { 0x22, SHARED_LINE, 32 },
+  { 0x23, -1, 48 },
+};
+
+FakeMcp23017* chipAt(uint8_t address) {
+  for (FakeMcp23017& chip : chips) {
+    if (chip.address == address) {
+      return &chip;
+    }
+  }
+  return nullptr;
+}
+
+class FakeI2cBus : public I2cBus {
+ public:
+  bool writeRegister(uint8_t address, uint8_t reg, uint8_t value) {
+    FakeMcp23017* chip = chipAt(address);
+    if (chip == nullptr || reg >= FakeMcp23017::NUM_REGISTERS) {
+      return false;
+    }
+    chip->registers[reg] = value;
+    if (reg == 0x0A || reg == 0x0B) { // IOCON is one register at two addresses
+      chip->registers[0x0A] = chip->registers[0x0B] = value;
+    }
+    return true;
+  }
+
+  bool readRegisters(uint8_t address, uint8_t reg, uint8_t* data, size_t length) {
+    transactions++;
+    FakeMcp23017* chip = chipAt(address);
+    if (chip == nullptr || chip->failing || reg != 0x12 || length != 2) {
+      return false;
+    }
+    data[0] = chip->port(0);
+    data[1] = chip->port(1);
+    chip->interrupt = false; // Reading GPIO clears the interrupt
+    return true;
+  }
+
+  uint32_t transactions = 0;
+};
+
+// Sample at 'ms' and return the number of I2C reads the pass made.
+uint32_t sampleAt(ExpanderSensorBus& bus, FakeI2cBus& i2c, OccupancyBits& occupied, unsigned long ms) {
+  nowMs = ms;
+  uint32_t before = i2c.transactions;
+  bus.sample(occupied);
+  return i2c.transactions - before;
+}
+
+}  // namespace
+
+unsigned long millis() { return nowMs; }
+
+void pinMode(uint8_t pin, uint8_t mode) { pinModes[pin] = mode; }
+
+void digitalWrite(uint8_t, uint8_t) {}
+
+// An INT line is low while any expander wired to it has an interrupt pending.
+int digitalRead(uint8_t pin) {
+  for (int i = 0; i < NUM_CHIPS; i++) {
+    if (EXPANDERS[i].intPin == pin && chips[i].interrupt) {
+      return LOW;
+    }
+  }
+  return HIGH;
+}
+
+void registerWakeLine(int pin) { wakeLines[wakeLineCount++] = pin; }
+
+int main() {
+  FakeI2cBus i2c;
+  ExpanderSensorBus bus(i2c, EXPANDERS, NUM_CHIPS);
+  bus.begin();
+
+  for (const FakeMcp23017& chip : chips) {
+    CHECK(chip.registers[0x0A] == 0x44); // IOCON: MIRROR | ODR
+    for (int p = 0; p < 2; p++) {
+      CHECK(chip.registers[0x00 + p] == 0xFF); // IODIR: inputs
+      CHECK(chip.registers[0x02 + p] == 0xFF); // IPOL: inverted
+      CHECK(chip.registers[0x04 + p] == 0xFF); // GPINTEN
+      CHECK(chip.registers[0x08 + p] == 0x00); // INTCON: on change
+    }
+  }
+  CHECK(wakeLineCount == 2);
+  CHECK(wakeLines[0] == SHARED_LINE && wakeLines[1] == OWN_LINE);
+  CHECK(pinModes[SHARED_LINE] == INPUT_PULLUP && pinModes[OWN_LINE] == INPUT_PULLUP);
+  CHECK(bus.sensorCount() == 64);
+
+  OccupancyBits occupied;
+  chips[2].setSensor(9, true);
+  CHECK(sampleAt(bus, i2c, occupied, 10) == 4); // First pass reads everything
+  CHECK(occupied.test(32 + 9));
+  CHECK(!bus.hasPendingChange());
+
+  uint32_t quiet = sampleAt(bus, i2c, occupied, 20);
+  printf("quiet pass: %u reads (the polled expander)\n", quiet);
+  CHECK(quiet == 1);
+
+  chips[1].setSensor(3, true);
+  CHECK(bus.hasPendingChange());
+  uint32_t own = sampleAt(bus, i2c, occupied, 30);
+  printf("change on a dedicated line: %u reads\n", own);
+  CHECK(own == 2);
+  CHECK(occupied.test(16 + 3));
+  CHECK(!bus.hasPendingChange());
+
+  chips[0].setSensor(15, true);
+  uint32_t shared = sampleAt(bus, i2c, occupied, 40);
+  printf("change on a shared line: %u reads\n", shared);
+  CHECK(shared == 3); // Both expanders on the line, plus the polled one
+  CHECK(occupied.test(15));
+
+  chips[3].setSensor(0, true);
+  sampleAt(bus, i2c, occupied, 50);
+  CHECK(occupied.test(48));
+
+  // A read that fails leaves its line low. The bus must not hammer it.
+  chips[1].failing = true;
+  chips[1].setSensor(3, false);
+  uint32_t errorsBefore = bus.readErrors();
+  CHECK(sampleAt(bus, i2c, occupied, 60) == 2);
+  CHECK(bus.readErrors() == errorsBefore + 1);
+  CHECK(!bus.hasPendingChange());
+  uint32_t retried = 0;
+  for (unsigned long ms = 70; ms < 1000; ms += 10) {
+    retried += sampleAt(bus, i2c, occupied, ms) - 1;
+  }
+  printf("failed line: %u retries before the resync\n", retried);
+  CHECK(retried == 0);
+  CHECK(occupied.test(16 + 3)); // Stale until the resync
+
+  chips[1].failing = false;
+  CHECK(sampleAt(bus, i2c, occupied, 1010) == 4); // Resync 1 s after the last
+  CHECK(!occupied.test(16 + 3));
+  CHECK(occupied.test(15) && occupied.test(32 + 9) && occupied.test(48));
+  CHECK(!bus.hasPendingChange());
+  printf("%u reads, %u errors\n", bus.expanderReads(), bus.readErrors());
+  return finishChecks("expander_bus");
+}
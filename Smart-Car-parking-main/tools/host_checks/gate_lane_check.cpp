@@ -0,0 +1,201 @@
+// Gate Lane Check
+// Runs access_control/gate_policy.cpp and gate_lane.cpp on the host:
+//
+//   - throughput: an hour of cars, each tapping in 2 s after the arm is
+//     down, moving off once it is up (1 s), reaching the beam 0.5 s later
+//     and blocking it for 1.5 s. With the passage sensor the barrier must
+//     manage more cycles than on the fixed 5 s timer.
+//   - morning rush: a continuous queue, the next car tapping 2.5 s after the
+//     one in front (or once the arm is down, if it has to wait for its own
+//     cycle), 1 s of arm travel, 1 s to the beam and 1.5 s in it, and a
+//     duplicate remote OPEN 300 ms after every tap. Queued entries must beat
+//     one car per cycle, and the duplicates must all coalesce.
+//   - queue overflow: open requests beyond GatePolicy::MAX_QUEUE are dropped
+//     and counted in the lane's stats.
+//   - stuck beam: after a fault close the lane must not carry the blocked
+//     beam over into the next cycle. Reopened with a car still in the beam,
+//     the barrier has to stay up rather than time out onto it.
+//
+// Built and run by run_checks.sh (gate_lane).
+
+#include <cstdio>
+
+#include "gate_lane.h"
+#include "gate_policy.h"
+#include "host_check.h"
+#include "timer_wheel.h"
+
+namespace {
+
+// gate_handler.cpp's entry lane.
+const GateTiming TIMING = { 1500, 800, 5000, 30000, 3000, 1500, 15000 };
+const LaneConfig LANE = { "entry", 12, 14, 0, 90, { 90, 180 }, TIMING };
+
+const TimeMs HOUR = 3600000;
+
+uint32_t cyclesPerHour(bool sensor) {
+  GatePolicy policy(TIMING);
+  TimeMs nextTap = 2000;
+  TimeMs beamOn = 0;
+  TimeMs beamOff = 0;
+  bool carComing = false;
+  for (TimeMs now = 0; now < HOUR; now++) {
+    if (!policy.isOpen() && !carComing && now >= nextTap) {
+      policy.requestOpen(now);
+      beamOn = now + 1500;
+      beamOff = beamOn + 1500;
+      carComing = true;
+    }
+    if (sensor && carComing && now == beamOn) {
+      policy.beamChanged(now, true);
+    }
+    if (sensor && carComing && now == beamOff) {
+      policy.beamChanged(now, false);
+    }
+    if (policy.isOpen() && timeReached(now, policy.deadline()) &&
+        policy.deadlineReached(now) != GatePolicy::NO_ACTION) {
+      carComing = false;
+      nextTap = now + 2000;
+    }
+  }
+  printf("%s: %u cycles/hour, %.1f vehicles/min, average cycle %u ms\n", sensor ? "sensor-gated" : "fixed 5 s",
+         policy.cycleCount(), policy.cycleCount() / 60.0, policy.averageCycleMs());
+  return policy.cycleCount();
+}
+
+uint32_t rushVehiclesPerHour(bool queue) {
+  GatePolicy policy(TIMING);
+  const int TRACKED = 64;
+  TimeMs nextTap = 2000;
+  TimeMs armUpAt = 0;
+  TimeMs armDownAt = 0;
+  TimeMs beamOn[TRACKED];
+  TimeMs beamOff[TRACKED];
+  int head = 0;
+  int tail = 0;
+  TimeMs duplicateAt = 0;
+  bool duplicatePending = false;
+  TimeMs beamFreeAt = 0;
+  for (TimeMs now = 0; now < HOUR; now++) {
+    bool canTap = queue || (!policy.isOpen() && now >= armDownAt);
+    if (now >= nextTap && canTap) {
+      bool wasOpen = policy.isOpen();
+      if (policy.requestOpen(now) == GatePolicy::OPEN_BARRIER) {
+        armUpAt = now + 1000;
+      }
+      TimeMs go = wasOpen ? now : armUpAt;
+      TimeMs on = go + 1000;
+      if (on < beamFreeAt + 500) {
+        on = beamFreeAt + 500;
+      }
+      beamOn[tail % TRACKED] = on;
+      beamOff[tail % TRACKED] = on + 1500;
+      beamFreeAt = on + 1500;
+      tail++;
+      duplicateAt = now + 300;
+      duplicatePending = true;
+      nextTap = now + 2500;
+    }
+    if (duplicatePending && now == duplicateAt) {
+      policy.requestOpen(now);
+      duplicatePending = false;
+    }
+    if (head < tail && now == beamOn[head % TRACKED]) {
+      policy.beamChanged(now, true);
+    }
+    if (head < tail && now == beamOff[head % TRACKED]) {
+      policy.beamChanged(now, false);
+      head++;
+    }
+    if (policy.isOpen() && timeReached(now, policy.deadline()) &&
+        policy.deadlineReached(now) != GatePolicy::NO_ACTION) {
+      armDownAt = now + 1000;
+      head = tail;
+    }
+  }
+  printf("%-15s %5u vehicles/h (%.1f/min), %4u cycles, %.1f entries/cycle (max %u), %u coalesced, %u no-shows\n",
+         queue ? "queued entries:" : "one per cycle:", policy.vehicleCount(), policy.vehicleCount() / 60.0,
+         policy.cycleCount(), policy.cycleCount() ? double(policy.entryCount()) / policy.cycleCount() : 0.0,
+         policy.maxEntriesInCycle(), policy.coalescedCount(), policy.noShowCount());
+  CHECK(policy.coalescedCount() == policy.entryCount());
+  return policy.vehicleCount();
+}
+
+class TestLane : public LaneHardware {
+ public:
+  void begin(const LaneConfig& config, TimerWheel&) { angle = config.closedAngle; }
+  void moveBarrier(float to) { angle = to; }
+  bool beamBlocked() { return blocked; }
+
+  float angle = -1;
+  bool blocked = false;
+};
+
+void runFor(TimerWheel& wheel, GateLane& lane, TimeMs ms) {
+  for (TimeMs i = 0; i < ms; i++) {
+    wheel.advance(wheel.now() + 1);
+    lane.update();
+  }
+}
+
+void checkQueueOverflow() {
+  TimerWheel wheel;
+  wheel.begin(0);
+  TestLane hardware;
+  GateLane lane;
+  lane.begin(LANE, hardware, wheel);
+
+  // Distinct cars (further apart than coalesceMs), two more than fit.
+  for (int car = 0; car < GatePolicy::MAX_QUEUE + 2; car++) {
+    lane.open();
+    runFor(wheel, lane, TIMING.coalesceMs + 1);
+  }
+  GateStats stats = lane.stats();
+  printf("queue overflow: %u entries, %u dropped\n", stats.entries, stats.queueOverflows);
+  CHECK(stats.entries == GatePolicy::MAX_QUEUE);
+  CHECK(stats.queueOverflows == 2);
+}
+
+void checkStuckBeamRecovery() {
+  TimerWheel wheel;
+  wheel.begin(0);
+  TestLane hardware;
+  GateLane lane;
+  lane.begin(LANE, hardware, wheel);
+
+  // A car stops in the beam until the fault timer brings the arm down.
+  lane.open();
+  runFor(wheel, lane, 1000);
+  hardware.blocked = true;
+  runFor(wheel, lane, TIMING.beamFaultMs + 100);
+  CHECK(!lane.isOpen());
+  CHECK(hardware.angle == LANE.closedAngle);
+
+  // Opened again with the car still there: the lane has to see the beam
+  // blocked and keep the arm up past the 5 s window.
+  lane.open();
+  runFor(wheel, lane, TIMING.maxOpenMs + 1000);
+  CHECK(lane.isOpen());
+  CHECK(hardware.angle == LANE.openAngle);
+
+  // The car drives off: one vehicle, then the arm comes down.
+  hardware.blocked = false;
+  runFor(wheel, lane, TIMING.minOpenMs + TIMING.clearMarginMs + 100);
+  CHECK(!lane.isOpen());
+  CHECK(lane.stats().vehicles == 1);
+  printf("stuck beam: %u cycles, %u vehicles\n", lane.stats().cycles, lane.stats().vehicles);
+}
+
+}  // namespace
+
+int main() {
+  uint32_t fixed = cyclesPerHour(false);
+  uint32_t gated = cyclesPerHour(true);
+  CHECK(gated > fixed);
+  uint32_t single = rushVehiclesPerHour(false);
+  uint32_t queued = rushVehiclesPerHour(true);
+  CHECK(queued > single);
+  checkQueueOverflow();
+  checkStuckBeamRecovery();
+  return finishChecks("gate_lane");
+}
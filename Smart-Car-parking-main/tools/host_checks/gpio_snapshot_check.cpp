@@ -0,0 +1,142 @@
+// GPIO Snapshot Check
+// Runs access_control/gpio_sensor_bus.cpp on the host against a model of the
+// ESP32's 40 input pins and the two GPIO_IN registers they read through, with
+// the slot handler's seven sensors (pins on both registers). The register
+// snapshot must agree with one digitalRead() per pin for 100k random pin
+// levels, leave slots without a sensor alone, and give way to digitalRead()
+// when a pin is not a plain GPIO. The first edge on a sensor is latched until
+// the next sample takes it, however much it bounces before then.
+//
+// Built and run by run_checks.sh (gpio_snapshot).
+
+#include <cstdio>
+#include <random>
+
+#include <soc/gpio_reg.h>
+
+#include "gpio_sensor_bus.h"
+#include "host_check.h"
+
+namespace {
+
+const int NUM_PINS = 40;
+
+// slot_handler.cpp's sensors.
+const int NUM_SENSORS = 7;
+const int SENSOR_PINS[NUM_SENSORS] = { 34, 35, 32, 33, 25, 26, 27 };
+const int SENSOR_SLOTS[NUM_SENSORS] = { 1, 4, 5, 8, 12, 16, 18 };
+
+// --- Host ESP32 ---
+uint64_t levels = ~0ULL;  // Bit per pin; all slots free
+int64_t nowUs = 0;
+uint8_t pinModes[NUM_PINS];
+void (*edgeHandlers[NUM_PINS])(void*);
+void* edgeArgs[NUM_PINS];
+uint32_t registerReads = 0;
+
+void edge(int pin, int64_t atUs) {
+  nowUs = atUs;
+  edgeHandlers[pin](edgeArgs[pin]);
+}
+
+}  // namespace
+
+int digitalRead(uint8_t pin) { return pin < NUM_PINS ? (levels >> pin) & 1 : HIGH; }
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < NUM_PINS) {
+    pinModes[pin] = mode;
+  }
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode) {
+  if (pin < NUM_PINS && mode == CHANGE) {
+    edgeHandlers[pin] = handler;
+    edgeArgs[pin] = arg;
+  }
+}
+
+uint32_t hostRegRead(uint32_t reg) {
+  registerReads++;
+  return reg == GPIO_IN_REG ? (uint32_t)levels : (uint32_t)(levels >> 32) & 0xFF;
+}
+
+int64_t esp_timer_get_time() { return nowUs; }
+
+void wakeLoopFromISR() {}
+
+int main() {
+  GpioSensorBus bus(SENSOR_PINS, SENSOR_SLOTS, NUM_SENSORS);
+  bus.begin();
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    CHECK(pinModes[SENSOR_PINS[i]] == INPUT);
+    CHECK(edgeHandlers[SENSOR_PINS[i]] != nullptr);
+  }
+  CHECK(bus.snapshotSampling());
+
+  std::mt19937_64 rng(3);
+  int mismatches = 0;
+  int wrong = 0;
+  for (int pass = 0; pass < 100000; pass++) {
+    levels = rng();
+    OccupancyBits viaDigitalRead;
+    OccupancyBits viaSnapshot;
+    viaDigitalRead.fill();
+    viaSnapshot.fill();
+    bus.setSnapshotSampling(false);
+    bus.sample(viaDigitalRead);
+    bus.setSnapshotSampling(true);
+    bus.sample(viaSnapshot);
+    if (viaDigitalRead != viaSnapshot) {
+      mismatches++;
+    }
+    OccupancyBits expected;
+    expected.fill();
+    for (int i = 0; i < NUM_SENSORS; i++) {
+      expected.set(SENSOR_SLOTS[i], !((levels >> SENSOR_PINS[i]) & 1));
+    }
+    if (viaSnapshot != expected) {
+      wrong++;
+    }
+  }
+  printf("100000 random pin states: %d snapshot/digitalRead mismatches, %d wrong, %u register reads\n",
+         mismatches, wrong, registerReads);
+  CHECK(mismatches == 0);
+  CHECK(wrong == 0);
+  CHECK(registerReads == 2 * 100000); // Two registers per snapshot, never per pin
+
+  // A bouncing sensor: the trace starts at its first edge.
+  levels = ~0ULL;
+  OccupancyBits occupied;
+  bus.sample(occupied);
+  CHECK(!bus.hasPendingChange());
+  edge(32, 1000);
+  edge(32, 1150);
+  edge(32, 1300);
+  levels &= ~(1ULL << 32);
+  CHECK(bus.hasPendingChange());
+  bus.sample(occupied);
+  CHECK(occupied.test(5));
+  CHECK(bus.edgeUs(5) == 1000);
+  CHECK(bus.edgeUs(1) == 0);
+  CHECK(!bus.hasPendingChange());
+  edge(32, 2000); // Bounce after the sample: belongs to the next one
+  CHECK(bus.edgeUs(5) == 1000);
+  bus.sample(occupied);
+  CHECK(bus.edgeUs(5) == 2000);
+  bus.sample(occupied);
+  CHECK(bus.edgeUs(5) == 0);
+  printf("bouncing sensor: trace starts at the first edge\n");
+
+  // A pin the registers do not cover keeps the bus on digitalRead().
+  const int ODD_PINS[2] = { 25, 40 };
+  const int ODD_SLOTS[2] = { 0, 1 };
+  GpioSensorBus odd(ODD_PINS, ODD_SLOTS, 2);
+  odd.begin();
+  odd.setSnapshotSampling(true);
+  CHECK(!odd.snapshotSampling());
+  levels = ~(1ULL << 25);
+  odd.sample(occupied);
+  CHECK(occupied.test(0) && !occupied.test(1));
+  return finishChecks("gpio_snapshot");
+}
@@ -0,0 +1,262 @@
+// Host Heap Soak
+// The host half of the heap soak (access_control/heap_soak.cpp, built into
+// the firmware with -DHEAP_SOAK_TEST). It drives the controllers that build
+// for the host -- two gate lanes, the slot monitor and the status publisher
+// with deltas, the full-document template and every status format -- with the
+// device soak's randomized commands and slot updates and its schedule, on a
+// simulated clock. heap_tracker.cpp is built with -DHEAP_TRACK_HOST, so every
+// allocation the controllers make goes through its counting allocator. After
+// the warm-up neither the live allocations nor the live bytes may grow, and
+// no module's HeapScope may be left holding any.
+//
+// mqttCallback() and the MQTT session need ArduinoJson and PubSubClient and
+// are only soaked on the device.
+//
+// Built and run by run_checks.sh (heap_soak).
+
+#include <cstdio>
+#include <random>
+
+#include "gate_controller.h"
+#include "heap_tracker.h"
+#include "host_check.h"
+#include "message_link.h"
+#include "slot_monitor.h"
+#include "status_publisher.h"
+#include "timer_wheel.h"
+
+namespace {
+
+// --- Soak Settings ---
+// As heap_soak.cpp, with no tolerance: on the host nothing else shares the heap.
+const uint32_t SOAK_WARMUP_ITERATIONS = 10000;
+const uint32_t SOAK_CHECK_INTERVAL = 100000;
+const uint32_t SOAK_TOTAL_ITERATIONS = 2000000;
+const int SOAK_MAX_NAME = 64;
+const int SLOT_COUNT = 20;
+const size_t DEVICE_ID_LENGTH = 12;
+
+const StatusTopic STATUS_TOPICS[] = {
+  { "parking/esp32/status", STATUS_FORMAT_JSON },
+  { "parking/esp32/status/cbor", STATUS_FORMAT_CBOR },
+  { "parking/esp32/status/packed", STATUS_FORMAT_PACKED },
+};
+const SamplingLimits SAMPLING_LIMITS = { 10, 200, 30000 };
+const int LANE_COUNT = 2;
+const LaneConfig LANES[LANE_COUNT] = {
+  { "entry", -1, -1, 0, 90, { 90, 180 }, { 1500, 800, 5000, 30000, 3000, 1500, 15000 } },
+  { "exit", -1, -1, 0, 90, { 90, 180 }, { 1500, 800, 5000, 30000, 3000, 1500, 15000 } },
+};
+
+// Simulated time, one millisecond per soak iteration.
+class SoakClock : public ControllerClock {
+ public:
+  int64_t monotonicUs() { return nowUs; }
+  int64_t traceNowUs() { return nowUs; }
+  int64_t traceFromMonotonicUs(int64_t monotonicUs) { return monotonicUs; }
+  bool isTraceSynced() { return true; }
+  uint32_t cycleCount() { return static_cast<uint32_t>(nowUs * 240); }
+  uint32_t cyclesPerUs() { return 240; }
+
+  int64_t nowUs = 0;
+};
+
+class SoakLane : public LaneHardware {
+ public:
+  void begin(const LaneConfig&, TimerWheel&) {}
+  void moveBarrier(float) {}
+  bool beamBlocked() { return false; }
+};
+
+class SoakSensors : public SlotSensorBus {
+ public:
+  const char* name() const { return "soak"; }
+  void begin() {}
+  int sensorCount() const { return SLOT_COUNT; }
+  void sample(OccupancyBits& occupied) {
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+      occupied.set(slot, state.test(slot));
+    }
+  }
+  void markSensed(OccupancyBits& sensed) const {
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+      sensed.set(slot, true);
+    }
+  }
+  int64_t edgeUs(int) const { return 0; }
+
+  OccupancyBits state;
+};
+
+// Counts what would have gone to the broker; drops now and then, as WiFi does.
+class SoakLink : public MessageLink {
+ public:
+  bool connected() { return online; }
+  bool publish(const char*, const char*) { return count(); }
+  bool beginPublish(const char*, size_t) { return count(); }
+  void write(const uint8_t*, size_t length) { bytes += length; }
+  bool endPublish() { return online; }
+
+  bool online = true;
+  uint64_t publishes = 0;
+  uint64_t bytes = 0;
+
+ private:
+  bool count() {
+    if (online) {
+      publishes++;
+    }
+    return online;
+  }
+};
+
+class SoakNode : public SlotEvents {
+ public:
+  SoakNode() : buses{ &sensors }, slots(buses, 1, SLOT_COUNT, SAMPLING_LIMITS), lanes{ &laneHardware[0], &laneHardware[1] } {}
+
+  void begin() {
+    wheel.begin(0);
+    status.begin("a1b2c3d4e5f6", config, slots.sensed(), link, wheel, clock);
+    gates.begin(LANES, lanes, wheel);
+    // Just short of the synthetic range, so the monitor's IDs wrap during the soak.
+    slots.begin(wheel, clock, *this, SYNTHETIC_TRACE_ID_BASE - 3);
+  }
+
+  void slotsChanged(const OccupancyBits& occupied, int slotCount, const SlotTrace& trace) {
+    CHECK(trace.id < SYNTHETIC_TRACE_ID_BASE);
+    monitorChanges++;
+    status.publish(occupied, slotCount, trace);
+  }
+  bool lotBusy() { return gates.anyOpen(); }
+
+  // One loop() pass, a millisecond after the last.
+  void loop() {
+    clock.nowUs += 1000;
+    wheel.advance(static_cast<TimeMs>(clock.nowUs / 1000));
+    gates.update();
+    slots.poll();
+  }
+
+  SoakClock clock;
+  TimerWheel wheel;
+  SoakSensors sensors;
+  SlotSensorBus* const buses[1];
+  SlotMonitor slots;
+  SoakLane laneHardware[LANE_COUNT];
+  LaneHardware* const lanes[LANE_COUNT];
+  GateController<LANE_COUNT> gates;
+  FixedStatusTemplate<SLOT_COUNT, DEVICE_ID_LENGTH> statusTemplate;
+  StatusConfig config = { STATUS_TOPICS, 3, true, &statusTemplate };
+  StatusPublisher status;
+  SoakLink link;
+  uint32_t monitorChanges = 0;
+};
+
+std::mt19937 random(1);
+
+int randomBelow(int limit) {
+  return std::uniform_int_distribution<int>(0, limit - 1)(random);
+}
+
+// A door_open command: a lane name, or (as the device soak sends) lower case
+// and digits that name no lane.
+void injectRandomCommand(SoakNode& node) {
+  char name[SOAK_MAX_NAME + 1];
+  int pick = randomBelow(8);
+  if (pick < LANE_COUNT) {
+    snprintf(name, sizeof(name), "%s", LANES[pick].name);
+  } else {
+    int length = 1 + randomBelow(SOAK_MAX_NAME);
+    for (int i = 0; i < length; i++) {
+      name[i] = (i % 3 == 0) ? '0' + randomBelow(10) : 'a' + randomBelow(26);
+    }
+    name[length] = '\0';
+  }
+  int lane = node.gates.findLane(name);
+  if (lane != GateController<LANE_COUNT>::NO_LANE) {
+    node.gates.open(lane);
+  }
+}
+
+// Slot changes both ways in: through the sensors to the monitor, and straight
+// to the publisher with a synthetic trace, as heap_soak.cpp sends them.
+void injectRandomSlots(SoakNode& node, uint32_t& soakTraceId) {
+  node.sensors.state.set(randomBelow(SLOT_COUNT), randomBelow(2) == 1);
+  OccupancyBits states;
+  for (int slot = 0; slot < SLOT_COUNT; slot++) {
+    states.set(slot, randomBelow(2) == 1);
+  }
+  SlotTrace trace;
+  trace.id = soakTraceId++;
+  trace.detectUs = node.clock.traceNowUs();
+  trace.edgeUs = trace.detectUs;
+  node.status.publish(states, SLOT_COUNT, trace);
+}
+
+// The allocator wrapping must be live, or every later check passes vacuously.
+void checkTrackerCountsAllocations() {
+  static char* volatile held;
+  {
+    HeapScope heapScope(HEAP_MODULE_RFID);
+    held = new char[100];
+  }
+  const HeapModuleStats& stats = getHeapModuleStats(HEAP_MODULE_RFID);
+  CHECK(stats.netBlocks == 1);
+  CHECK(stats.netBytes == 100);
+  {
+    HeapScope heapScope(HEAP_MODULE_RFID);
+    delete[] held;
+  }
+  CHECK(stats.netBlocks == 0);
+  CHECK(stats.netBytes == 0);
+}
+
+}  // namespace
+
+int main() {
+  checkTrackerCountsAllocations();
+
+  static SoakNode node;  // Not on the stack: the template alone is over a kilobyte
+  node.begin();
+
+  uint32_t soakTraceId = SYNTHETIC_TRACE_ID_BASE;
+  HeapSnapshot baseline = {};
+  for (uint32_t iterations = 1; iterations <= SOAK_TOTAL_ITERATIONS; iterations++) {
+    node.loop();
+    injectRandomCommand(node);
+    if (iterations % 10 == 0) {
+      injectRandomSlots(node, soakTraceId);
+    }
+    if (iterations % 50000 == 0) {
+      node.link.online = !node.link.online;
+      if (node.link.online) {
+        node.status.connected();
+      }
+    }
+
+    if (iterations == SOAK_WARMUP_ITERATIONS) {
+      baseline = getHeapSnapshot();
+    } else if (iterations > SOAK_WARMUP_ITERATIONS && iterations % SOAK_CHECK_INTERVAL == 0) {
+      HeapSnapshot now = getHeapSnapshot();
+      CHECK(now.allocatedBlocks <= baseline.allocatedBlocks);
+      CHECK(now.freeBytes >= baseline.freeBytes);
+    }
+  }
+
+  for (int module = 0; module < HEAP_MODULE_COUNT; module++) {
+    const HeapModuleStats& stats = getHeapModuleStats(static_cast<HeapModule>(module));
+    CHECK(stats.netBlocks == 0);
+    CHECK(stats.netBytes == 0);
+  }
+  CHECK(node.monitorChanges > 0);
+  CHECK(node.gates.lane(0).stats().cycles > 0);
+
+  HeapSnapshot end = getHeapSnapshot();
+  printf("%u iterations, %u monitored changes, %llu publishes (%llu bytes streamed)\n",
+         SOAK_TOTAL_ITERATIONS, node.monitorChanges, static_cast<unsigned long long>(node.link.publishes),
+         static_cast<unsigned long long>(node.link.bytes));
+  printf("live allocations %u (baseline %u), free %u (baseline %u), network scope calls %u\n",
+         end.allocatedBlocks, baseline.allocatedBlocks, end.freeBytes, baseline.freeBytes,
+         getHeapModuleStats(HEAP_MODULE_NETWORK).calls);
+  return finishChecks("heap_soak");
+}
@@ -0,0 +1,34 @@
+// Host Checks
+// Shared reporting for the checks in this directory. Each check is a small
+// program built from the firmware's own sources; CHECK() records a failure
+// and carries on, and finishChecks() prints the verdict and gives main() its
+// exit code. run_checks.sh builds and runs them all.
+
+#ifndef HOST_CHECK_H
+#define HOST_CHECK_H
+
+#include <cstdio>
+
+inline int& checkFailures() {
+  static int failures = 0;
+  return failures;
+}
+
+#define CHECK(condition)                                                      \
+  do {                                                                        \
+    if (!(condition)) {                                                       \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      checkFailures()++;                                                      \
+    }                                                                         \
+  } while (0)
+
+inline int finishChecks(const char* name) {
+  if (checkFailures() > 0) {
+    std::printf("%s: FAILED (%d checks)\n", name, checkFailures());
+    return 1;
+  }
+  std::printf("%s: passed\n", name);
+  return 0;
+}
+
+#endif
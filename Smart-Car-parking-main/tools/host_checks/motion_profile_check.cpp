@@ -0,0 +1,87 @@
+// Motion Profile Check
+// Steps access_control/motion_profile.cpp at the servo's 20 ms PWM frame, as
+// ServoMotion does, with the barrier limits from gate_handler.cpp (90 deg/s,
+// 180 deg/s^2). Every move must be monotonic, end exactly on its target and
+// never step further in a frame than the speed limit allows. A full 0->90
+// swing takes 1.5 s with 0.5 s of acceleration (minOpenMs relies on that).
+// A short move never reaches full speed: it becomes a triangle. One move
+// starts just before the 32-bit millisecond wrap.
+//
+// Built and run by run_checks.sh (motion_profile).
+
+#include <cmath>
+#include <cstdio>
+
+#include "host_check.h"
+#include "motion_profile.h"
+
+namespace {
+
+const MotionLimits LIMITS = { 90, 180 };
+const TimeMs FRAME_MS = 20;
+const float TOLERANCE = 0.01f;
+
+struct Move {
+  float from;
+  float to;
+  TimeMs startAt;
+};
+
+void checkMove(const Move& move) {
+  MotionProfile profile;
+  profile.plan(move.from, move.to, LIMITS, move.startAt);
+
+  float distance = std::fabs(move.to - move.from);
+  float direction = move.to > move.from ? 1.0f : -1.0f;
+  // A triangle peaks at sqrt(acceleration * distance).
+  float peakSpeed = std::fmin(LIMITS.maxSpeed, std::sqrt(LIMITS.acceleration * distance));
+
+  float previous = move.from;
+  float largestStep = 0;
+  bool monotonic = true;
+  TimeMs durationMs = timeElapsed(profile.endTime(), profile.startTime());
+  for (TimeMs elapsed = 0; elapsed <= durationMs + 2 * FRAME_MS; elapsed += FRAME_MS) {
+    float angle = profile.positionAt(move.startAt + elapsed);
+    float step = (angle - previous) * direction;
+    if (step < -TOLERANCE) {
+      monotonic = false;
+    }
+    largestStep = std::fmax(largestStep, std::fabs(angle - previous));
+    previous = angle;
+  }
+
+  printf("%5.1f -> %5.1f at 0x%08x: accelerating %u ms, total %u ms, ends at %.2f, largest frame step %.2f deg (%.0f deg/s)\n",
+         move.from, move.to, move.startAt, timeElapsed(profile.accelerationEnd(), profile.startTime()), durationMs,
+         profile.positionAt(profile.endTime()), largestStep, largestStep * 1000 / FRAME_MS);
+  CHECK(monotonic);
+  CHECK(profile.positionAt(profile.endTime()) == move.to);
+  CHECK(profile.positionAt(move.startAt) == move.from);
+  CHECK(largestStep <= peakSpeed * FRAME_MS / 1000 + TOLERANCE);
+  CHECK(profile.finishedAt(profile.endTime()));
+  CHECK(!profile.finishedAt(profile.endTime() - 1));
+}
+
+}  // namespace
+
+int main() {
+  const Move MOVES[] = {
+    { 0, 90, 1000 },
+    { 90, 0, 1000 },
+    { 0, 10, 1000 },
+    { 45, 90, 1000 },
+    { 0, 90, 0xFFFFFC00u },
+  };
+  for (const Move& move : MOVES) {
+    checkMove(move);
+  }
+
+  MotionProfile swing;
+  swing.plan(0, 90, LIMITS, 0);
+  CHECK(swing.endTime() == 1500);
+  CHECK(swing.accelerationEnd() == 500);
+
+  MotionProfile nudge;
+  nudge.plan(0, 10, LIMITS, 0);
+  CHECK(nudge.endTime() < 1500);
+  return finishChecks("motion_profile");
+}
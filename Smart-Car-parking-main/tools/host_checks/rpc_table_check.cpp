@@ -0,0 +1,94 @@
+// RPC Table Check
+// Runs access_control/rpc_table.cpp on the host against the timer wheel it
+// arms its timeouts on:
+//
+//   - a full table refuses a ninth request, and IDs wrap past 2^32 - 1
+//     without ever handing out 0, the mark of a free entry;
+//   - a reply completes its entry once, with its context and age; a second
+//     copy, an unknown ID or 0 is rejected;
+//   - every request nobody answers reaches the timeout handler exactly once,
+//     on time, and the handler may send a new request from the freed entry;
+//   - a reply that arrives after its timeout is rejected.
+//
+// Built and run by run_checks.sh (rpc_table).
+
+#include <cstdio>
+
+#include "host_check.h"
+#include "rpc_table.h"
+#include "system_state.h"
+
+TimerWheel systemTimers;
+
+namespace {
+
+unsigned long nowMs = 0;
+
+int timeouts = 0;
+int timeoutContexts = 0;  // Bit per context that timed out
+uint32_t resentId = 0;
+RpcTable* resendFrom = nullptr;
+
+void onTimeout(uint32_t id, int context) {
+  CHECK(id != 0);
+  timeouts++;
+  timeoutContexts |= 1 << context;
+  if (resendFrom != nullptr) {
+    resentId = resendFrom->add(context, 1000); // Retry from inside the handler
+    resendFrom = nullptr;
+  }
+}
+
+void advanceTo(unsigned long ms) {
+  nowMs = ms;
+  systemTimers.advance(nowMs);
+}
+
+}  // namespace
+
+unsigned long millis() { return nowMs; }
+
+int main() {
+  systemTimers.begin(0);
+  RpcTable table(onTimeout);
+  table.begin(0xFFFFFFFE);
+
+  uint32_t ids[RpcTable::SIZE];
+  for (int i = 0; i < RpcTable::SIZE; i++) {
+    ids[i] = table.add(i, 2000);
+    CHECK(ids[i] != 0);
+  }
+  CHECK(table.add(RpcTable::SIZE, 2000) == 0);
+  CHECK(table.pendingCount() == RpcTable::SIZE);
+  CHECK(ids[0] == 0xFFFFFFFE && ids[1] == 0xFFFFFFFF && ids[2] == 1);
+  printf("IDs 0x%08x, 0x%08x, %u: 0 skipped on the wrap\n", ids[0], ids[1], ids[2]);
+
+  int context = -1;
+  TimeMs elapsedMs = 0;
+  advanceTo(35);
+  CHECK(table.complete(ids[3], context, elapsedMs));
+  CHECK(context == 3 && elapsedMs == 35);
+  CHECK(!table.complete(ids[3], context, elapsedMs)); // Duplicate reply
+  CHECK(!table.complete(0, context, elapsedMs));
+  CHECK(!table.complete(12345, context, elapsedMs));
+  CHECK(table.pendingCount() == RpcTable::SIZE - 1);
+
+  advanceTo(1999);
+  CHECK(timeouts == 0);
+  resendFrom = &table;
+  advanceTo(2000);
+  printf("%d timeouts at 2000 ms, %d still pending\n", timeouts, table.pendingCount());
+  CHECK(timeouts == RpcTable::SIZE - 1);
+  CHECK(timeoutContexts == (0xFF & ~(1 << 3)));
+  CHECK(resentId == ids[RpcTable::SIZE - 1] + 1); // From an entry freed for the handler
+  CHECK(table.pendingCount() == 1);
+
+  CHECK(!table.complete(ids[0], context, elapsedMs)); // Reply after its timeout
+  advanceTo(2500);
+  CHECK(table.complete(resentId, context, elapsedMs));
+  CHECK(elapsedMs == 500);
+  advanceTo(10000);
+  CHECK(timeouts == RpcTable::SIZE - 1); // A completed request never times out
+  CHECK(table.pendingCount() == 0);
+  return finishChecks("rpc_table");
+}
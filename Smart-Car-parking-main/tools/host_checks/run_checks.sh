@@ -0,0 +1,69 @@
+#!/bin/sh
+# Builds the host checks from the firmware sources and runs them.
+# Usage:
+#   ./run_checks.sh [check ...]    # All checks, or only the ones named
+# Binaries go to $BUILD_DIR (default /tmp/host_checks).
+
+cd "$(dirname "$0")" || exit 1
+FIRMWARE=../../access_control
+BUILD_DIR=${BUILD_DIR:-/tmp/host_checks}
+CXX=${CXX:-g++}
+CXXFLAGS="-std=c++17 -O2 -Wall -Wextra -I$FIRMWARE"
+mkdir -p "$BUILD_DIR"
+
+failed=""
+ran=0
+
+# check <name> <sources and flags...>
+check() {
+  name=$1
+  shift
+  if [ -n "$SELECTED" ]; then
+    case " $SELECTED " in
+      *" $name "*) ;;
+      *) return ;;
+    esac
+  fi
+  ran=$((ran + 1))
+  echo "== $name"
+  # shellcheck disable=SC2086
+  if ! $CXX $CXXFLAGS -o "$BUILD_DIR/$name" "$@"; then
+    failed="$failed $name(build)"
+  elif ! "$BUILD_DIR/$name"; then
+    failed="$failed $name"
+  fi
+}
+
+SELECTED="$*"
+
+check heap_soak heap_soak_check.cpp -DHEAP_TRACK_HOST \
+  -Wl,--wrap=malloc,--wrap=free,--wrap=calloc,--wrap=realloc \
+  $FIRMWARE/heap_tracker.cpp $FIRMWARE/gate_lane.cpp $FIRMWARE/gate_policy.cpp \
+  $FIRMWARE/slot_monitor.cpp $FIRMWARE/sampling_rate.cpp $FIRMWARE/status_publisher.cpp \
+  $FIRMWARE/status_document.cpp $FIRMWARE/timer_wheel.cpp
+
+check timer_wheel timer_wheel_check.cpp $FIRMWARE/timer_wheel.cpp
+
+check gate_lane gate_lane_check.cpp $FIRMWARE/gate_lane.cpp $FIRMWARE/gate_policy.cpp $FIRMWARE/timer_wheel.cpp
+
+check motion_profile motion_profile_check.cpp $FIRMWARE/motion_profile.cpp
+
+check expander_bus expander_bus_check.cpp -Istubs $FIRMWARE/expander_sensor_bus.cpp
+
+check gpio_snapshot gpio_snapshot_check.cpp -Istubs $FIRMWARE/gpio_sensor_bus.cpp
+
+check ultrasonic_bus ultrasonic_bus_check.cpp -Istubs $FIRMWARE/ultrasonic_sensor_bus.cpp $FIRMWARE/timer_wheel.cpp
+
+check rpc_table rpc_table_check.cpp -Istubs $FIRMWARE/rpc_table.cpp $FIRMWARE/timer_wheel.cpp
+
+check scan_filter scan_filter_check.cpp $FIRMWARE/scan_filter.cpp
+
+if [ "$ran" -eq 0 ]; then
+  echo "No such check: $SELECTED"
+  exit 2
+fi
+if [ -n "$failed" ]; then
+  echo "FAILED:$failed"
+  exit 1
+fi
+echo "All $ran host checks passed."
@@ -0,0 +1,122 @@
+// Scan Filter Check
+// Runs access_control/scan_filter.cpp on the host with the RFID handler's
+// 3 s repeat window:
+//
+//   - a granted card held on the reader is validated again once the window
+//     from its grant has passed, however often the field flickers: repeats
+//     do not restart the window;
+//   - a scan whose validation is in flight is a repeat; a refusal or failed
+//     validation forgets it, so the next tap is validated at once;
+//   - anti-passback refuses a second entry without an exit, and the refusal
+//     keeps nothing in the repeat table;
+//   - with 200 cards churning through the 16-entry table, a repeat is only
+//     ever reported within the window of the card's last grant.
+//
+// Built and run by run_checks.sh (scan_filter).
+
+#include <cstdio>
+#include <map>
+#include <random>
+
+#include "host_check.h"
+#include "scan_filter.h"
+
+namespace {
+
+const TimeMs WINDOW_MS = 3000;
+const TimeMs PASSBACK_HOLD_MS = 12UL * 60 * 60 * 1000;
+
+CardUid card(uint8_t last) {
+  CardUid uid = { 4, { 0xDE, 0xAD, 0xBE, last } };
+  return uid;
+}
+
+void checkHeldCard() {
+  ScanFilterConfig config = { WINDOW_MS, 0 };
+  ScanFilter filter(config);
+  CardUid held = card(1);
+  int validations = 0;
+  for (TimeMs t = 0; t < 10000; t += 250) { // Held for 10 s, seen at 4 Hz
+    if (filter.check(held, PASS_IN, t) == SCAN_VALIDATE) {
+      validations++;
+      filter.recordPassage(held, PASS_IN, t);
+    }
+  }
+  printf("granted card held 10 s at 4 Hz: %d validations, %u repeats\n", validations, filter.suppressedRepeats());
+  CHECK(validations == 4); // 0, 3, 6 and 9 s
+}
+
+void checkOutcomes() {
+  ScanFilterConfig config = { WINDOW_MS, 0 };
+  ScanFilter filter(config);
+  CardUid uid = card(2);
+
+  CHECK(filter.check(uid, PASS_IN, 0) == SCAN_VALIDATE);
+  CHECK(filter.check(uid, PASS_IN, 500) == SCAN_REPEAT); // Validation in flight
+  filter.forget(uid);                                    // Denied
+  CHECK(filter.check(uid, PASS_IN, 750) == SCAN_VALIDATE);
+  filter.forget(uid);                                    // HTTP failure, RPC timeout, offline
+  CHECK(filter.check(uid, PASS_IN, 1000) == SCAN_VALIDATE);
+
+  filter.recordPassage(uid, PASS_IN, 2500);              // Granted after a slow reply
+  CHECK(filter.check(uid, PASS_IN, 5000) == SCAN_REPEAT);
+  CHECK(filter.check(uid, PASS_IN, 5499) == SCAN_REPEAT);
+  CHECK(filter.check(uid, PASS_IN, 5500) == SCAN_VALIDATE); // From the grant, not the repeats
+
+  filter.forget(card(3)); // Unknown: nothing to do
+  CHECK(filter.check(card(3), PASS_IN, 6000) == SCAN_VALIDATE);
+}
+
+void checkPassback() {
+  ScanFilterConfig config = { WINDOW_MS, PASSBACK_HOLD_MS };
+  ScanFilter filter(config);
+  CardUid uid = card(4);
+  CHECK(filter.check(uid, PASS_IN, 0) == SCAN_VALIDATE);
+  filter.recordPassage(uid, PASS_IN, 100);
+  CHECK(filter.check(uid, PASS_IN, 1000) == SCAN_REPEAT); // Still on the reader
+  CHECK(filter.check(uid, PASS_IN, 20000) == SCAN_PASSBACK);
+  CHECK(filter.check(uid, PASS_IN, 20500) == SCAN_PASSBACK); // Not held as a repeat
+  CHECK(filter.passbackRefusals() == 2);
+  CHECK(filter.check(uid, PASS_OUT, 30000) == SCAN_VALIDATE);
+  filter.recordPassage(uid, PASS_OUT, 30000);
+  CHECK(filter.check(uid, PASS_IN, 40000) == SCAN_VALIDATE);
+}
+
+void checkChurn() {
+  ScanFilterConfig config = { WINDOW_MS, 0 };
+  ScanFilter filter(config);
+  std::map<uint8_t, TimeMs> grantedAt;
+  std::mt19937 rng(1);
+  int validations = 0;
+  int earlyRepeats = 0;
+  const int SCANS = 20000;
+  for (int i = 0; i < SCANS; i++) {
+    uint8_t id = rng() % 200;
+    TimeMs now = 50000 + i * 50;
+    ScanVerdict verdict = filter.check(card(id), PASS_UNKNOWN, now);
+    if (verdict == SCAN_VALIDATE) {
+      validations++;
+      if (rng() % 4 == 0) {
+        filter.forget(card(id));
+      } else {
+        filter.recordPassage(card(id), PASS_UNKNOWN, now);
+        grantedAt[id] = now;
+      }
+    } else if (grantedAt.count(id) == 0 || timeElapsed(now, grantedAt[id]) >= WINDOW_MS) {
+      earlyRepeats++;
+    }
+  }
+  printf("churn: %d of %d scans validated, %u repeats\n", validations, SCANS, filter.suppressedRepeats());
+  CHECK(earlyRepeats == 0);
+  CHECK(validations + (int)filter.suppressedRepeats() == SCANS);
+}
+
+}  // namespace
+
+int main() {
+  checkHeldCard();
+  checkOutcomes();
+  checkPassback();
+  checkChurn();
+  return finishChecks("scan_filter");
+}
@@ -0,0 +1,28 @@
+// Host stand-in for the parts of the Arduino core that the firmware's
+// hardware backends use. Only declarations: each check defines the pin and
+// clock functions over its own model of the hardware it drives.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define LOW 0x0
+#define HIGH 0x1
+#define CHANGE 0x03
+#define IRAM_ATTR
+
+unsigned long millis();
+void delayMicroseconds(unsigned int us);
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+
+#endif
@@ -0,0 +1,10 @@
+// Host stand-in for the Arduino Wire library. Backends on the host talk to an
+// I2cBus model instead, so WireI2cBus only needs the type to exist.
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire;
+
+#endif
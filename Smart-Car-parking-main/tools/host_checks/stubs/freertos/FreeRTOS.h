@@ -0,0 +1,16 @@
+// Host stand-in for the FreeRTOS critical sections the firmware uses. The
+// checks are single-threaded, so entering one only has to compile.
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+typedef struct {
+  int owner;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+
+#endif
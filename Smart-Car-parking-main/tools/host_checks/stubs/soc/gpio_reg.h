@@ -0,0 +1,14 @@
+// Host stand-in for the ESP32 GPIO input registers. REG_READ goes to
+// hostRegRead(), which the check defines over its model of the pin levels.
+#ifndef HOST_GPIO_REG_H
+#define HOST_GPIO_REG_H
+
+#include <stdint.h>
+
+#define GPIO_IN_REG 0x3FF4403C   // Pins 0-31
+#define GPIO_IN1_REG 0x3FF44040  // Pins 32-39 in bits 0-7
+
+uint32_t hostRegRead(uint32_t reg);
+#define REG_READ(reg) hostRegRead(reg)
+
+#endif
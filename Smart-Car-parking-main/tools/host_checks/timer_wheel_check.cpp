@@ -0,0 +1,166 @@
+// Timer Wheel Check
+// Exercises access_control/timer_wheel.cpp on the host:
+//
+//   - exact-tick expiry: thousands of timers with random delays, one in ten
+//     past the wheel's 2^24 ms horizon and every seventh cancelled, must each
+//     fire exactly on its due tick, starting at 0, just before the 32-bit
+//     wrap and at an arbitrary time.
+//   - timeUntilNext(): under random arm/cancel traffic, advancing to one tick
+//     short of the predicted time must never run a timer.
+//   - cost: re-arm, cancel+arm and expiry per timer with 10k timers armed.
+//     Printed for comparison between builds, not checked; host figures only.
+//
+// Built and run by run_checks.sh (timer_wheel).
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "host_check.h"
+#include "timer_wheel.h"
+
+namespace {
+
+struct DueTimer {
+  Timer timer;
+  TimeMs due;
+};
+
+TimeMs wheelNow;
+long fires;
+long misfires;
+
+void onDue(void* context) {
+  DueTimer* timer = static_cast<DueTimer*>(context);
+  fires++;
+  if (timer->due != wheelNow) {
+    misfires++;
+  }
+}
+
+void checkExactExpiry(TimeMs start) {
+  const int TIMERS = 5000;
+  const TimeMs LONGEST = 20000000;  // Past the 2^24 ms horizon
+  std::mt19937 random(1);
+  TimerWheel wheel;
+  wheelNow = start;
+  wheel.begin(wheelNow);
+  fires = 0;
+  misfires = 0;
+
+  std::vector<DueTimer> timers(TIMERS);
+  for (int i = 0; i < TIMERS; i++) {
+    timers[i].timer = Timer(onDue, &timers[i]);
+    TimeMs delay = 1 + random() % (i % 10 == 0 ? LONGEST : 100000);
+    timers[i].due = wheelNow + delay;
+    wheel.arm(timers[i].timer, delay);
+  }
+  long cancelled = 0;
+  for (int i = 0; i < TIMERS; i += 7) {
+    wheel.cancel(timers[i].timer);
+    cancelled++;
+  }
+  for (TimeMs tick = 0; tick <= LONGEST; tick++) {
+    wheel.advance(++wheelNow);
+  }
+
+  printf("start 0x%08x: %ld fired of %ld, %ld off their tick\n", start, fires, TIMERS - cancelled, misfires);
+  CHECK(fires == TIMERS - cancelled);
+  CHECK(misfires == 0);
+  CHECK(wheel.armedCount() == 0);
+}
+
+long counted;
+
+void onCounted(void*) {
+  counted++;
+}
+
+void checkTimeUntilNext() {
+  const int TIMERS = 200;
+  std::mt19937 random(9);
+  TimerWheel wheel;
+  TimeMs now = 0xFFFF0000u;
+  wheel.begin(now);
+  static Timer timers[TIMERS];
+  for (Timer& timer : timers) {
+    timer = Timer(onCounted);
+  }
+
+  long early = 0;
+  for (int pass = 0; pass < 300000; pass++) {
+    Timer& timer = timers[random() % TIMERS];
+    uint32_t pick = random() % 100;
+    TimeMs delay = pick < 50 ? random() % 64 : pick < 80 ? random() % 5000 : pick < 95 ? random() % 300000 : random() % 20000000;
+    if (random() % 4) {
+      wheel.arm(timer, delay);
+    } else {
+      wheel.cancel(timer);
+    }
+    TimeMs sleep = wheel.timeUntilNext(1000000);
+    long before = counted;
+    if (sleep > 1) {
+      now += sleep - 1;
+      wheel.advance(now);
+    }
+    if (counted != before) {
+      early++;
+    }
+    wheel.advance(++now);
+  }
+  printf("timeUntilNext: %ld of 300000 predictions let a timer run early\n", early);
+  CHECK(early == 0);
+}
+
+double nsSince(std::chrono::steady_clock::time_point start, double count) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+}
+
+void reportCost() {
+  const int TIMERS = 10000;
+  const int ROUNDS = 100;
+  TimerWheel wheel;
+  wheel.begin(0);
+  std::vector<Timer> timers(TIMERS);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (int i = 0; i < TIMERS; i++) {
+      wheel.arm(timers[i], 1 + (i * 7919) % 60000);
+    }
+  }
+  double rearmNs = nsSince(start, double(ROUNDS) * TIMERS);
+
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (int i = 0; i < TIMERS; i++) {
+      wheel.cancel(timers[i]);
+    }
+    for (int i = 0; i < TIMERS; i++) {
+      wheel.arm(timers[i], 1 + (i * 7919) % 60000);
+    }
+  }
+  double cancelArmNs = nsSince(start, double(ROUNDS) * TIMERS);
+
+  start = std::chrono::steady_clock::now();
+  TimeMs now = 0;
+  while (wheel.armedCount() > 0) {
+    wheel.advance(++now);
+  }
+  double expireNs = nsSince(start, TIMERS);
+
+  printf("host cost with %d timers: re-arm %.1f ns, cancel+arm %.1f ns, expiry %.1f ns per timer\n", TIMERS,
+         rearmNs, cancelArmNs, expireNs);
+}
+
+}  // namespace
+
+int main() {
+  for (TimeMs start : { 0u, 0xFFFFF000u, 12345u }) {
+    checkExactExpiry(start);
+  }
+  checkTimeUntilNext();
+  reportCost();
+  return finishChecks("timer_wheel");
+}
@@ -0,0 +1,198 @@
+// Ultrasonic Bus Check
+// Runs access_control/ultrasonic_sensor_bus.cpp on the host for an hour of
+// simulated time: 24 HC-SR04s in 4 trigger groups, a car arriving at or
+// leaving a random slot every half second on average and 2 cm of noise on
+// every echo. Echo edges arrive as interrupts at the times a real sensor
+// would raise them.
+//
+//   - clean echoes: every change must be seen within worstCaseLatencyMs(),
+//     and a slot may only disagree with the car park while a change is
+//     being measured. A car that leaves and comes back before the bus has
+//     seen it go is not a change.
+//   - one echo in 200 a stray 30 cm reflection: each stray may delay a
+//     change by a round, so the bound grows by two. A single stray must not
+//     flip a slot; only two in a row can, which must leave no more than one
+//     slot sample in 10^4 false.
+//
+// Built and run by run_checks.sh (ultrasonic_bus).
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "host_check.h"
+#include "system_state.h"
+#include "ultrasonic_sensor_bus.h"
+
+TimerWheel systemTimers;
+
+namespace {
+
+const int NUM_SENSORS = 24;
+const int NUM_GROUPS = 4;
+const int NUM_PINS = 64;
+const int64_t HOUR_US = 3600LL * 1000000;
+const int64_t ECHO_DELAY_US = 450;  // Trigger to echo rising, as an HC-SR04
+const int64_t US_PER_CM = 58;
+
+// --- Host ESP32 ---
+int64_t nowUs = 0;
+void (*edgeHandlers[NUM_PINS])(void*);
+void* edgeArgs[NUM_PINS];
+
+struct Edge {
+  int64_t at;
+  int pin;
+};
+std::vector<Edge> edges;
+
+UltrasonicConfig configs[NUM_SENSORS];
+double distanceCm[NUM_SENSORS];
+int strayOneIn = 0;  // 0: no stray echoes
+std::mt19937 rng(5);
+
+}  // namespace
+
+unsigned long millis() { return nowUs / 1000; }
+
+int64_t esp_timer_get_time() { return nowUs; }
+
+void pinMode(uint8_t, uint8_t) {}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int) {
+  edgeHandlers[pin] = handler;
+  edgeArgs[pin] = arg;
+}
+
+// The falling edge of a trigger pulse pings every sensor wired to the pin.
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (value == HIGH) {
+    return;
+  }
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    if (configs[i].triggerPin != pin) {
+      continue;
+    }
+    double distance = distanceCm[i] + std::normal_distribution<double>(0, 2)(rng);
+    if (strayOneIn != 0 && rng() % strayOneIn == 0) {
+      distance = 30; // Stray reflection
+    }
+    int64_t rise = nowUs + ECHO_DELAY_US;
+    edges.push_back({ rise, configs[i].echoPin });
+    edges.push_back({ rise + (int64_t)(distance * US_PER_CM), configs[i].echoPin });
+  }
+}
+
+void delayMicroseconds(unsigned int) {}
+
+void wakeLoopFromISR() {}
+
+namespace {
+
+const int64_t ROUND_US = NUM_GROUPS * 60 * 1000;
+const int64_t BOUND_US = (2 * NUM_GROUPS + 1) * 60 * 1000; // worstCaseLatencyMs()
+
+// Runs an hour and returns the worst detection latency in ms. A slot sample
+// is false if it disagrees with a slot that has not changed for 'settleUs'.
+int64_t runHour(int strays, int64_t settleUs, long& falseStates, long& slotSamples) {
+  strayOneIn = strays;
+  edges.clear();
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    configs[i] = { 40 + i % NUM_GROUPS, 10 + i, i, 120 };
+    distanceCm[i] = 250; // Free: the floor
+  }
+  systemTimers = TimerWheel();
+  systemTimers.begin(0);
+  UltrasonicSensorBus bus(configs, NUM_SENSORS);
+  bus.begin();
+
+  OccupancyBits occupied;
+  bool actual[NUM_SENSORS] = {};
+  bool shown[NUM_SENSORS] = {};
+  int64_t changedAt[NUM_SENSORS] = {};  // Change not seen yet; 0 if none
+  int64_t toggledAt[NUM_SENSORS] = {};
+  long changes = 0;
+  long superseded = 0;  // Reversed before the bus saw it
+  long detections = 0;
+  int64_t worstUs = 0;
+  int64_t totalUs = 0;
+  falseStates = 0;
+  slotSamples = 0;
+  for (nowUs = 0; nowUs < HOUR_US; nowUs += 1000) {
+    for (size_t k = 0; k < edges.size();) {
+      if (edges[k].at <= nowUs) {
+        edgeHandlers[edges[k].pin](edgeArgs[edges[k].pin]);
+        edges.erase(edges.begin() + k);
+      } else {
+        k++;
+      }
+    }
+    systemTimers.advance(millis());
+    if (nowUs % 10000 != 0) {
+      continue;
+    }
+
+    if (rng() % 50 == 0) {
+      int i = rng() % NUM_SENSORS;
+      actual[i] = !actual[i];
+      distanceCm[i] = actual[i] ? 60 + rng() % 40 : 250;
+      toggledAt[i] = nowUs;
+      if (changedAt[i] != 0) {
+        superseded += 2; // This change and the one it undoes
+        changedAt[i] = 0;
+      } else {
+        changedAt[i] = nowUs;
+      }
+      changes++;
+    }
+    bus.sample(occupied);
+    for (int i = 0; i < NUM_SENSORS; i++) {
+      bool now = occupied.test(i);
+      if (nowUs <= 2000000) {
+        shown[i] = now; // First readings
+        continue;
+      }
+      slotSamples++;
+      if (now != shown[i] && now == actual[i] && changedAt[i] != 0) {
+        int64_t latency = nowUs - changedAt[i];
+        worstUs = latency > worstUs ? latency : worstUs;
+        totalUs += latency;
+        detections++;
+        changedAt[i] = 0;
+      }
+      if (now != actual[i] && nowUs - toggledAt[i] > settleUs) {
+        falseStates++;
+      }
+      shown[i] = now;
+    }
+  }
+
+  long inFlight = 0;
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    inFlight += changedAt[i] != 0;
+  }
+  printf("%s: %ld changes, %ld detected, mean latency %lld ms, worst %lld ms (bound %u ms), "
+         "%u measurements, %u timeouts, %ld of %ld slot samples false\n",
+         strays ? "stray echoes" : "clean echoes", changes, detections,
+         (long long)(detections ? totalUs / detections / 1000 : 0), (long long)(worstUs / 1000),
+         bus.worstCaseLatencyMs(), bus.measurementCount(), bus.timeoutCount(), falseStates, slotSamples);
+  CHECK(changes > 0);
+  CHECK(detections + superseded + inFlight == changes);
+  CHECK(inFlight <= NUM_SENSORS);
+  CHECK(bus.timeoutCount() == 0);
+  return worstUs / 1000;
+}
+
+}  // namespace
+
+int main() {
+  long falseStates = 0;
+  long slotSamples = 0;
+  CHECK(runHour(0, BOUND_US, falseStates, slotSamples) <= BOUND_US / 1000);
+  CHECK(falseStates == 0);
+  const int64_t STRAY_BOUND_US = BOUND_US + 2 * ROUND_US;
+  int64_t worstMs = runHour(200, STRAY_BOUND_US, falseStates, slotSamples);
+  CHECK(worstMs <= STRAY_BOUND_US / 1000);
+  CHECK(falseStates * 10000 <= slotSamples);
+  return finishChecks("ultrasonic_bus");
+}
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+Latency Collector for the ESP32 Access Controller
+Subscribes to the slot status, trace and ack topics, joins them by trace ID and
+prints per-stage latency histograms:
+
+  detect     sensor GPIO edge -> poll in handleSlots()
+  queue      poll -> publishSlotStatus() entered
+  serialize  JSON document built and serialized
+  transmit   mqttClient.publish() handing the payload to the socket
+  broker     publish on the ESP32 -> delivery to this collector
+  total      sensor edge -> delivery to this collector
+  actuate    door_open received -> servo commanded
+
+'broker' and 'total' compare the ESP32 clock with this machine's clock, so
+both must be NTP-synchronised (the ESP32 reports whether it is).
+
+Usage:
+  python3 latency_collector.py --user USER --password PASS
+  python3 latency_collector.py --broker localhost --port 1883 --no-tls
+"""
+
+import argparse
+import json
+import ssl
+import threading
+import time
+
+import paho.mqtt.client as mqtt
+
+STATUS_TOPIC = "parking/esp32/status"
+TRACE_TOPIC = "parking/esp32/trace"
+ACK_TOPIC = "parking/esp32/ack"
+DEFAULT_BROKER = "344221df652946139079042b380d50c9.s1.eu.hivemq.cloud"
+
+STAGES = ["detect", "queue", "serialize", "transmit", "broker", "total", "actuate"]
+PENDING_TIMEOUT_S = 60
+
+
+class Histogram:
+    """Latency samples in microseconds, reported with power-of-two buckets"""
+
+    def __init__(self):
+        self.samples = []
+
+    def add(self, value_us):
+        self.samples.append(max(0, value_us))
+
+    def percentile(self, fraction):
+        ordered = sorted(self.samples)
+        index = min(len(ordered) - 1, int(fraction * len(ordered)))
+        return ordered[index]
+
+    def report(self, name):
+        if not self.samples:
+            return f"  {name:10} (no samples)"
+        lines = [f"  {name:10} n={len(self.samples):<6} "
+                 f"p50={self.percentile(0.50) / 1000:8.2f}ms "
+                 f"p90={self.percentile(0.90) / 1000:8.2f}ms "
+                 f"p99={self.percentile(0.99) / 1000:8.2f}ms "
+                 f"max={max(self.samples) / 1000:8.2f}ms"]
+        buckets = {}
+        for value in self.samples:
+            bucket = max(1, int(value)).bit_length()
+            buckets[bucket] = buckets.get(bucket, 0) + 1
+        peak = max(buckets.values())
+        for bucket in sorted(buckets):
+            upper_ms = (1 << bucket) / 1000
+            bar = "#" * max(1, 40 * buckets[bucket] // peak)
+            lines.append(f"      < {upper_ms:10.3f}ms {buckets[bucket]:6} {bar}")
+        return "\n".join(lines)
+
+
+class LatencyCollector:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.histograms = {stage: Histogram() for stage in STAGES}
+        self.pending = {}  # trace id -> {"receivedUs": ..., "trace": {...}, "seen": ...}
+        self.unsynced = 0
+
+    def on_message(self, client, userdata, msg):
+        now_us = time.time_ns() // 1000
+        try:
+            doc = json.loads(msg.payload)
+        except ValueError:
+            return  # Not a JSON document
+        with self.lock:
+            if msg.topic == STATUS_TOPIC:
+                trace_id = doc.get("trace", {}).get("id")
+                if trace_id is not None:
+                    self._merge(trace_id, "receivedUs", now_us)
+            elif msg.topic == TRACE_TOPIC:
+                if doc.get("kind") == "slot":
+                    self._merge(doc["id"], "trace", doc)
+            elif msg.topic == ACK_TOPIC:
+                if doc.get("result") == "ok":
+                    self.histograms["actuate"].add(doc["actuatedUs"] - doc["receivedUs"])
+            self._expire()
+
+    def _merge(self, trace_id, key, value):
+        entry = self.pending.setdefault(trace_id, {"seen": time.time()})
+        entry[key] = value
+        if "receivedUs" in entry and "trace" in entry:
+            del self.pending[trace_id]
+            self._record(entry["trace"], entry["receivedUs"])
+
+    def _record(self, trace, received_us):
+        h = self.histograms
+        h["detect"].add(trace["detectUs"] - trace["edgeUs"])
+        h["queue"].add(trace["publishUs"] - trace["detectUs"])
+        h["serialize"].add(trace["serializedUs"] - trace["publishUs"])
+        h["transmit"].add(trace["sentUs"] - trace["serializedUs"])
+        if trace.get("synced"):
+            h["broker"].add(received_us - trace["sentUs"])
+            h["total"].add(received_us - trace["edgeUs"])
+        else:
+            self.unsynced += 1
+
+    def _expire(self):
+        cutoff = time.time() - PENDING_TIMEOUT_S
+        for trace_id in [k for k, v in self.pending.items() if v["seen"] < cutoff]:
+            del self.pending[trace_id]
+
+    def report(self):
+        with self.lock:
+            print("\n" + "=" * 70)
+            print(f" Latency by stage ({time.strftime('%H:%M:%S')})")
+            print("=" * 70)
+            for stage in STAGES:
+                print(self.histograms[stage].report(stage))
+            if self.unsynced:
+                print(f"  ({self.unsynced} traces from an unsynced ESP32 clock "
+                      "left out of broker/total)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Collect slot and door latency traces")
+    parser.add_argument("--broker", default=DEFAULT_BROKER)
+    parser.add_argument("--port", type=int, default=8883)
+    parser.add_argument("--user")
+    parser.add_argument("--password")
+    parser.add_argument("--no-tls", action="store_true", help="plain TCP, e.g. a local broker")
+    parser.add_argument("--interval", type=int, default=30, help="seconds between reports")
+    args = parser.parse_args()
+
+    collector = LatencyCollector()
+    client = mqtt.Client(client_id=f"latency-collector-{int(time.time())}")
+    if args.user:
+        client.username_pw_set(args.user, args.password)
+    if not args.no_tls:
+        client.tls_set(cert_reqs=ssl.CERT_NONE)
+        client.tls_insecure_set(True)
+    client.on_connect = lambda c, u, f, rc: c.subscribe(
+        [(STATUS_TOPIC, 0), (TRACE_TOPIC, 0), (ACK_TOPIC, 0)])
+    client.on_message = collector.on_message
+
+    client.connect(args.broker, args.port, keepalive=60)
+    client.loop_start()
+    print(f"Collecting traces from {args.broker}:{args.port} (Ctrl+C to stop)")
+    try:
+        while True:
+            time.sleep(args.interval)
+            collector.report()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        client.loop_stop()
+        collector.report()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""
+Power Mode Latency Model for the ESP32 Access Controller
+Simulates an hour of the main loop in each POWER_MODE (access_control/power.h)
+on a quiet lot and measures what each mode costs in latency:
+
+  cmd        MQTT command reaches the AP -> the loop handles it. In modem and
+             light sleep the radio only hears the AP every listen_interval
+             beacons, so the command waits there first.
+  gpio edge  direct GPIO sensor edge -> the loop sees it. Edge interrupts
+             wake the loop at once, but cannot wake light sleep: the edge
+             waits for the next scheduled sample.
+  wake line  expander INT / RFID IRQ goes low -> the loop sees it.
+
+The loop idles until its next timer deadline (slot sampling every slowMs on
+a quiet lot, telemetry every 10 s), at most the mode's idle cap, and a pass
+takes 0.3 ms. Commands arrive at uniformly random times. These are the
+figures quoted in power.h:
+
+  performance  loop wakes/s  100.0  cmd mean/p99/max    5.1/  10.2/  10.3 ms  gpio edge mean/max    0.3/   0.3  wake line 0.3
+  modem        loop wakes/s   20.0  cmd mean/p99/max  177.4/ 339.2/ 355.5 ms  gpio edge mean/max    0.3/   0.3  wake line 0.3
+  light        loop wakes/s   10.0  cmd mean/p99/max  205.4/ 383.6/ 407.3 ms  gpio edge mean/max  101.1/ 201.0  wake line 1.3
+
+Usage:
+  python3 power_sim.py
+  python3 power_sim.py --commands 100000 --seed 1
+"""
+
+import argparse
+import bisect
+import random
+
+BEACON_MS = 102.4          # AP beacon interval
+LISTEN_INTERVAL = 3        # POWER_LISTEN_INTERVAL
+SAMPLE_SLOW_MS = 200.0     # SamplingRate slowMs on a quiet lot
+TELEMETRY_MS = 10000.0
+LOOP_PASS_MS = 0.3
+RESUME_MS = 1.0            # Light sleep wake-up
+HOUR_MS = 3600e3
+
+MODES = {
+    "performance": dict(cap=10, listen=0, light=False),
+    "modem": dict(cap=50, listen=LISTEN_INTERVAL, light=False),
+    "light": dict(cap=100, listen=LISTEN_INTERVAL, light=True),
+}
+
+
+def loop_wakes(cap):
+    """Return the times the loop runs: at each deadline, at most cap apart"""
+    t = 0.0
+    wakes = []
+    next_sample = SAMPLE_SLOW_MS
+    next_telemetry = TELEMETRY_MS
+    while t < HOUR_MS:
+        t = min(t + cap, next_sample, next_telemetry) + LOOP_PASS_MS
+        wakes.append(t)
+        if t >= next_sample:
+            next_sample += SAMPLE_SLOW_MS
+        if t >= next_telemetry:
+            next_telemetry += TELEMETRY_MS
+    return wakes
+
+
+def first_after(times, x):
+    i = bisect.bisect_left(times, x)
+    return times[i] if i < len(times) else times[-1]
+
+
+def summary(values):
+    """Return (mean, p99, max)"""
+    values = sorted(values)
+    return sum(values) / len(values), values[int(len(values) * 0.99)], values[-1]
+
+
+def simulate(name, mode, commands):
+    wakes = loop_wakes(mode["cap"])
+    samples = [k * SAMPLE_SLOW_MS for k in range(1, int(HOUR_MS / SAMPLE_SLOW_MS))]
+    resume = RESUME_MS if mode["light"] else 0.0
+    cmd, edge, line = [], [], []
+    for _ in range(commands):
+        arrival = random.uniform(1000, HOUR_MS - 2000)
+        received = arrival
+        if mode["listen"]:
+            period = BEACON_MS * mode["listen"]
+            received = (int(arrival / period) + 1) * period
+        cmd.append(first_after(wakes, received) + resume - arrival)
+        if mode["light"]:
+            edge.append(first_after(samples, arrival) + RESUME_MS - arrival)
+        else:
+            edge.append(LOOP_PASS_MS)
+        line.append(resume + LOOP_PASS_MS)
+    cmd_mean, cmd_p99, cmd_max = summary(cmd)
+    edge_mean, _, edge_max = summary(edge)
+    print(f"{name:12s} loop wakes/s {len(wakes) / 3600:6.1f}"
+          f"  cmd mean/p99/max {cmd_mean:6.1f}/{cmd_p99:6.1f}/{cmd_max:6.1f} ms"
+          f"  gpio edge mean/max {edge_mean:6.1f}/{edge_max:6.1f}"
+          f"  wake line {summary(line)[0]:.1f}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Model loop latency in each power mode")
+    parser.add_argument("--commands", type=int, default=20000, help="commands per mode")
+    parser.add_argument("--seed", type=int, default=7)
+    args = parser.parse_args()
+
+    random.seed(args.seed)
+    for name, mode in MODES.items():
+        simulate(name, mode, args.commands)
+
+
+if __name__ == "__main__":
+    main()
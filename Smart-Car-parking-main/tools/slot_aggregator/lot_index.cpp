@@ -0,0 +1,134 @@
+#include "lot_index.h"
+
+#include <cstdlib>
+#include <fstream>
+
+Lot& LotIndex::lotFor(std::string_view device) {
+  if (device.empty()) {
+    device = LEGACY_DEVICE;
+  }
+  scratch.assign(device);
+  auto found = byDevice.find(scratch);
+  if (found != byDevice.end()) {
+    return lotList[found->second];
+  }
+  byDevice.emplace(scratch, lotList.size());
+  lotList.emplace_back();
+  lotList.back().device = scratch;
+  return lotList.back();
+}
+
+const Lot* LotIndex::find(std::string_view device) const {
+  auto found = byDevice.find(std::string(device));
+  return found == byDevice.end() ? nullptr : &lotList[found->second];
+}
+
+void LotIndex::addZone(std::string_view device, std::string_view name, uint32_t first, uint32_t last) {
+  Zone zone;
+  zone.name = std::string(name);
+  zone.first = first;
+  zone.last = last;
+  zone.total = 0;
+  zone.free = 0;
+  lotFor(device).zones.push_back(zone);
+}
+
+// Slots past the old count start occupied, as unsensed slots do on the
+// controller; the full document that caused the resize then sets them.
+void LotIndex::resize(Lot& lot, uint32_t slotCount) {
+  lot.slotCount = slotCount;
+  lot.occupied.assign((slotCount + 63) / 64, ~0ull);
+  lot.freeCount = 0;
+  lot.zoneOfSlot.assign(lot.zones.empty() ? 0 : slotCount, Lot::NO_ZONE);
+  for (size_t z = 0; z < lot.zones.size(); z++) {
+    Zone& zone = lot.zones[z];
+    zone.total = 0;
+    zone.free = 0;
+    for (uint32_t number = zone.first; number <= zone.last && number <= slotCount; number++) {
+      if (lot.zoneOfSlot[number - 1] == Lot::NO_ZONE) {  // First zone wins on overlap
+        lot.zoneOfSlot[number - 1] = static_cast<uint16_t>(z);
+        zone.total++;
+      }
+    }
+  }
+}
+
+void LotIndex::set(Lot& lot, uint32_t slot, bool occupied) {
+  uint64_t& word = lot.occupied[slot >> 6];
+  uint64_t mask = 1ull << (slot & 63);
+  if (((word & mask) != 0) == occupied) {
+    return;
+  }
+  word ^= mask;
+  int change = occupied ? -1 : 1;
+  lot.freeCount += change;
+  if (!lot.zoneOfSlot.empty() && lot.zoneOfSlot[slot] != Lot::NO_ZONE) {
+    lot.zones[lot.zoneOfSlot[slot]].free += change;
+  }
+}
+
+LotIndex::Outcome LotIndex::apply(const StatusMessage& message, int64_t nowMs) {
+  Lot& lot = lotFor(message.device);
+  if (message.full) {
+    uint32_t slotCount = 0;
+    for (const SlotEntry& entry : message.entries) {
+      slotCount = entry.slot + 1 > slotCount ? entry.slot + 1 : slotCount;
+    }
+    if (slotCount != lot.slotCount || !lot.reported) {
+      resize(lot, slotCount);
+    }
+    lot.reported = true;
+    lot.stale = false;
+  } else {
+    if (!lot.reported || lot.stale) {
+      return DROPPED;
+    }
+    if (!message.hasSeq || !lot.hasSeq || message.seq != lot.seq + 1) {
+      lot.stale = true;
+      return GAP;
+    }
+    for (const SlotEntry& entry : message.entries) {
+      if (entry.slot >= lot.slotCount) {
+        lot.stale = true;  // Not the layout we know; wait for a full document
+        return GAP;
+      }
+    }
+  }
+  for (const SlotEntry& entry : message.entries) {
+    set(lot, entry.slot, entry.occupied);
+  }
+  lot.seq = message.seq;
+  lot.hasSeq = message.hasSeq;
+  lot.updatedMs = nowMs;
+  return APPLIED;
+}
+
+int loadZones(const char* path, LotIndex& index) {
+  std::ifstream file(path);
+  if (!file) {
+    return -1;
+  }
+  int added = 0;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::string_view fields[4];
+    std::string_view rest(line);
+    int count = 0;
+    while (count < 4) {
+      size_t comma = rest.find(',');
+      fields[count++] = rest.substr(0, comma);
+      if (comma == std::string_view::npos) {
+        break;
+      }
+      rest.remove_prefix(comma + 1);
+    }
+    uint32_t first = count == 4 ? strtoul(std::string(fields[2]).c_str(), nullptr, 10) : 0;
+    uint32_t last = count == 4 ? strtoul(std::string(fields[3]).c_str(), nullptr, 10) : 0;
+    if (first == 0 || last < first) {
+      continue;  // Header, comment or malformed
+    }
+    index.addZone(fields[0], fields[1], first, last);
+    added++;
+  }
+  return added;
+}
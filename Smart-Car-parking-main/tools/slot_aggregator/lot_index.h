@@ -0,0 +1,79 @@
+// Occupancy of every lot (one controller each), kept up to date from status
+// documents and cheap to query: a bit per slot, plus free counts per lot and
+// per zone that are adjusted as bits flip rather than recounted per query.
+//
+// A delta applies only on top of the document numbered one before it. After
+// a gap the lot is marked stale (its counts are those of the last applied
+// document) and deltas are dropped until the next full document, which the
+// firmware sends at least once a minute.
+#ifndef LOT_INDEX_H
+#define LOT_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "status_decoder.h"
+
+struct Zone {
+  std::string name;
+  uint32_t first;  // Slot numbers, 1-based and inclusive, as on the signs
+  uint32_t last;
+  uint32_t total;  // Of those, slots the controller reports
+  uint32_t free;
+};
+
+struct Lot {
+  std::string device;
+  uint32_t slotCount = 0;
+  uint32_t freeCount = 0;
+  std::vector<uint64_t> occupied;  // Bit per slot
+  uint32_t seq = 0;
+  bool hasSeq = false;
+  bool reported = false;  // A full document has arrived
+  bool stale = false;
+  int64_t updatedMs = 0;
+  std::vector<Zone> zones;
+  std::vector<uint16_t> zoneOfSlot;  // Index into zones, NO_ZONE outside them
+
+  static constexpr uint16_t NO_ZONE = 0xFFFF;
+
+  bool isOccupied(uint32_t slot) const { return (occupied[slot >> 6] >> (slot & 63)) & 1; }
+};
+
+class LotIndex {
+ public:
+  enum Outcome {
+    APPLIED,
+    GAP,      // Delta out of sequence: the lot is now stale
+    DROPPED,  // Delta for a lot that is stale or has not reported in full
+  };
+
+  // Adds a zone to a lot's layout; call before status documents arrive.
+  void addZone(std::string_view device, std::string_view name, uint32_t first, uint32_t last);
+
+  Outcome apply(const StatusMessage& message, int64_t nowMs);
+
+  const Lot* find(std::string_view device) const;
+  const std::vector<Lot>& lots() const { return lotList; }
+
+  // Documents from firmware without a device ID are filed under this name.
+  static constexpr const char* LEGACY_DEVICE = "legacy";
+
+ private:
+  Lot& lotFor(std::string_view device);
+  void resize(Lot& lot, uint32_t slotCount);
+  void set(Lot& lot, uint32_t slot, bool occupied);
+
+  std::vector<Lot> lotList;
+  std::unordered_map<std::string, size_t> byDevice;
+  std::string scratch;  // Lookup key, reused so a lookup does not allocate
+};
+
+// Reads "device,zone,first,last" rows (slot numbers 1-based, inclusive).
+// Returns the number of zones added, or -1 if the file cannot be read.
+int loadZones(const char* path, LotIndex& index);
+
+#endif
@@ -0,0 +1,536 @@
+// Slot Status Aggregator
+// Subscribes to the controllers' status topic for the whole fleet, keeps each lot's
+// occupancy in a LotIndex and answers dashboards over HTTP, so they poll
+// this box instead of the broker:
+//
+//   GET /lots                  {"lots":[{"device":"a0b1c2d3e4f5","free":12,"total":40,"seq":88,"stale":false,"ageMs":350},...]}
+//   GET /lots/<device>         one of those, plus "zones":[{"zone":"A","first":1,"last":20,"free":5,"total":20},...]
+//   GET /lots/<device>/free    {"device":"a0b1c2d3e4f5","free":[3,7,19]}
+//   GET /stats                 message counters
+//
+// Zones come from an optional CSV of "device,zone,first,last" rows; without
+// one each lot only has its totals. Documents from firmware older than the
+// device ID are filed under the lot "legacy".
+//
+// --format packed follows parking/esp32/status/packed instead of the JSON
+// topic: every message is then a full document of a bit per slot, which
+// costs the broker and this box a small fraction of the bytes. Only
+// controllers built with -DSLOT_STATUS_BINARY publish it.
+//
+// One thread, one epoll loop, like tools/validation_service, whose MQTT
+// client this shares. For a test run without a broker, status_feed plays the
+// broker and a fleet of controllers.
+//
+// Build (Linux, no dependencies):
+//   g++ -std=c++17 -O2 -Wall -Wextra -o slot_aggregator slot_aggregator.cpp status_decoder.cpp lot_index.cpp ../validation_service/mqtt_link.cpp
+// Usage:
+//   ./slot_aggregator --mqtt 192.168.1.10[:1883] [--port 8081] [--zones zones.csv] [--format json|packed]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../validation_service/mqtt_link.h"
+#include "lot_index.h"
+#include "status_decoder.h"
+
+namespace {
+
+// --- Configuration ---
+const char* STATUS_TOPIC = "parking/esp32/status";
+const char* PACKED_STATUS_TOPIC = "parking/esp32/status/packed";
+const uint16_t MQTT_KEEPALIVE_S = 60;
+const int MQTT_RETRY_S = 5;
+const int MQTT_CONNECT_TIMEOUT_S = 5;
+const size_t MAX_REQUEST_BYTES = 8192;  // Per connection, unanswered
+const size_t READ_BUFFER_BYTES = 256 * 1024;  // A backlog of status messages drains in few reads
+
+struct Options {
+  std::string mqttHost;
+  uint16_t mqttPort = 1883;
+  uint16_t httpPort = 8081;
+  const char* zonesPath = nullptr;
+  bool packed = false;
+};
+
+struct Counters {
+  uint64_t messages = 0;
+  uint64_t full = 0;
+  uint64_t deltas = 0;
+  uint64_t gaps = 0;
+  uint64_t dropped = 0;
+  uint64_t malformed = 0;  // Payloads that are not status documents
+  uint64_t queries = 0;
+};
+
+struct Connection {
+  std::string in;
+  std::string out;
+  bool closeWhenSent = false;
+};
+
+LotIndex lots;
+StatusMessage decoded;
+Counters counters;
+int64_t startedMs;
+
+int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void onStatus(std::string_view payload, bool packed) {
+  counters.messages++;
+  if (!(packed ? decodePackedStatus(payload, decoded) : decodeStatus(payload, decoded))) {
+    counters.malformed++;
+    return;
+  }
+  (decoded.full ? counters.full : counters.deltas)++;
+  switch (lots.apply(decoded, nowMs())) {
+    case LotIndex::GAP:
+      counters.gaps++;
+      break;
+    case LotIndex::DROPPED:
+      counters.dropped++;
+      break;
+    case LotIndex::APPLIED:
+      break;
+  }
+}
+
+// --- Queries ---
+
+void appendLotSummary(std::string& json, const Lot& lot, int64_t now) {
+  char buffer[256];
+  snprintf(buffer, sizeof(buffer),
+           "{\"device\":\"%s\",\"free\":%u,\"total\":%u,\"seq\":%u,\"stale\":%s,\"ageMs\":%lld",
+           lot.device.c_str(), lot.freeCount, lot.slotCount, lot.seq, lot.stale ? "true" : "false",
+           (long long)(now - lot.updatedMs));
+  json += buffer;
+}
+
+// Returns the HTTP status; 'json' holds the body.
+int answerQuery(std::string_view path, std::string& json) {
+  int64_t now = nowMs();
+  if (path == "/lots") {
+    json = "{\"lots\":[";
+    bool first = true;
+    for (const Lot& lot : lots.lots()) {
+      if (!lot.reported) {
+        continue;  // Zones configured, nothing heard yet
+      }
+      json += first ? "" : ",";
+      appendLotSummary(json, lot, now);
+      json += "}";
+      first = false;
+    }
+    json += "]}";
+    return 200;
+  }
+  if (path == "/stats") {
+    char buffer[320];
+    snprintf(buffer, sizeof(buffer),
+             "{\"lots\":%zu,\"messages\":%llu,\"full\":%llu,\"deltas\":%llu,\"gaps\":%llu,"
+             "\"dropped\":%llu,\"malformed\":%llu,\"queries\":%llu,\"uptimeS\":%lld}",
+             lots.lots().size(), (unsigned long long)counters.messages, (unsigned long long)counters.full,
+             (unsigned long long)counters.deltas, (unsigned long long)counters.gaps,
+             (unsigned long long)counters.dropped, (unsigned long long)counters.malformed,
+             (unsigned long long)counters.queries, (long long)((now - startedMs) / 1000));
+    json = buffer;
+    return 200;
+  }
+
+  const std::string_view prefix = "/lots/";
+  if (path.substr(0, prefix.size()) != prefix) {
+    json = "{\"error\":\"not found\"}";
+    return 404;
+  }
+  std::string_view device = path.substr(prefix.size());
+  bool freeList = false;
+  size_t slash = device.find('/');
+  if (slash != std::string_view::npos) {
+    freeList = device.substr(slash) == "/free";
+    if (!freeList) {
+      json = "{\"error\":\"not found\"}";
+      return 404;
+    }
+    device = device.substr(0, slash);
+  }
+  const Lot* lot = lots.find(device);
+  if (lot == nullptr || !lot->reported) {
+    json = "{\"error\":\"unknown device\"}";
+    return 404;
+  }
+
+  if (freeList) {
+    json = "{\"device\":\"" + lot->device + "\",\"free\":[";
+    bool first = true;
+    for (uint32_t word = 0; word < lot->occupied.size(); word++) {
+      uint64_t freeBits = ~lot->occupied[word];
+      while (freeBits != 0) {
+        uint32_t slot = word * 64 + __builtin_ctzll(freeBits);
+        freeBits &= freeBits - 1;
+        if (slot >= lot->slotCount) {
+          break;
+        }
+        json += first ? "" : ",";
+        json += std::to_string(slot + 1);
+        first = false;
+      }
+    }
+    json += "]}";
+    return 200;
+  }
+
+  json.clear();
+  appendLotSummary(json, *lot, now);
+  json += ",\"zones\":[";
+  for (size_t z = 0; z < lot->zones.size(); z++) {
+    const Zone& zone = lot->zones[z];
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer), "%s{\"zone\":\"%s\",\"first\":%u,\"last\":%u,\"free\":%u,\"total\":%u}",
+             z == 0 ? "" : ",", zone.name.c_str(), zone.first, zone.last, zone.free, zone.total);
+    json += buffer;
+  }
+  json += "]}";
+  return 200;
+}
+
+// --- HTTP ---
+
+bool headerSays(std::string_view headers, std::string_view name, std::string_view value) {
+  for (size_t at = 0; at < headers.size();) {
+    size_t end = headers.find("\r\n", at);
+    std::string_view line = headers.substr(at, end == std::string_view::npos ? end : end - at);
+    if (line.size() > name.size() && strncasecmp(line.data(), name.data(), name.size()) == 0 &&
+        line[name.size()] == ':') {
+      std::string_view rest = line.substr(name.size() + 1);
+      for (size_t i = 0; i + value.size() <= rest.size(); i++) {
+        if (strncasecmp(rest.data() + i, value.data(), value.size()) == 0) {
+          return true;
+        }
+      }
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+    at = end + 2;
+  }
+  return false;
+}
+
+void respond(Connection& connection, int status, std::string_view body) {
+  char head[200];
+  int length = snprintf(head, sizeof(head),
+                        "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n"
+                        "Cache-Control: no-store\r\n%s\r\n",
+                        status, status == 200 ? "OK" : status == 404 ? "Not Found" : "Bad Request",
+                        body.size(), connection.closeWhenSent ? "Connection: close\r\n" : "");
+  connection.out.append(head, length);
+  connection.out.append(body);
+}
+
+// Answers every complete request in the buffer. Returns false to drop the
+// connection.
+bool serveRequests(Connection& connection) {
+  std::string body;
+  for (;;) {
+    size_t end = connection.in.find("\r\n\r\n");
+    if (end == std::string::npos) {
+      return connection.in.size() <= MAX_REQUEST_BYTES;
+    }
+    std::string_view request(connection.in.data(), end + 2);
+    size_t lineEnd = request.find("\r\n");
+    std::string_view line = request.substr(0, lineEnd);
+    std::string_view headers = request.substr(lineEnd + 2);
+
+    size_t firstSpace = line.find(' ');
+    size_t secondSpace = line.find(' ', firstSpace + 1);
+    std::string_view method = line.substr(0, firstSpace);
+    std::string_view target = firstSpace == std::string_view::npos || secondSpace == std::string_view::npos
+                                  ? std::string_view()
+                                  : line.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+    std::string_view version = secondSpace == std::string_view::npos ? std::string_view()
+                                                                      : line.substr(secondSpace + 1);
+    connection.closeWhenSent = headerSays(headers, "Connection", "close") ||
+                               (version == "HTTP/1.0" && !headerSays(headers, "Connection", "keep-alive"));
+
+    if (method != "GET" || target.empty()) {
+      connection.closeWhenSent = true;
+      respond(connection, 400, "{\"error\":\"expected GET\"}");
+    } else {
+      counters.queries++;
+      std::string_view path = target.substr(0, target.find('?'));
+      int status = answerQuery(path, body);
+      respond(connection, status, body);
+    }
+    connection.in.erase(0, end + 4);
+    if (connection.closeWhenSent) {
+      connection.in.clear();
+      return true;
+    }
+  }
+}
+
+// --- Event Loop ---
+
+int listenOn(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 128) != 0) {
+    perror("listen");
+    exit(1);
+  }
+  return fd;
+}
+
+// Writes as much as the socket takes; waits for EPOLLOUT only when it is full.
+bool flush(int epollFd, int fd, std::string& out, bool& waitingForOut) {
+  while (!out.empty()) {
+    ssize_t sent = send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      return false;
+    }
+    out.erase(0, sent);
+  }
+  bool wantOut = !out.empty();
+  if (wantOut != waitingForOut) {
+    epoll_event event{};
+    event.events = EPOLLIN | (wantOut ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    event.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+    waitingForOut = wantOut;
+  }
+  return true;
+}
+
+void addToEpoll(int epollFd, int fd, uint32_t events = EPOLLIN) {
+  epoll_event event{};
+  event.events = events;
+  event.data.fd = fd;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+}
+
+Options parseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string flag = argv[i];
+    if (flag == "--mqtt") {
+      std::string broker = argv[i + 1];
+      size_t colon = broker.find(':');
+      options.mqttHost = broker.substr(0, colon);
+      if (colon != std::string::npos) {
+        options.mqttPort = static_cast<uint16_t>(atoi(broker.c_str() + colon + 1));
+      }
+    } else if (flag == "--port") {
+      options.httpPort = static_cast<uint16_t>(atoi(argv[i + 1]));
+    } else if (flag == "--zones") {
+      options.zonesPath = argv[i + 1];
+    } else if (flag == "--format") {
+      std::string format = argv[i + 1];
+      if (format != "json" && format != "packed") {
+        fprintf(stderr, "--format is json or packed\n");
+        exit(2);
+      }
+      options.packed = format == "packed";
+    } else {
+      fprintf(stderr, "unknown option %s\n", flag.c_str());
+      exit(2);
+    }
+  }
+  if (options.mqttHost.empty()) {
+    fprintf(stderr, "usage: %s --mqtt host[:1883] [--port 8081] [--zones zones.csv] [--format json|packed]\n",
+            argv[0]);
+    exit(2);
+  }
+  return options;
+}
+
+void printCounters() {
+  printf("lots %zu, messages %llu (full %llu, deltas %llu, malformed %llu), gaps %llu, dropped %llu, "
+         "queries %llu\n",
+         lots.lots().size(), (unsigned long long)counters.messages, (unsigned long long)counters.full,
+         (unsigned long long)counters.deltas, (unsigned long long)counters.malformed,
+         (unsigned long long)counters.gaps, (unsigned long long)counters.dropped,
+         (unsigned long long)counters.queries);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  Options options = parseOptions(argc, argv);
+  startedMs = nowMs();
+  if (options.zonesPath != nullptr) {
+    int zones = loadZones(options.zonesPath, lots);
+    if (zones < 0) {
+      fprintf(stderr, "cannot read %s\n", options.zonesPath);
+      return 1;
+    }
+    printf("%d zones over %zu lots from %s\n", zones, lots.lots().size(), options.zonesPath);
+  }
+
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  sigprocmask(SIG_BLOCK, &signals, nullptr);
+  int signalFd = signalfd(-1, &signals, SFD_NONBLOCK);
+
+  int epollFd = epoll_create1(0);
+  int listenFd = listenOn(options.httpPort);
+  addToEpoll(epollFd, listenFd);
+  addToEpoll(epollFd, signalFd);
+  printf("HTTP on port %u\n", options.httpPort);
+
+  const char* statusTopic = options.packed ? PACKED_STATUS_TOPIC : STATUS_TOPIC;
+  MqttLink mqtt([&](std::string_view topic, std::string_view payload) {
+    if (topic == statusTopic) {
+      onStatus(payload, options.packed);
+    }
+  });
+  bool mqttWaitingForOut = false;
+  int64_t mqttRetryAt = 0;
+  int64_t mqttConnectBy = 0;
+  int64_t mqttPingAt = 0;
+
+  std::unordered_map<int, Connection> connections;
+  std::unordered_map<int, bool> waitingForOut;
+  epoll_event events[256];
+  std::string buffer(READ_BUFFER_BYTES, '\0');
+
+  for (;;) {
+    int64_t now = nowMs();
+    if (mqtt.fd() < 0 && now >= mqttRetryAt) {
+      std::string clientId = "slot-aggregator-" + std::to_string(getpid());
+      if (mqtt.open(options.mqttHost, options.mqttPort, clientId, statusTopic, MQTT_KEEPALIVE_S) >= 0) {
+        // Writable once the connect is over, either way
+        addToEpoll(epollFd, mqtt.fd(), EPOLLIN | EPOLLOUT);
+        mqttWaitingForOut = true;
+        mqttConnectBy = now + MQTT_CONNECT_TIMEOUT_S * 1000;
+        mqttPingAt = now + MQTT_KEEPALIVE_S * 1000 / 2;
+      } else {
+        mqttRetryAt = now + MQTT_RETRY_S * 1000;
+      }
+    }
+    if (mqtt.connecting() && now >= mqttConnectBy) {
+      printf("MQTT: no answer from %s:%u, retrying in %d s\n", options.mqttHost.c_str(), options.mqttPort,
+             MQTT_RETRY_S);
+      mqtt.close();
+      mqttRetryAt = now + MQTT_RETRY_S * 1000;
+    }
+    if (mqtt.fd() >= 0 && !mqtt.connecting() && now >= mqttPingAt) {
+      mqtt.ping();
+      mqttPingAt = now + MQTT_KEEPALIVE_S * 1000 / 2;
+    }
+    if (mqtt.fd() >= 0 && !mqtt.connecting() && !mqtt.pending().empty()) {
+      std::string out = mqtt.pending();
+      bool ok = flush(epollFd, mqtt.fd(), out, mqttWaitingForOut);
+      mqtt.consumed(mqtt.pending().size() - out.size());
+      if (!ok) {
+        mqtt.close();
+        mqttRetryAt = now + MQTT_RETRY_S * 1000;
+      }
+    }
+
+    int ready = epoll_wait(epollFd, events, 256, 1000);
+    for (int e = 0; e < ready; e++) {
+      int fd = events[e].data.fd;
+
+      if (fd == listenFd) {
+        for (;;) {
+          int client = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+          if (client < 0) {
+            break;
+          }
+          int one = 1;
+          setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+          addToEpoll(epollFd, client);
+          connections[client] = Connection();
+          waitingForOut[client] = false;
+        }
+        continue;
+      }
+
+      if (fd == signalFd) {
+        printCounters();
+        return 0;
+      }
+
+      if (fd == mqtt.fd()) {
+        bool ok = true;
+        if (mqtt.connecting()) {
+          ok = mqtt.finishConnect();
+          if (ok) {
+            printf("MQTT: connected to %s:%u, following %s\n", options.mqttHost.c_str(), options.mqttPort,
+                   statusTopic);
+          }
+        } else if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+          ssize_t received = recv(fd, &buffer[0], buffer.size(), 0);
+          ok = received > 0 ? mqtt.feed(buffer.data(), received) : received < 0 && errno == EAGAIN;
+        }
+        if (ok && !mqtt.pending().empty()) {
+          std::string out = mqtt.pending();
+          ok = flush(epollFd, fd, out, mqttWaitingForOut);
+          mqtt.consumed(mqtt.pending().size() - out.size());
+        }
+        if (!ok) {
+          printf(mqtt.connecting() ? "MQTT: connect failed, retrying in %d s\n" : "MQTT: link lost, retrying in %d s\n",
+                 MQTT_RETRY_S);
+          mqtt.close();
+          mqttRetryAt = nowMs() + MQTT_RETRY_S * 1000;
+        }
+        continue;
+      }
+
+      auto found = connections.find(fd);
+      if (found == connections.end()) {
+        continue;
+      }
+      Connection& connection = found->second;
+      bool keep = true;
+      if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        ssize_t received;
+        while ((received = recv(fd, &buffer[0], buffer.size(), 0)) > 0) {
+          connection.in.append(buffer.data(), received);
+        }
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+          keep = false;
+        } else {
+          keep = serveRequests(connection);
+        }
+      }
+      if (keep) {
+        keep = flush(epollFd, fd, connection.out, waitingForOut[fd]) &&
+               !(connection.closeWhenSent && connection.out.empty());
+      }
+      if (!keep) {
+        close(fd);  // Also drops it from the epoll set
+        connections.erase(fd);
+        waitingForOut.erase(fd);
+      }
+    }
+  }
+}
@@ -0,0 +1,222 @@
+#include "status_decoder.h"
+
+namespace {
+
+class Cursor {
+ public:
+  explicit Cursor(std::string_view text) : at(text.data()), end(text.data() + text.size()) {}
+
+  void skipSpace() {
+    while (at < end && (*at == ' ' || *at == '\t' || *at == '\r' || *at == '\n')) {
+      at++;
+    }
+  }
+
+  bool consume(char c) {
+    skipSpace();
+    if (at < end && *at == c) {
+      at++;
+      return true;
+    }
+    return false;
+  }
+
+  bool peek(char c) {
+    skipSpace();
+    return at < end && *at == c;
+  }
+
+  // A string's raw contents; escapes are left as they are, which is fine for
+  // the hex and fixed words the firmware sends.
+  bool string(std::string_view& value) {
+    if (!consume('"')) {
+      return false;
+    }
+    const char* start = at;
+    while (at < end && *at != '"') {
+      at += *at == '\\' ? 2 : 1;
+    }
+    if (at >= end) {
+      return false;
+    }
+    value = std::string_view(start, at - start);
+    at++;
+    return true;
+  }
+
+  bool number(uint32_t& value) {
+    skipSpace();
+    const char* start = at;
+    uint64_t result = 0;
+    while (at < end && *at >= '0' && *at <= '9' && result <= UINT32_MAX) {
+      result = result * 10 + (*at++ - '0');
+    }
+    value = static_cast<uint32_t>(result);
+    return at > start && result <= UINT32_MAX;
+  }
+
+  // Any value, nested or not.
+  bool skipValue() {
+    skipSpace();
+    if (at >= end) {
+      return false;
+    }
+    if (*at == '"') {
+      std::string_view ignored;
+      return string(ignored);
+    }
+    if (*at == '{' || *at == '[') {
+      int depth = 0;
+      while (at < end) {
+        char c = *at;
+        if (c == '"') {
+          std::string_view ignored;
+          if (!string(ignored)) {
+            return false;
+          }
+          continue;
+        }
+        at++;
+        if (c == '{' || c == '[') {
+          depth++;
+        } else if ((c == '}' || c == ']') && --depth == 0) {
+          return true;
+        }
+      }
+      return false;
+    }
+    const char* start = at;  // Number, true, false or null
+    while (at < end && *at != ',' && *at != '}' && *at != ']') {
+      at++;
+    }
+    return at > start;
+  }
+
+ private:
+  const char* at;
+  const char* end;
+};
+
+// {"slotNumber":3,"status":"occupied"}, keys in any order.
+bool slotEntry(Cursor& cursor, SlotEntry& entry) {
+  if (!cursor.consume('{')) {
+    return false;
+  }
+  uint32_t number = 0;
+  bool haveNumber = false;
+  bool haveStatus = false;
+  while (!cursor.consume('}')) {
+    std::string_view key;
+    if (!cursor.string(key) || !cursor.consume(':')) {
+      return false;
+    }
+    if (key == "slotNumber") {
+      haveNumber = cursor.number(number) && number > 0;
+    } else if (key == "status") {
+      std::string_view status;
+      if (!cursor.string(status)) {
+        return false;
+      }
+      entry.occupied = status == "occupied";
+      haveStatus = entry.occupied || status == "available";
+    } else if (!cursor.skipValue()) {
+      return false;
+    }
+    cursor.consume(',');
+  }
+  entry.slot = number - 1;
+  return haveNumber && haveStatus;
+}
+
+bool slotArray(Cursor& cursor, std::vector<SlotEntry>& entries) {
+  if (!cursor.consume('[')) {
+    return false;
+  }
+  while (!cursor.consume(']')) {
+    SlotEntry entry;
+    if (!slotEntry(cursor, entry)) {
+      return false;
+    }
+    entries.push_back(entry);
+    cursor.consume(',');
+  }
+  return true;
+}
+
+uint32_t littleEndian(const uint8_t* bytes, int count) {
+  uint32_t value = 0;
+  for (int i = count - 1; i >= 0; i--) {
+    value = value << 8 | bytes[i];
+  }
+  return value;
+}
+
+}  // namespace
+
+bool decodeStatus(std::string_view payload, StatusMessage& message) {
+  message.device = std::string_view();
+  message.seq = 0;
+  message.hasSeq = false;
+  message.entries.clear();
+  bool haveSlots = false;
+
+  Cursor cursor(payload);
+  if (!cursor.consume('{')) {
+    return false;
+  }
+  while (!cursor.consume('}')) {
+    std::string_view key;
+    if (!cursor.string(key) || !cursor.consume(':')) {
+      return false;
+    }
+    if (key == "device") {
+      if (!cursor.string(message.device)) {
+        return false;
+      }
+    } else if (key == "seq") {
+      if (!cursor.number(message.seq)) {
+        return false;
+      }
+      message.hasSeq = true;
+    } else if (key == "slots" || key == "changes") {
+      if (haveSlots || !slotArray(cursor, message.entries)) {
+        return false;
+      }
+      message.full = key == "slots";
+      haveSlots = true;
+    } else if (!cursor.skipValue()) {
+      return false;
+    }
+    if (!cursor.consume(',') && !cursor.peek('}')) {
+      return false;
+    }
+  }
+  return haveSlots;
+}
+
+// version(1) flags(1) seq(4) traceId(4) slotCount(2) deviceLength(1) device
+// occupied((slotCount + 7) / 8) sensed((slotCount + 7) / 8). Slots without a
+// sensor are set in 'occupied' as well, as they are listed in JSON.
+bool decodePackedStatus(std::string_view payload, StatusMessage& message) {
+  const size_t HEADER_BYTES = 13;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(payload.data());
+  if (payload.size() < HEADER_BYTES || bytes[0] != 1) {
+    return false;
+  }
+  uint32_t slotCount = littleEndian(bytes + 10, 2);
+  size_t deviceLength = bytes[12];
+  size_t bitsetBytes = (slotCount + 7) / 8;
+  if (payload.size() != HEADER_BYTES + deviceLength + 2 * bitsetBytes) {
+    return false;
+  }
+  message.device = payload.substr(HEADER_BYTES, deviceLength);
+  message.seq = littleEndian(bytes + 2, 4);
+  message.hasSeq = true;
+  message.full = true;
+  message.entries.clear();
+  const uint8_t* occupied = bytes + HEADER_BYTES + deviceLength;
+  for (uint32_t slot = 0; slot < slotCount; slot++) {
+    message.entries.push_back({slot, ((occupied[slot >> 3] >> (slot & 7)) & 1) != 0});
+  }
+  return true;
+}
@@ -0,0 +1,41 @@
+// Decoder for the controllers' parking/esp32/status documents (see
+// streamSlotStatus() in access_control/network_handler.cpp):
+//
+//   full   {"device":"a0b1c2d3e4f5","seq":41,"slots":[{"slotNumber":1,"status":"occupied"},...],"trace":{"id":7}}
+//   delta  {"device":"a0b1c2d3e4f5","seq":42,"changes":[{"slotNumber":3,"status":"available"}],"trace":{"id":8}}
+//
+// Firmware from before device IDs sends only "slots" and "trace"; those
+// documents decode with an empty device and no sequence number. This is a
+// single pass over the bytes with no allocation once 'entries' has grown,
+// not a general JSON parser: unknown keys are skipped, whatever their value.
+//
+// The packed encoding of the same document, on parking/esp32/status/packed,
+// is a header and a bit per slot (see access_control/status_document.h). It
+// is always full and decodes to an entry for every slot.
+#ifndef STATUS_DECODER_H
+#define STATUS_DECODER_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+struct SlotEntry {
+  uint32_t slot;  // 0-based; the document numbers slots from 1
+  bool occupied;
+};
+
+struct StatusMessage {
+  std::string_view device;  // Points into the payload
+  uint32_t seq;
+  bool hasSeq;
+  bool full;  // "slots" rather than "changes"
+  std::vector<SlotEntry> entries;
+};
+
+// Returns false if the payload is not a status document.
+bool decodeStatus(std::string_view payload, StatusMessage& message);
+
+// Returns false if the payload is not a version 1 packed document.
+bool decodePackedStatus(std::string_view payload, StatusMessage& message);
+
+#endif
@@ -0,0 +1,264 @@
+// Broker stand-in for testing slot_aggregator without a broker or hardware.
+// Listens like an MQTT broker, accepts one subscriber, and pushes it the
+// status traffic of a simulated fleet as fast as it reads: each controller
+// sends one full document, then deltas of one or two slots with a full
+// document every --keyframe messages. --drop loses a share of the deltas on the way, as a flaky
+// uplink would, to exercise gap handling.
+//
+// When done it sends every controller's final state in full, closes its side
+// and waits for the subscriber to hang up, so the reported rate is the rate
+// the subscriber consumed at. It then prints the free-slot total the
+// aggregator should now report (sum of "free" over GET /lots).
+//
+// Build:
+//   g++ -std=c++17 -O2 -Wall -Wextra -o status_feed status_feed.cpp
+// Usage:
+//   ./status_feed [--port 1883] [--devices 1000] [--slots 200] [--messages 2000000]
+//                 [--keyframe 100] [--drop 0.001]
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* STATUS_TOPIC = "parking/esp32/status";
+const size_t SEND_BATCH_BYTES = 64 * 1024;
+
+struct Options {
+  uint16_t port = 1883;
+  int devices = 1000;
+  int slots = 200;
+  long messages = 2000000;
+  int keyframe = 100;
+  double drop = 0.0;
+};
+
+struct Device {
+  char id[13];
+  uint32_t seq = 0;
+  std::vector<bool> occupied;
+  int sinceFull = 0;
+};
+
+void appendPublish(std::string& out, const std::string& payload) {
+  size_t topicLength = strlen(STATUS_TOPIC);
+  size_t remaining = 2 + topicLength + payload.size();
+  out.push_back(0x30);
+  do {
+    uint8_t digit = remaining % 128;
+    remaining /= 128;
+    out.push_back(static_cast<char>(remaining > 0 ? digit | 0x80 : digit));
+  } while (remaining > 0);
+  out.push_back(static_cast<char>(topicLength >> 8));
+  out.push_back(static_cast<char>(topicLength & 0xFF));
+  out.append(STATUS_TOPIC);
+  out.append(payload);
+}
+
+void appendEntry(std::string& json, int slot, bool occupied, bool first) {
+  char entry[64];
+  snprintf(entry, sizeof(entry), "%s{\"slotNumber\":%d,\"status\":\"%s\"}", first ? "" : ",", slot + 1,
+           occupied ? "occupied" : "available");
+  json += entry;
+}
+
+// The same documents streamSlotStatus() writes.
+std::string statusDocument(Device& device, const std::vector<int>* changed, uint32_t traceId) {
+  char head[80];
+  snprintf(head, sizeof(head), "{\"device\":\"%s\",\"seq\":%u,\"%s\":[", device.id, ++device.seq,
+           changed == nullptr ? "slots" : "changes");
+  std::string json = head;
+  if (changed == nullptr) {
+    for (size_t slot = 0; slot < device.occupied.size(); slot++) {
+      appendEntry(json, slot, device.occupied[slot], slot == 0);
+    }
+  } else {
+    for (size_t i = 0; i < changed->size(); i++) {
+      appendEntry(json, (*changed)[i], device.occupied[(*changed)[i]], i == 0);
+    }
+  }
+  json += "],\"trace\":{\"id\":" + std::to_string(traceId) + "}}";
+  return json;
+}
+
+void sendAll(int fd, std::string& out) {
+  size_t at = 0;
+  while (at < out.size()) {
+    ssize_t sent = send(fd, out.data() + at, out.size() - at, MSG_NOSIGNAL);
+    if (sent <= 0) {
+      fprintf(stderr, "subscriber went away\n");
+      exit(1);
+    }
+    at += sent;
+  }
+  out.clear();
+}
+
+// Reads until the subscriber's CONNECT and SUBSCRIBE have both arrived
+// (they come back to back), then acknowledges them.
+void handshake(int fd) {
+  std::string in;
+  char buffer[512];
+  int packets = 0;
+  while (packets < 2) {
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    if (received <= 0) {
+      fprintf(stderr, "subscriber hung up during the handshake\n");
+      exit(1);
+    }
+    in.append(buffer, received);
+    while (in.size() >= 2 && static_cast<uint8_t>(in[1]) < 128 &&
+           in.size() >= 2 + static_cast<size_t>(in[1])) {
+      uint8_t type = static_cast<uint8_t>(in[0]) & 0xF0;
+      std::string reply;
+      if (type == 0x10) {
+        reply = std::string("\x20\x02\x00\x00", 4);
+      } else if (type == 0x80) {
+        reply = std::string("\x90\x03", 2) + in.substr(2, 2) + std::string(1, '\0');
+      }
+      send(fd, reply.data(), reply.size(), MSG_NOSIGNAL);
+      in.erase(0, 2 + static_cast<uint8_t>(in[1]));
+      packets++;
+    }
+  }
+}
+
+Options parseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string flag = argv[i];
+    const char* value = argv[i + 1];
+    if (flag == "--port") {
+      options.port = static_cast<uint16_t>(atoi(value));
+    } else if (flag == "--devices") {
+      options.devices = atoi(value);
+    } else if (flag == "--slots") {
+      options.slots = atoi(value);
+    } else if (flag == "--messages") {
+      options.messages = atol(value);
+    } else if (flag == "--keyframe") {
+      options.keyframe = atoi(value);
+    } else if (flag == "--drop") {
+      options.drop = atof(value);
+    } else {
+      fprintf(stderr, "unknown option %s\n", flag.c_str());
+      exit(2);
+    }
+  }
+  if (options.devices < 1 || options.slots < 2 || options.keyframe < 1) {
+    fprintf(stderr, "--devices, --slots and --keyframe must be positive\n");
+    exit(2);
+  }
+  return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options = parseOptions(argc, argv);
+  std::mt19937 random(7);
+  std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+  std::vector<Device> fleet(options.devices);
+  for (int d = 0; d < options.devices; d++) {
+    snprintf(fleet[d].id, sizeof(fleet[d].id), "5ca1ab%06x", d & 0xFFFFFF);
+    fleet[d].occupied.resize(options.slots);
+    for (int slot = 0; slot < options.slots; slot++) {
+      fleet[d].occupied[slot] = coin(random) < 0.6;
+    }
+  }
+
+  int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(options.port);
+  if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listenFd, 1) != 0) {
+    perror("listen");
+    return 1;
+  }
+  printf("waiting for a subscriber on port %u\n", options.port);
+  fflush(stdout);
+  int fd = accept(listenFd, nullptr, nullptr);
+  handshake(fd);
+
+  auto start = std::chrono::steady_clock::now();
+  std::string out;
+  long sent = 0;
+  long dropped = 0;
+  long full = 0;
+  uint32_t traceId = 0;
+  auto emit = [&](Device& device, const std::vector<int>* changed) {
+    std::string document = statusDocument(device, changed, ++traceId);
+    if (changed != nullptr && coin(random) < options.drop) {
+      dropped++;  // Lost in transit: the sequence number is used up all the same
+      return;
+    }
+    appendPublish(out, document);
+    sent++;
+    if (out.size() >= SEND_BATCH_BYTES) {
+      sendAll(fd, out);
+    }
+  };
+
+  for (Device& device : fleet) {
+    emit(device, nullptr);
+    full++;
+  }
+  std::vector<int> changed;
+  for (long m = options.devices; m < options.messages; m++) {
+    Device& device = fleet[random() % fleet.size()];
+    if (++device.sinceFull >= options.keyframe) {
+      device.sinceFull = 0;
+      emit(device, nullptr);
+      full++;
+      continue;
+    }
+    changed.clear();
+    changed.push_back(random() % options.slots);
+    if (coin(random) < 0.2) {  // Two cars in the same sampling interval
+      int second = random() % options.slots;
+      if (second != changed[0]) {
+        changed.push_back(second);
+      }
+    }
+    std::sort(changed.begin(), changed.end());
+    for (int slot : changed) {
+      device.occupied[slot] = !device.occupied[slot];
+    }
+    emit(device, &changed);
+  }
+  for (Device& device : fleet) {
+    emit(device, nullptr);  // Brings lots that lost a delta back in step
+    full++;
+  }
+  sendAll(fd, out);
+  shutdown(fd, SHUT_WR);
+  char buffer[256];
+  while (recv(fd, buffer, sizeof(buffer), 0) > 0) {
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  long expectedFree = 0;
+  for (const Device& device : fleet) {
+    for (bool occupied : device.occupied) {
+      expectedFree += !occupied;
+    }
+  }
+  printf("%ld status messages (%ld full, %ld deltas dropped) to %d lots in %.2f s: %.0f msg/s\n",
+         sent, full, dropped, options.devices, seconds, sent / seconds);
+  printf("expected free total %ld\n", expectedFree);
+  return 0;
+}
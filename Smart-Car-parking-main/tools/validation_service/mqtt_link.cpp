@@ -0,0 +1,182 @@
+#include "mqtt_link.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace {
+const uint8_t MQTT_CONNECT = 0x10;
+const uint8_t MQTT_CONNACK = 0x20;
+const uint8_t MQTT_PUBLISH = 0x30;
+const uint8_t MQTT_SUBSCRIBE = 0x82;  // Reserved flags 0010
+const uint8_t MQTT_SUBACK = 0x90;
+const uint8_t MQTT_PINGREQ = 0xC0;
+const uint8_t MQTT_PINGRESP = 0xD0;
+}  // namespace
+
+MqttLink::MqttLink(MessageHandler onMessage)
+    : handler(std::move(onMessage)), socketFd(-1), tcpConnecting(false), acknowledged(false) {}
+
+void MqttLink::appendString(std::string& out, std::string_view text) {
+  out.push_back(static_cast<char>(text.size() >> 8));
+  out.push_back(static_cast<char>(text.size() & 0xFF));
+  out.append(text);
+}
+
+void MqttLink::queuePacket(uint8_t header, const std::string& body) {
+  outgoing.push_back(static_cast<char>(header));
+  size_t remaining = body.size();
+  do {  // Variable-length "remaining length"
+    uint8_t digit = remaining % 128;
+    remaining /= 128;
+    outgoing.push_back(static_cast<char>(remaining > 0 ? digit | 0x80 : digit));
+  } while (remaining > 0);
+  outgoing.append(body);
+}
+
+int MqttLink::open(const std::string& host, uint16_t port, const std::string& clientId,
+                   const std::string& subscribeTopic, uint16_t keepAliveSeconds) {
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) {
+    return -1;
+  }
+  // The broker is normally given as an address, so the lookup does not
+  // block; the connect must not either, or a broker that is down would
+  // stall every HTTP client until the SYN times out.
+  tcpConnecting = false;
+  for (addrinfo* address = result; address != nullptr && socketFd < 0; address = address->ai_next) {
+    socketFd = socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK, address->ai_protocol);
+    if (socketFd < 0) {
+      continue;
+    }
+    if (connect(socketFd, address->ai_addr, address->ai_addrlen) != 0) {
+      if (errno == EINPROGRESS) {
+        tcpConnecting = true;
+      } else {
+        ::close(socketFd);
+        socketFd = -1;
+      }
+    }
+  }
+  freeaddrinfo(result);
+  if (socketFd < 0) {
+    return -1;
+  }
+  int one = 1;
+  setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  incoming.clear();
+  outgoing.clear();
+  acknowledged = false;
+
+  std::string connectBody;
+  appendString(connectBody, "MQTT");
+  connectBody.push_back(4);     // Protocol level 3.1.1
+  connectBody.push_back(0x02);  // Clean session
+  connectBody.push_back(static_cast<char>(keepAliveSeconds >> 8));
+  connectBody.push_back(static_cast<char>(keepAliveSeconds & 0xFF));
+  appendString(connectBody, clientId);
+  queuePacket(MQTT_CONNECT, connectBody);
+
+  std::string subscribeBody;
+  subscribeBody.push_back(0);
+  subscribeBody.push_back(1);  // Packet identifier
+  appendString(subscribeBody, subscribeTopic);
+  subscribeBody.push_back(0);  // QoS 0
+  queuePacket(MQTT_SUBSCRIBE, subscribeBody);
+  return socketFd;
+}
+
+bool MqttLink::finishConnect() {
+  int error = 0;
+  socklen_t length = sizeof(error);
+  if (getsockopt(socketFd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+    return false;
+  }
+  tcpConnecting = false;
+  return true;
+}
+
+void MqttLink::close() {
+  if (socketFd >= 0) {
+    ::close(socketFd);
+  }
+  socketFd = -1;
+  tcpConnecting = false;
+  acknowledged = false;
+}
+
+void MqttLink::publish(std::string_view topic, std::string_view payload) {
+  std::string body;
+  appendString(body, topic);
+  body.append(payload);
+  queuePacket(MQTT_PUBLISH, body);
+}
+
+void MqttLink::ping() {
+  queuePacket(MQTT_PINGREQ, std::string());
+}
+
+bool MqttLink::feed(const char* data, size_t length) {
+  incoming.append(data, length);
+  // Packets are consumed by offset and the buffer trimmed once, so a read
+  // holding hundreds of small PUBLISHes costs no more than one holding one.
+  size_t start = 0;
+  bool ok = true;
+  for (;;) {
+    // Fixed header: type byte plus 1-4 length bytes.
+    size_t remaining = 0;
+    size_t headerLength = 1;
+    int shift = 0;
+    bool complete = false;
+    while (start + headerLength < incoming.size()) {
+      if (headerLength > 4) {
+        return false;  // At most four length bytes
+      }
+      uint8_t digit = static_cast<uint8_t>(incoming[start + headerLength++]);
+      remaining |= static_cast<size_t>(digit & 0x7F) << shift;
+      shift += 7;
+      if ((digit & 0x80) == 0) {
+        complete = true;
+        break;
+      }
+    }
+    if (!complete || incoming.size() < start + headerLength + remaining) {
+      break;  // Wait for the rest
+    }
+
+    uint8_t flags = static_cast<uint8_t>(incoming[start]);
+    uint8_t type = flags & 0xF0;
+    std::string_view body(incoming.data() + start + headerLength, remaining);
+    if (type == MQTT_CONNACK) {
+      if (body.size() < 2 || body[1] != 0) {
+        ok = false;  // Refused
+        break;
+      }
+      acknowledged = true;
+    } else if (type == MQTT_PUBLISH && body.size() >= 2) {
+      size_t topicLength = (static_cast<uint8_t>(body[0]) << 8) | static_cast<uint8_t>(body[1]);
+      size_t offset = 2 + topicLength;
+      if ((flags & 0x06) != 0) {
+        offset += 2;  // QoS > 0 carries a packet identifier; we only subscribe at 0
+      }
+      if (offset <= body.size()) {
+        handler(body.substr(2, topicLength), body.substr(offset));
+      }
+    } else if (type != MQTT_SUBACK && type != MQTT_PINGRESP) {
+      ok = false;
+      break;
+    }
+    start += headerLength + remaining;
+  }
+  incoming.erase(0, start);
+  return ok;
+}
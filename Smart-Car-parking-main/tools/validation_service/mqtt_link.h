@@ -0,0 +1,56 @@
+// Just enough MQTT 3.1.1 for the validation RPC: CONNECT, SUBSCRIBE and
+// QoS 0 PUBLISH/PINGREQ out; CONNACK, SUBACK, PUBLISH and PINGRESP in.
+// Plain TCP only, meant for a broker on the garage LAN (the firmware's
+// -DMQTT_LOCAL_BROKER builds). The socket is driven by the caller's event
+// loop: feed() takes whatever bytes arrived and hands complete PUBLISH
+// packets to the callback.
+#ifndef MQTT_LINK_H
+#define MQTT_LINK_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+class MqttLink {
+ public:
+  using MessageHandler = std::function<void(std::string_view topic, std::string_view payload)>;
+
+  explicit MqttLink(MessageHandler onMessage);
+
+  // Starts a non-blocking TCP connect and queues CONNECT and SUBSCRIBE.
+  // Returns the socket, or -1. While connecting(), the caller waits for the
+  // socket to become writable and calls finishConnect() before sending.
+  int open(const std::string& host, uint16_t port, const std::string& clientId,
+           const std::string& subscribeTopic, uint16_t keepAliveSeconds);
+  // False if the connect failed; the caller closes the link and retries.
+  bool finishConnect();
+  void close();
+  int fd() const { return socketFd; }
+  bool connecting() const { return tcpConnecting; }
+
+  // Bytes received on the socket. Returns false on a protocol error.
+  bool feed(const char* data, size_t length);
+
+  void publish(std::string_view topic, std::string_view payload);
+  void ping();
+
+  // Outgoing bytes not yet written; the caller sends them and calls consumed().
+  const std::string& pending() const { return outgoing; }
+  void consumed(size_t length) { outgoing.erase(0, length); }
+
+  bool connected() const { return acknowledged; }
+
+ private:
+  void queuePacket(uint8_t header, const std::string& body);
+  static void appendString(std::string& out, std::string_view text);
+
+  MessageHandler handler;
+  int socketFd;
+  std::string incoming;
+  std::string outgoing;
+  bool tcpConnecting;
+  bool acknowledged;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "uid_index.h"
+
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+UidIndex::UidIndex(size_t expected) : count(0) {
+  size_t capacity = 16;
+  while (capacity < expected * 2) {
+    capacity *= 2;
+  }
+  slots.assign(capacity, Slot{});
+}
+
+bool UidIndex::normalize(std::string_view uid, char* out, size_t& length) {
+  if (uid.empty() || uid.size() > MAX_KEY) {
+    return false;
+  }
+  for (size_t i = 0; i < uid.size(); i++) {
+    if (!isxdigit(static_cast<unsigned char>(uid[i]))) {
+      return false;
+    }
+    out[i] = static_cast<char>(toupper(static_cast<unsigned char>(uid[i])));
+  }
+  length = uid.size();
+  return true;
+}
+
+// FNV-1a: short keys, no need for anything stronger.
+uint32_t UidIndex::hashKey(const char* key, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ static_cast<uint8_t>(key[i])) * 16777619u;
+  }
+  return hash;
+}
+
+// Index of the slot holding the key, or of the empty slot where it would go.
+size_t UidIndex::find(const char* key, size_t length, uint32_t hash) const {
+  size_t mask = slots.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    const Slot& slot = slots[i];
+    if (slot.length == 0 ||
+        (slot.hash == hash && slot.length == length && memcmp(slot.key, key, length) == 0)) {
+      return i;
+    }
+  }
+}
+
+bool UidIndex::insert(std::string_view uid) {
+  char key[MAX_KEY];
+  size_t length;
+  if (!normalize(uid, key, length)) {
+    return false;
+  }
+  if ((count + 1) * 2 > slots.size()) {
+    grow();
+  }
+  uint32_t hash = hashKey(key, length);
+  Slot& slot = slots[find(key, length, hash)];
+  if (slot.length != 0) {
+    return false;
+  }
+  slot.hash = hash;
+  slot.length = static_cast<uint8_t>(length);
+  memcpy(slot.key, key, length);
+  count++;
+  return true;
+}
+
+bool UidIndex::contains(std::string_view uid) const {
+  char key[MAX_KEY];
+  size_t length;
+  if (!normalize(uid, key, length)) {
+    return false;
+  }
+  return slots[find(key, length, hashKey(key, length))].length != 0;
+}
+
+void UidIndex::grow() {
+  std::vector<Slot> old(slots.size() * 2, Slot{});
+  old.swap(slots);
+  for (const Slot& slot : old) {
+    if (slot.length != 0) {
+      slots[find(slot.key, slot.length, slot.hash)] = slot;
+    }
+  }
+}
+
+bool loadUidCsv(const char* path, UidIndex& index, size_t& loaded, size_t& skipped) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  loaded = 0;
+  skipped = 0;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::string_view field(line);
+    field = field.substr(0, field.find(','));
+    while (!field.empty() && (isspace(static_cast<unsigned char>(field.back())) || field.back() == '"')) {
+      field.remove_suffix(1);
+    }
+    while (!field.empty() && (isspace(static_cast<unsigned char>(field.front())) || field.front() == '"')) {
+      field.remove_prefix(1);
+    }
+    if (field.empty()) {
+      continue;
+    }
+    if (index.insert(field)) {
+      loaded++;
+    } else {
+      skipped++; // Header, malformed or duplicate
+    }
+  }
+  return true;
+}
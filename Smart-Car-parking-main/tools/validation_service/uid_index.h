@@ -0,0 +1,54 @@
+// Open-addressing hash set of card UIDs for the validation service.
+//
+// UIDs are kept exactly as the access sheet stores them and the firmware
+// sends them (upper-case hex, bytes without zero padding), so the index
+// answers the same question the Apps Script did: is this string in the
+// sheet? Keys live inline in one flat array with linear probing; the table
+// doubles whenever it passes half full, so a lookup touches one or two
+// adjacent slots and never allocates.
+#ifndef UID_INDEX_H
+#define UID_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class UidIndex {
+ public:
+  static constexpr size_t MAX_KEY = 20;  // 10 UID bytes in hex
+
+  explicit UidIndex(size_t expected = 1024);
+
+  // Adds a UID. Returns false for a malformed one (empty, too long, not hex)
+  // or a duplicate.
+  bool insert(std::string_view uid);
+  bool contains(std::string_view uid) const;
+
+  size_t size() const { return count; }
+  size_t capacity() const { return slots.size(); }
+
+  // Upper-cases a UID into 'out'; false if it is not 1..MAX_KEY hex digits.
+  static bool normalize(std::string_view uid, char* out, size_t& length);
+
+ private:
+  struct Slot {
+    uint32_t hash;
+    uint8_t length;  // 0 while empty
+    char key[MAX_KEY];
+  };
+
+  static uint32_t hashKey(const char* key, size_t length);
+  size_t find(const char* key, size_t length, uint32_t hash) const;
+  void grow();
+
+  std::vector<Slot> slots;
+  size_t count;
+};
+
+// Loads the first column of a CSV export (one UID per row; a header row or
+// other non-UID rows are skipped and counted in 'skipped'). Returns false if
+// the file cannot be read.
+bool loadUidCsv(const char* path, UidIndex& index, size_t& loaded, size_t& skipped);
+
+#endif
@@ -0,0 +1,258 @@
+// Load generator for validation_service's HTTP side.
+// Keeps N connections each with one request in flight, as N readers would,
+// and reports throughput and latency percentiles. Half the UIDs (by default)
+// come from the CSV the service loaded, the rest are random misses. --close
+// opens a fresh connection per request, which is what the firmware's
+// HTTPClient begin()/GET()/end() does.
+//
+// Build:
+//   g++ -std=c++17 -O2 -Wall -Wextra -o validation_bench validation_bench.cpp uid_index.cpp
+// Usage:
+//   ./validation_bench --csv access.csv [--host 127.0.0.1] [--port 8080]
+//                      [--connections 64] [--requests 200000] [--hits 0.5] [--close]
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "uid_index.h"
+
+namespace {
+
+struct Options {
+  const char* csvPath = nullptr;
+  std::string host = "127.0.0.1";
+  uint16_t port = 8080;
+  int connections = 64;
+  long requests = 200000;
+  double hits = 0.5;
+  bool closeEach = false;
+};
+
+struct Client {
+  int fd = -1;
+  std::string out;
+  std::string in;
+  int64_t sentAtNs = 0;
+  bool expectYes = false;
+};
+
+int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The same rows the service indexes: the first column, when it is a UID.
+std::vector<std::string> readUids(const char* path) {
+  std::vector<std::string> uids;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::string field = line.substr(0, line.find(','));
+    field.erase(std::remove_if(field.begin(), field.end(),
+                               [](char c) { return c == '"' || c == ' ' || c == '\r'; }),
+                field.end());
+    char key[UidIndex::MAX_KEY];
+    size_t length;
+    if (UidIndex::normalize(field, key, length)) {
+      uids.emplace_back(key, length);
+    }
+  }
+  return uids;
+}
+
+int connectTo(const Options& options) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options.port);
+  inet_pton(AF_INET, options.host.c_str(), &address.sin_addr);
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    perror("connect");
+    exit(1);
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+// Length of the first complete response in 'in', or 0 if it is not all here.
+size_t responseLength(const std::string& in, std::string& body) {
+  size_t end = in.find("\r\n\r\n");
+  if (end == std::string::npos) {
+    return 0;
+  }
+  size_t header = in.find("Content-Length:");
+  if (header == std::string::npos || header > end) {
+    return 0;
+  }
+  size_t length = strtoul(in.c_str() + header + 15, nullptr, 10);
+  if (in.size() < end + 4 + length) {
+    return 0;
+  }
+  body = in.substr(end + 4, length);
+  return end + 4 + length;
+}
+
+Options parseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if (flag == "--close") {
+      options.closeEach = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "%s needs a value\n", flag.c_str());
+      exit(2);
+    }
+    const char* value = argv[++i];
+    if (flag == "--csv") {
+      options.csvPath = value;
+    } else if (flag == "--host") {
+      options.host = value;
+    } else if (flag == "--port") {
+      options.port = static_cast<uint16_t>(atoi(value));
+    } else if (flag == "--connections") {
+      options.connections = atoi(value);
+    } else if (flag == "--requests") {
+      options.requests = atol(value);
+    } else if (flag == "--hits") {
+      options.hits = atof(value);
+    } else {
+      fprintf(stderr, "unknown option %s\n", flag.c_str());
+      exit(2);
+    }
+  }
+  if (options.csvPath == nullptr || options.connections < 1) {
+    fprintf(stderr, "usage: %s --csv access.csv [--host h] [--port p] [--connections n] "
+                    "[--requests n] [--hits 0..1] [--close]\n", argv[0]);
+    exit(2);
+  }
+  return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options = parseOptions(argc, argv);
+  std::vector<std::string> known = readUids(options.csvPath);
+  if (known.empty()) {
+    fprintf(stderr, "no UIDs in %s\n", options.csvPath);
+    return 1;
+  }
+
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<double> coin(0.0, 1.0);
+  // Misses are 14 hex digits (7-byte UIDs); the service sees them as strangers
+  // unless the CSV happens to hold the same one.
+  auto nextRequest = [&](Client& client) {
+    std::string uid;
+    client.expectYes = coin(random) < options.hits;
+    if (client.expectYes) {
+      uid = known[random() % known.size()];
+    } else {
+      char text[16];
+      snprintf(text, sizeof(text), "%014llX", (unsigned long long)(random() & 0xFFFFFFFFFFFFFFull));
+      uid = text;
+    }
+    client.out = "GET /exec?uid=" + uid + " HTTP/1.1\r\nHost: " + options.host +
+                 (options.closeEach ? "\r\nConnection: close\r\n\r\n" : "\r\n\r\n");
+    client.sentAtNs = nowNs();
+  };
+
+  int epollFd = epoll_create1(0);
+  std::vector<Client> clients(options.connections);
+  auto start = [&](int i) {
+    Client& client = clients[i];
+    if (client.fd < 0) {
+      client.fd = connectTo(options);
+      epoll_event event{};
+      event.events = EPOLLIN;
+      event.data.u32 = i;
+      epoll_ctl(epollFd, EPOLL_CTL_ADD, client.fd, &event);
+    }
+    nextRequest(client);
+    ssize_t sent = send(client.fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+    if (sent != static_cast<ssize_t>(client.out.size())) {
+      fprintf(stderr, "short send\n");  // A request is far below one socket buffer
+      exit(1);
+    }
+  };
+
+  std::vector<int64_t> latencies;
+  latencies.reserve(options.requests);
+  long issued = 0;
+  long mismatches = 0;
+  int64_t began = nowNs();
+  for (int i = 0; i < options.connections && issued < options.requests; i++, issued++) {
+    start(i);
+  }
+
+  epoll_event events[256];
+  char buffer[16384];
+  while (static_cast<long>(latencies.size()) < issued) {
+    int ready = epoll_wait(epollFd, events, 256, 5000);
+    if (ready == 0) {
+      fprintf(stderr, "no response for 5 s\n");
+      return 1;
+    }
+    for (int e = 0; e < ready; e++) {
+      Client& client = clients[events[e].data.u32];
+      ssize_t received;
+      while ((received = recv(client.fd, buffer, sizeof(buffer), 0)) > 0) {
+        client.in.append(buffer, received);
+      }
+      std::string body;
+      size_t length = responseLength(client.in, body);
+      if (length == 0) {
+        if (received == 0) {
+          fprintf(stderr, "server closed a connection mid-response\n");
+          return 1;
+        }
+        continue;
+      }
+      latencies.push_back(nowNs() - client.sentAtNs);
+      if ((body == "yes") != client.expectYes) {
+        mismatches++;
+      }
+      client.in.erase(0, length);
+      if (options.closeEach) {
+        close(client.fd);
+        client.fd = -1;
+      }
+      if (issued < options.requests) {
+        start(events[e].data.u32);
+        issued++;
+      }
+    }
+  }
+  double seconds = (nowNs() - began) / 1e9;
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))] / 1000.0;
+  };
+  printf("%zu requests over %d %s connections in %.2f s\n", latencies.size(), options.connections,
+         options.closeEach ? "per-request" : "keep-alive", seconds);
+  printf("%.0f req/s  p50 %.1f us  p99 %.1f us  max %.1f us  wrong answers %ld\n",
+         latencies.size() / seconds, percentile(0.50), percentile(0.99), latencies.back() / 1000.0,
+         mismatches);
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,460 @@
+// Card Validation Service
+// A self-hosted stand-in for the Google Apps Script behind GOOGLE_SCRIPT_URL,
+// for a box in the garage. It answers the same contract from an in-memory
+// index of the UIDs in a CSV export of the access sheet:
+//
+//   HTTP      GET <any path>?uid=4A3B2C1D  ->  200 "yes" | "no"
+//             Build the controller with
+//             -DGOOGLE_SCRIPT_DEPLOYMENT_URL=\"http://<box>:<port>/exec\"
+//   MQTT RPC  {"id":1234,"uid":"4A3B2C1D","reader":"entry","replyTo":"<topic>"}
+//             on parking/esp32/validate  ->  {"id":1234,"allow":true} on replyTo
+//             For controllers built with -DRFID_VALIDATION_RPC and a LAN broker
+//
+// One thread, one epoll loop: the listening socket, every HTTP connection
+// (keep-alive and pipelining are fine), the broker link and a signalfd.
+// SIGHUP reloads the CSV; SIGINT/SIGTERM print the counters and exit.
+//
+// Build (Linux, no dependencies):
+//   g++ -std=c++17 -O2 -Wall -Wextra -o validation_service validation_service.cpp uid_index.cpp mqtt_link.cpp
+// Usage:
+//   ./validation_service --csv access.csv [--port 8080] [--mqtt 192.168.1.10[:1883]]
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "mqtt_link.h"
+#include "uid_index.h"
+
+namespace {
+
+// --- Configuration ---
+const char* VALIDATE_TOPIC = "parking/esp32/validate";
+const uint16_t MQTT_KEEPALIVE_S = 60;
+const int MQTT_RETRY_S = 5;
+const int MQTT_CONNECT_TIMEOUT_S = 5;
+const size_t MAX_REQUEST_BYTES = 8192;  // Per connection, unanswered
+
+struct Options {
+  const char* csvPath = nullptr;
+  uint16_t httpPort = 8080;
+  std::string mqttHost;
+  uint16_t mqttPort = 1883;
+};
+
+struct Counters {
+  uint64_t httpRequests = 0;
+  uint64_t rpcRequests = 0;
+  uint64_t granted = 0;
+  uint64_t denied = 0;
+  uint64_t badRequests = 0;
+  uint64_t connections = 0;
+};
+
+struct Connection {
+  std::string in;
+  std::string out;
+  bool closeWhenSent = false;
+};
+
+std::unique_ptr<UidIndex> uidIndex;
+Counters counters;
+
+int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool loadIndex(const char* path) {
+  auto fresh = std::make_unique<UidIndex>();
+  size_t loaded = 0;
+  size_t skipped = 0;
+  if (!loadUidCsv(path, *fresh, loaded, skipped)) {
+    fprintf(stderr, "cannot read %s\n", path);
+    return false;
+  }
+  uidIndex = std::move(fresh);
+  printf("loaded %zu UIDs from %s (%zu rows skipped), %zu slots\n", loaded, path, skipped,
+         uidIndex->capacity());
+  return true;
+}
+
+bool validate(std::string_view uid) {
+  bool allowed = uidIndex->contains(uid);
+  (allowed ? counters.granted : counters.denied)++;
+  return allowed;
+}
+
+// --- HTTP ---
+
+// Value of a query parameter in a request target, or an empty view.
+std::string_view queryParameter(std::string_view target, std::string_view name) {
+  size_t query = target.find('?');
+  while (query != std::string_view::npos) {
+    std::string_view rest = target.substr(query + 1);
+    if (rest.substr(0, name.size()) == name && rest.size() > name.size() && rest[name.size()] == '=') {
+      rest = rest.substr(name.size() + 1);
+      return rest.substr(0, rest.find('&'));
+    }
+    query = target.find('&', query + 1);
+  }
+  return std::string_view();
+}
+
+bool headerSays(std::string_view headers, std::string_view name, std::string_view value) {
+  for (size_t at = 0; at < headers.size();) {
+    size_t end = headers.find("\r\n", at);
+    std::string_view line = headers.substr(at, end == std::string_view::npos ? end : end - at);
+    if (line.size() > name.size() && strncasecmp(line.data(), name.data(), name.size()) == 0 &&
+        line[name.size()] == ':') {
+      std::string_view rest = line.substr(name.size() + 1);
+      for (size_t i = 0; i + value.size() <= rest.size(); i++) {
+        if (strncasecmp(rest.data() + i, value.data(), value.size()) == 0) {
+          return true;
+        }
+      }
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+    at = end + 2;
+  }
+  return false;
+}
+
+void respond(Connection& connection, int status, const char* reason, std::string_view body) {
+  char head[160];
+  int length = snprintf(head, sizeof(head),
+                        "HTTP/1.1 %d %s\r\nContent-Type: text/plain\r\nContent-Length: %zu\r\n%s\r\n",
+                        status, reason, body.size(),
+                        connection.closeWhenSent ? "Connection: close\r\n" : "");
+  connection.out.append(head, length);
+  connection.out.append(body);
+}
+
+// Answers every complete request in the buffer. Returns false to drop the
+// connection.
+bool serveRequests(Connection& connection) {
+  for (;;) {
+    size_t end = connection.in.find("\r\n\r\n");
+    if (end == std::string::npos) {
+      return connection.in.size() <= MAX_REQUEST_BYTES;
+    }
+    std::string_view request(connection.in.data(), end + 2);
+    size_t lineEnd = request.find("\r\n");
+    std::string_view line = request.substr(0, lineEnd);
+    std::string_view headers = request.substr(lineEnd + 2);
+
+    size_t firstSpace = line.find(' ');
+    size_t secondSpace = line.find(' ', firstSpace + 1);
+    std::string_view method = line.substr(0, firstSpace);
+    std::string_view target = firstSpace == std::string_view::npos || secondSpace == std::string_view::npos
+                                  ? std::string_view()
+                                  : line.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+    std::string_view version = secondSpace == std::string_view::npos ? std::string_view()
+                                                                      : line.substr(secondSpace + 1);
+    connection.closeWhenSent = headerSays(headers, "Connection", "close") ||
+                               (version == "HTTP/1.0" && !headerSays(headers, "Connection", "keep-alive"));
+
+    std::string_view uid = queryParameter(target, "uid");
+    if (method != "GET" || uid.empty()) {
+      counters.badRequests++;
+      connection.closeWhenSent = true;
+      respond(connection, 400, "Bad Request", "expected GET ?uid=<hex>");
+    } else {
+      counters.httpRequests++;
+      respond(connection, 200, "OK", validate(uid) ? "yes" : "no");
+    }
+    connection.in.erase(0, end + 4);
+    if (connection.closeWhenSent) {
+      connection.in.clear();
+      return true;
+    }
+  }
+}
+
+// --- MQTT RPC ---
+
+// The firmware's requests are flat ArduinoJson output, so a field lookup by
+// name is enough; values never contain quotes.
+std::string_view jsonField(std::string_view json, std::string_view name) {
+  std::string key = "\"" + std::string(name) + "\":";
+  size_t at = json.find(key);
+  if (at == std::string_view::npos) {
+    return std::string_view();
+  }
+  std::string_view value = json.substr(at + key.size());
+  if (!value.empty() && value[0] == '"') {
+    value.remove_prefix(1);
+    return value.substr(0, value.find('"'));
+  }
+  return value.substr(0, value.find_first_of(",}"));
+}
+
+void answerRpc(MqttLink& link, std::string_view payload) {
+  std::string_view id = jsonField(payload, "id");
+  std::string_view uid = jsonField(payload, "uid");
+  std::string_view replyTo = jsonField(payload, "replyTo");
+  if (id.empty() || uid.empty() || replyTo.empty()) {
+    counters.badRequests++;
+    return;
+  }
+  counters.rpcRequests++;
+  std::string reply = "{\"id\":" + std::string(id) + ",\"allow\":" + (validate(uid) ? "true" : "false") + "}";
+  link.publish(replyTo, reply);
+}
+
+// --- Event Loop ---
+
+int listenOn(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 512) != 0) {
+    perror("listen");
+    exit(1);
+  }
+  return fd;
+}
+
+// Writes as much as the socket takes; waits for EPOLLOUT only when it is full.
+bool flush(int epollFd, int fd, std::string& out, bool& waitingForOut) {
+  while (!out.empty()) {
+    ssize_t sent = send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      return false;
+    }
+    out.erase(0, sent);
+  }
+  bool wantOut = !out.empty();
+  if (wantOut != waitingForOut) {
+    epoll_event event{};
+    event.events = EPOLLIN | (wantOut ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    event.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+    waitingForOut = wantOut;
+  }
+  return true;
+}
+
+void addToEpoll(int epollFd, int fd, uint32_t events = EPOLLIN) {
+  epoll_event event{};
+  event.events = events;
+  event.data.fd = fd;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+}
+
+Options parseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string flag = argv[i];
+    if (flag == "--csv") {
+      options.csvPath = argv[i + 1];
+    } else if (flag == "--port") {
+      options.httpPort = static_cast<uint16_t>(atoi(argv[i + 1]));
+    } else if (flag == "--mqtt") {
+      std::string broker = argv[i + 1];
+      size_t colon = broker.find(':');
+      options.mqttHost = broker.substr(0, colon);
+      if (colon != std::string::npos) {
+        options.mqttPort = static_cast<uint16_t>(atoi(broker.c_str() + colon + 1));
+      }
+    } else {
+      fprintf(stderr, "unknown option %s\n", flag.c_str());
+      exit(2);
+    }
+  }
+  if (options.csvPath == nullptr) {
+    fprintf(stderr, "usage: %s --csv access.csv [--port 8080] [--mqtt host[:1883]]\n", argv[0]);
+    exit(2);
+  }
+  return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  setvbuf(stdout, nullptr, _IOLBF, 0);  // Log lines reach journald as they happen
+  Options options = parseOptions(argc, argv);
+  if (!loadIndex(options.csvPath)) {
+    return 1;
+  }
+
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGHUP);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  sigprocmask(SIG_BLOCK, &signals, nullptr);
+  int signalFd = signalfd(-1, &signals, SFD_NONBLOCK);
+
+  int epollFd = epoll_create1(0);
+  int listenFd = listenOn(options.httpPort);
+  addToEpoll(epollFd, listenFd);
+  addToEpoll(epollFd, signalFd);
+  printf("HTTP on port %u\n", options.httpPort);
+
+  MqttLink mqtt([&](std::string_view topic, std::string_view payload) {
+    if (topic == VALIDATE_TOPIC) {
+      answerRpc(mqtt, payload);
+    }
+  });
+  bool mqttWaitingForOut = false;
+  int64_t mqttRetryAt = 0;
+  int64_t mqttConnectBy = 0;
+  int64_t mqttPingAt = 0;
+
+  std::unordered_map<int, Connection> connections;
+  std::unordered_map<int, bool> waitingForOut;
+  epoll_event events[256];
+  char buffer[16384];
+
+  for (;;) {
+    int64_t now = nowMs();
+    if (!options.mqttHost.empty() && mqtt.fd() < 0 && now >= mqttRetryAt) {
+      std::string clientId = "validation-service-" + std::to_string(getpid());
+      if (mqtt.open(options.mqttHost, options.mqttPort, clientId, VALIDATE_TOPIC, MQTT_KEEPALIVE_S) >= 0) {
+        // Writable once the connect is over, either way
+        addToEpoll(epollFd, mqtt.fd(), EPOLLIN | EPOLLOUT);
+        mqttWaitingForOut = true;
+        mqttConnectBy = now + MQTT_CONNECT_TIMEOUT_S * 1000;
+        mqttPingAt = now + MQTT_KEEPALIVE_S * 1000 / 2;
+      } else {
+        mqttRetryAt = now + MQTT_RETRY_S * 1000;
+      }
+    }
+    if (mqtt.connecting() && now >= mqttConnectBy) {
+      printf("MQTT: no answer from %s:%u, retrying in %d s\n", options.mqttHost.c_str(), options.mqttPort,
+             MQTT_RETRY_S);
+      mqtt.close();
+      mqttRetryAt = now + MQTT_RETRY_S * 1000;
+    }
+    if (mqtt.fd() >= 0 && !mqtt.connecting() && now >= mqttPingAt) {
+      mqtt.ping();
+      mqttPingAt = now + MQTT_KEEPALIVE_S * 1000 / 2;
+    }
+    if (mqtt.fd() >= 0 && !mqtt.connecting()) {
+      std::string out = mqtt.pending();
+      bool ok = flush(epollFd, mqtt.fd(), out, mqttWaitingForOut);
+      mqtt.consumed(mqtt.pending().size() - out.size());
+      if (!ok) {
+        mqtt.close();
+        mqttRetryAt = now + MQTT_RETRY_S * 1000;
+      }
+    }
+
+    int timeoutMs = options.mqttHost.empty() ? -1 : 1000;
+    int ready = epoll_wait(epollFd, events, 256, timeoutMs);
+    for (int e = 0; e < ready; e++) {
+      int fd = events[e].data.fd;
+
+      if (fd == listenFd) {
+        for (;;) {
+          int client = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+          if (client < 0) {
+            break;
+          }
+          int one = 1;
+          setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+          addToEpoll(epollFd, client);
+          connections[client] = Connection();
+          waitingForOut[client] = false;
+          counters.connections++;
+        }
+        continue;
+      }
+
+      if (fd == signalFd) {
+        signalfd_siginfo info;
+        while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+          if (info.ssi_signo == SIGHUP) {
+            loadIndex(options.csvPath);  // Keeps the old index if the file is unreadable
+            continue;
+          }
+          printf("connections %llu, http %llu, rpc %llu, granted %llu, denied %llu, bad %llu\n",
+                 (unsigned long long)counters.connections, (unsigned long long)counters.httpRequests,
+                 (unsigned long long)counters.rpcRequests, (unsigned long long)counters.granted,
+                 (unsigned long long)counters.denied, (unsigned long long)counters.badRequests);
+          return 0;
+        }
+        continue;
+      }
+
+      if (fd == mqtt.fd()) {
+        bool ok = true;
+        if (mqtt.connecting()) {
+          ok = mqtt.finishConnect();
+          if (ok) {
+            printf("MQTT: connected to %s:%u, serving %s\n", options.mqttHost.c_str(), options.mqttPort,
+                   VALIDATE_TOPIC);
+          }
+        } else if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+          ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+          ok = received > 0 && mqtt.feed(buffer, received);
+        }
+        if (ok) {
+          std::string out = mqtt.pending();
+          ok = flush(epollFd, fd, out, mqttWaitingForOut);
+          mqtt.consumed(mqtt.pending().size() - out.size());
+        }
+        if (!ok) {
+          printf(mqtt.connecting() ? "MQTT: connect failed, retrying in %d s\n" : "MQTT: link lost, retrying in %d s\n",
+                 MQTT_RETRY_S);
+          mqtt.close();
+          mqttRetryAt = nowMs() + MQTT_RETRY_S * 1000;
+        }
+        continue;
+      }
+
+      auto found = connections.find(fd);
+      if (found == connections.end()) {
+        continue;
+      }
+      Connection& connection = found->second;
+      bool keep = true;
+      if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        ssize_t received;
+        while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+          connection.in.append(buffer, received);
+        }
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+          keep = false;
+        } else {
+          keep = serveRequests(connection);
+        }
+      }
+      if (keep) {
+        keep = flush(epollFd, fd, connection.out, waitingForOut[fd]) &&
+               !(connection.closeWhenSent && connection.out.empty());
+      }
+      if (!keep) {
+        close(fd);  // Also drops it from the epoll set
+        connections.erase(fd);
+        waitingForOut.erase(fd);
+      }
+    }
+  }
+}